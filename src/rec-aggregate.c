@@ -44,6 +44,10 @@ struct rec_aggregate_reg_elem_s
 {
   char *name;
   rec_aggregate_t function;
+
+  /* Incremental implementation of the aggregate, if any.  */
+  bool incr_p;
+  rec_aggregate_incr_t incr;
 };
 
 struct rec_aggregate_reg_s
@@ -54,33 +58,67 @@ struct rec_aggregate_reg_s
 
 /* Static functions defined in this file.  */
 
+static bool rec_aggregate_reg_add_1 (rec_aggregate_reg_t func_reg,
+                                     const char *name,
+                                     rec_aggregate_t function,
+                                     const rec_aggregate_incr_t *incr);
+
 static char *rec_aggregate_std_count (rec_rset_t rset,
                                       rec_record_t record,
                                       const char *field_name);
+static bool rec_aggregate_std_count_init (rec_aggregate_state_t *state);
+static bool rec_aggregate_std_count_accumulate (rec_aggregate_state_t *state,
+                                                rec_record_t record,
+                                                const char *field_name);
+static bool rec_aggregate_std_count_merge (rec_aggregate_state_t *state,
+                                           rec_aggregate_state_t *other);
+static char *rec_aggregate_std_count_finalize (rec_aggregate_state_t *state);
 
 static char *rec_aggregate_std_avg (rec_rset_t rset,
                                     rec_record_t record,
                                     const char *field_name);
-static double rec_aggregate_std_avg_record (rec_record_t record,
-                                            const char *field_name);
+static bool rec_aggregate_std_avg_init (rec_aggregate_state_t *state);
+static bool rec_aggregate_std_avg_accumulate (rec_aggregate_state_t *state,
+                                              rec_record_t record,
+                                              const char *field_name);
+static bool rec_aggregate_std_avg_merge (rec_aggregate_state_t *state,
+                                         rec_aggregate_state_t *other);
+static char *rec_aggregate_std_avg_finalize (rec_aggregate_state_t *state);
 
 static char *rec_aggregate_std_sum (rec_rset_t rset,
                                     rec_record_t record,
                                     const char *field_name);
-static double rec_aggregate_std_sum_record (rec_record_t record,
-                                            const char *field_name);
+static bool rec_aggregate_std_sum_init (rec_aggregate_state_t *state);
+static bool rec_aggregate_std_sum_accumulate (rec_aggregate_state_t *state,
+                                              rec_record_t record,
+                                              const char *field_name);
+static bool rec_aggregate_std_sum_merge (rec_aggregate_state_t *state,
+                                         rec_aggregate_state_t *other);
+static char *rec_aggregate_std_sum_finalize (rec_aggregate_state_t *state);
 
 static char *rec_aggregate_std_min (rec_rset_t rset,
                                     rec_record_t record,
                                     const char *field_name);
-static double rec_aggregate_std_min_record (rec_record_t record,
-                                            const char *field_name);
+static bool rec_aggregate_std_min_init (rec_aggregate_state_t *state);
+static bool rec_aggregate_std_min_accumulate (rec_aggregate_state_t *state,
+                                              rec_record_t record,
+                                              const char *field_name);
+static bool rec_aggregate_std_min_merge (rec_aggregate_state_t *state,
+                                         rec_aggregate_state_t *other);
+static char *rec_aggregate_std_min_finalize (rec_aggregate_state_t *state);
 
 static char *rec_aggregate_std_max (rec_rset_t rset,
                                     rec_record_t record,
                                     const char *field_name);
-static double rec_aggregate_std_max_record (rec_record_t record,
-                                            const char *field_name);
+static bool rec_aggregate_std_max_init (rec_aggregate_state_t *state);
+static bool rec_aggregate_std_max_accumulate (rec_aggregate_state_t *state,
+                                              rec_record_t record,
+                                              const char *field_name);
+static bool rec_aggregate_std_max_merge (rec_aggregate_state_t *state,
+                                         rec_aggregate_state_t *other);
+static char *rec_aggregate_std_max_finalize (rec_aggregate_state_t *state);
+
+static char *rec_aggregate_std_num_str (double val);
 
 /*
  * Static structure containing the descriptors of the standard
@@ -94,16 +132,24 @@ struct rec_aggregate_descriptor_s
 {
   const char *name;
   rec_aggregate_t func;
+  rec_aggregate_incr_t incr;
 };
 
 #define NUM_STD_AGGREGATES 5
 
+#define REC_AGGREGATE_STD_DESCRIPTOR(NAME)                              \
+  {#NAME, &rec_aggregate_std_##NAME,                                    \
+   {&rec_aggregate_std_##NAME##_init,                                   \
+    &rec_aggregate_std_##NAME##_accumulate,                             \
+    &rec_aggregate_std_##NAME##_merge,                                  \
+    &rec_aggregate_std_##NAME##_finalize}}
+
 static struct rec_aggregate_descriptor_s std_aggregates[] =
-  {{"count", &rec_aggregate_std_count},
-   {"avg",   &rec_aggregate_std_avg},
-   {"sum",   &rec_aggregate_std_sum},
-   {"min",   &rec_aggregate_std_min},
-   {"max",   &rec_aggregate_std_max}};
+  {REC_AGGREGATE_STD_DESCRIPTOR(count),
+   REC_AGGREGATE_STD_DESCRIPTOR(avg),
+   REC_AGGREGATE_STD_DESCRIPTOR(sum),
+   REC_AGGREGATE_STD_DESCRIPTOR(min),
+   REC_AGGREGATE_STD_DESCRIPTOR(max)};
 
 /*
  * Public functions.
@@ -143,50 +189,51 @@ rec_aggregate_reg_add (rec_aggregate_reg_t func_reg,
                        const char *name,
                        rec_aggregate_t function)
 {
-  bool function_replaced = false;
+  return rec_aggregate_reg_add_1 (func_reg, name, function, NULL);
+}
+
+bool
+rec_aggregate_reg_add_incr (rec_aggregate_reg_t func_reg,
+                            const char *name,
+                            const rec_aggregate_incr_t *incr)
+{
+  return rec_aggregate_reg_add_1 (func_reg, name, NULL, incr);
+}
+
+rec_aggregate_t
+rec_aggregate_reg_get (rec_aggregate_reg_t func_reg,
+                       const char *name)
+{
   size_t i = 0;
+  rec_aggregate_t res = NULL;
 
   for (i = 0; i < func_reg->num_functions; i++)
     {
-      if (strcmp (name, func_reg->functions[i].name) == 0)
+      if (strcasecmp (func_reg->functions[i].name, name) == 0)
         {
-          /* Replace the existing function.  */
-          func_reg->functions[i].function = function;
-          function_replaced = true;
+          res = func_reg->functions[i].function;
           break;
         }
     }
 
-  if (!function_replaced)
-    {
-      /* Insert the function into a new entry in the registry.  */
-
-      if (func_reg->num_functions == MAX_FUNCTIONS)
-        {
-          /* FIXME: this is crappy as hell.  */
-          return false;
-        }
-
-      func_reg->functions[func_reg->num_functions].name = strdup (name);
-      func_reg->functions[func_reg->num_functions].function = function;
-      func_reg->num_functions++;
-    }
-
-  return true;
+  return res;
 }
 
-rec_aggregate_t
-rec_aggregate_reg_get (rec_aggregate_reg_t func_reg,
-                       const char *name)
+const rec_aggregate_incr_t *
+rec_aggregate_reg_get_incr (rec_aggregate_reg_t func_reg,
+                            const char *name)
 {
   size_t i = 0;
-  rec_aggregate_t res = NULL;
+  const rec_aggregate_incr_t *res = NULL;
 
   for (i = 0; i < func_reg->num_functions; i++)
     {
       if (strcasecmp (func_reg->functions[i].name, name) == 0)
         {
-          res = func_reg->functions[i].function;
+          if (func_reg->functions[i].incr_p)
+            {
+              res = &func_reg->functions[i].incr;
+            }
           break;
         }
     }
@@ -201,8 +248,57 @@ rec_aggregate_reg_add_standard (rec_aggregate_reg_t func_reg)
 
   for (i = 0; i < NUM_STD_AGGREGATES; i++)
     {
-      rec_aggregate_reg_add (func_reg, std_aggregates[i].name, std_aggregates[i].func);
+      rec_aggregate_reg_add_1 (func_reg,
+                               std_aggregates[i].name,
+                               std_aggregates[i].func,
+                               &std_aggregates[i].incr);
+    }
+}
+
+char *
+rec_aggregate_incr_apply (const rec_aggregate_incr_t *incr,
+                          rec_rset_t rset,
+                          rec_record_t record,
+                          const char *field_name)
+{
+  rec_aggregate_state_t state;
+  bool accumulated = true;
+
+  if (!incr->init (&state))
+    {
+      /* Out of memory.  */
+      return NULL;
+    }
+
+  if (record)
+    {
+      accumulated = incr->accumulate (&state, record, field_name);
+    }
+  else if (rset)
+    {
+      rec_record_t rec = NULL;
+      rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
+      while (rec_mset_iterator_next (&iter, MSET_RECORD, (void *) &rec, NULL))
+        {
+          if (!incr->accumulate (&state, rec, field_name))
+            {
+              accumulated = false;
+              break;
+            }
+        }
+      rec_mset_iterator_free (&iter);
+    }
+
+  if (!accumulated)
+    {
+      /* Out of memory.  Finalize the state anyway so the resources
+         used by the aggregate get freed.  */
+
+      free (incr->finalize (&state));
+      return NULL;
     }
+
+  return incr->finalize (&state);
 }
 
 bool
@@ -227,86 +323,166 @@ rec_aggregate_std_p (const char *name)
  * Private functions.
  */
 
-static char *
-rec_aggregate_std_count (rec_rset_t rset,
-                         rec_record_t record,
-                         const char *field_name)
+static bool
+rec_aggregate_reg_add_1 (rec_aggregate_reg_t func_reg,
+                         const char *name,
+                         rec_aggregate_t function,
+                         const rec_aggregate_incr_t *incr)
 {
-  char *result = NULL;
-  size_t count = 0;
+  struct rec_aggregate_reg_elem_s *elem = NULL;
+  size_t i = 0;
 
-  if (record)
+  for (i = 0; i < func_reg->num_functions; i++)
     {
-      count = rec_record_get_num_fields_by_name (record, field_name);
+      if (strcmp (name, func_reg->functions[i].name) == 0)
+        {
+          /* Replace the existing function.  */
+          elem = &func_reg->functions[i];
+          break;
+        }
     }
-  else if (rset)
+
+  if (!elem)
     {
-      rec_record_t rec = NULL;
-      rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
-      while (rec_mset_iterator_next (&iter, MSET_RECORD, (void *) &rec, NULL))
+      /* Insert the function into a new entry in the registry.  */
+
+      if (func_reg->num_functions == MAX_FUNCTIONS)
         {
-          count = count + rec_record_get_num_fields_by_name (rec, field_name);
+          /* FIXME: this is crappy as hell.  */
+          return false;
         }
-      rec_mset_iterator_free (&iter);
+
+      elem = &func_reg->functions[func_reg->num_functions];
+      elem->name = strdup (name);
+      if (!elem->name)
+        {
+          /* Out of memory.  */
+          return false;
+        }
+
+      func_reg->num_functions++;
     }
 
-  /* Return the count as a string.  Note that if NULL is returned it
-     will be returned by this function below to signal the
-     end-of-memory condition.  */
-      
-  asprintf (&result, "%zu", count);
-  return result;
+  elem->function = function;
+  elem->incr_p = (incr != NULL);
+  if (incr)
+    {
+      elem->incr = *incr;
+    }
+
+  return true;
 }
 
 static char *
-rec_aggregate_std_avg (rec_rset_t rset,
-                       rec_record_t record,
-                       const char *field_name)
+rec_aggregate_std_num_str (double val)
 {
   char *result = NULL;
-  double avg = 0;
 
-  if (record)
-    {
-      avg = rec_aggregate_std_avg_record (record, field_name);
-    }
-  else if (rset)
-    {
-      size_t num_records = 0;
-      rec_record_t rec = NULL;
-      rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
-      while (rec_mset_iterator_next (&iter, MSET_RECORD, (void *) &rec, NULL))
-        {
-          avg = avg + rec_aggregate_std_avg_record (rec, field_name);
-          num_records++;
-        }
-      rec_mset_iterator_free (&iter);
+  /* Return the val as a string.  Note that if NULL is returned it
+     will be returned by the aggregate to signal the end-of-memory
+     condition.  */
 
-      if (num_records != 0)
-        {
-          avg = avg / num_records;
-        }
-    }
+  if (val == floor (val))
+    asprintf (&result, "%zd", (size_t) val);
+  else
+    asprintf (&result, "%f", val);
 
-  /* Return the average as a string.  Note that if NULL is returned it
+  return result;
+}
+
+/* Define the non-incremental version of a standard aggregate in terms
+   of its incremental implementation.  */
+
+#define REC_AGGREGATE_STD_FUNC(NAME)                                    \
+  static char *                                                         \
+  rec_aggregate_std_##NAME (rec_rset_t rset,                            \
+                            rec_record_t record,                        \
+                            const char *field_name)                     \
+  {                                                                     \
+    return rec_aggregate_incr_apply (&std_aggregates[REC_AGGREGATE_STD_##NAME].incr, \
+                                     rset, record, field_name);         \
+  }
+
+/* Indexes of the standard aggregates in std_aggregates.  */
+
+enum
+  {
+    REC_AGGREGATE_STD_count = 0,
+    REC_AGGREGATE_STD_avg,
+    REC_AGGREGATE_STD_sum,
+    REC_AGGREGATE_STD_min,
+    REC_AGGREGATE_STD_max
+  };
+
+/*
+ * Aggregate: Count(Field)
+ */
+
+REC_AGGREGATE_STD_FUNC(count);
+
+static bool
+rec_aggregate_std_count_init (rec_aggregate_state_t *state)
+{
+  state->count = 0;
+  state->num = 0;
+  state->data = NULL;
+  return true;
+}
+
+static bool
+rec_aggregate_std_count_accumulate (rec_aggregate_state_t *state,
+                                    rec_record_t record,
+                                    const char *field_name)
+{
+  state->count = state->count
+    + rec_record_get_num_fields_by_name (record, field_name);
+  return true;
+}
+
+static bool
+rec_aggregate_std_count_merge (rec_aggregate_state_t *state,
+                               rec_aggregate_state_t *other)
+{
+  state->count = state->count + other->count;
+  return true;
+}
+
+static char *
+rec_aggregate_std_count_finalize (rec_aggregate_state_t *state)
+{
+  char *result = NULL;
+
+  /* Return the count as a string.  Note that if NULL is returned it
      will be returned by this function below to signal the
      end-of-memory condition.  */
-      
-  if (avg == floor (avg))
-    {
-      asprintf (&result, "%zu", (size_t) avg);
-    }
-  else
-    {
-      asprintf (&result, "%f", avg);
-    }
 
+  asprintf (&result, "%zu", state->count);
   return result;
 }
 
-static double
-rec_aggregate_std_avg_record (rec_record_t record,
-                              const char *field_name)
+/*
+ * Aggregate: Avg(Field)
+ *
+ * The average of a record set is the average of the averages of the
+ * fields in its records.  STATE->num accumulates the averages of the
+ * records and STATE->count the number of accumulated records.
+ */
+
+REC_AGGREGATE_STD_FUNC(avg);
+
+static bool
+rec_aggregate_std_avg_init (rec_aggregate_state_t *state)
+{
+  state->count = 0;
+  state->num = 0;
+  state->data = NULL;
+  return true;
+}
+
+static bool
+rec_aggregate_std_avg_accumulate (rec_aggregate_state_t *state,
+                                  rec_record_t record,
+                                  const char *field_name)
 {
   double avg = 0;
   rec_field_t field;
@@ -332,70 +508,102 @@ rec_aggregate_std_avg_record (rec_record_t record,
       avg = avg / num_fields;
     }
 
-  return avg;
+  state->num = state->num + avg;
+  state->count++;
+
+  return true;
+}
+
+static bool
+rec_aggregate_std_avg_merge (rec_aggregate_state_t *state,
+                             rec_aggregate_state_t *other)
+{
+  state->num = state->num + other->num;
+  state->count = state->count + other->count;
+  return true;
+}
+
+static char *
+rec_aggregate_std_avg_finalize (rec_aggregate_state_t *state)
+{
+  char *result = NULL;
+  double avg = state->num;
+
+  if (state->count != 0)
+    {
+      avg = avg / state->count;
+    }
+
+  /* Return the average as a string.  Note that if NULL is returned it
+     will be returned by this function below to signal the
+     end-of-memory condition.  */
+      
+  if (avg == floor (avg))
+    {
+      asprintf (&result, "%zu", (size_t) avg);
+    }
+  else
+    {
+      asprintf (&result, "%f", avg);
+    }
+
+  return result;
 }
 
+/* Define an incremental aggregate that folds the values of the
+   fields using the binary operation OP, starting with INIT_VAL.
+   Fields not representing a real value are ignored.  */
+
 #define REC_AGGREGATE_ACCUM_FUNC(NAME, OP, INIT_VAL)                    \
-  static char *                                                         \
-  rec_aggregate_std_##NAME (rec_rset_t rset,                            \
-                            rec_record_t record,                        \
-                            const char *field_name)                     \
+  REC_AGGREGATE_STD_FUNC(NAME);                                         \
+                                                                        \
+  static bool                                                           \
+  rec_aggregate_std_##NAME##_init (rec_aggregate_state_t *state)        \
   {                                                                     \
-  char *result = NULL;                                                  \
-  double val   = INIT_VAL;                                              \
+    state->count = 0;                                                   \
+    state->num = INIT_VAL;                                              \
+    state->data = NULL;                                                 \
+    return true;                                                        \
+  }                                                                     \
                                                                         \
-  if (record)                                                           \
-    {                                                                   \
-      val = rec_aggregate_std_##NAME##_record (record, field_name);     \
-    }                                                                   \
-  else if (rset)                                                        \
-    {                                                                   \
-      rec_record_t rec = NULL;                                          \
-      rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset)); \
-      while (rec_mset_iterator_next (&iter, MSET_RECORD, (void *) &rec, NULL)) \
-        {                                                               \
-          val = OP (val, rec_aggregate_std_##NAME##_record (rec, field_name)); \
-        }                                                               \
-      rec_mset_iterator_free (&iter);                                   \
-    }                                                                   \
+  static bool                                                           \
+  rec_aggregate_std_##NAME##_accumulate (rec_aggregate_state_t *state,  \
+                                         rec_record_t record,           \
+                                         const char *field_name)        \
+  {                                                                     \
+    rec_field_t field;                                                  \
+    rec_mset_iterator_t iter = rec_mset_iterator (rec_record_mset (record)); \
                                                                         \
-  /* Return the val as a string.  Note that if NULL is returned it      \
-     will be returned by this function below to signal the              \
-     end-of-memory condition.  */                                       \
+    while (rec_mset_iterator_next (&iter, MSET_FIELD, (void *) &field, NULL)) \
+      {                                                                 \
+        const char *field_value = rec_field_value (field);              \
+        double field_value_double = 0;                                  \
                                                                         \
-  if (val == floor (val))                                               \
-      asprintf (&result, "%zd", (size_t) val);                          \
-  else                                                                  \
-      asprintf (&result, "%f", val);                                    \
+        if (rec_field_name_equal_p (rec_field_name (field), field_name) \
+            && rec_atod (field_value, &field_value_double))             \
+          {                                                             \
+            state->num = OP (state->num, field_value_double);           \
+            state->count++;                                             \
+          }                                                             \
+      }                                                                 \
+    rec_mset_iterator_free (&iter);                                     \
                                                                         \
-  return result;                                                        \
+    return true;                                                        \
   }                                                                     \
                                                                         \
-  static double                                                         \
-  rec_aggregate_std_##NAME##_record (rec_record_t record,               \
-                                     const char *field_name)            \
+  static bool                                                           \
+  rec_aggregate_std_##NAME##_merge (rec_aggregate_state_t *state,       \
+                                    rec_aggregate_state_t *other)       \
   {                                                                     \
-  /* Calculate the val of the fields in a given record.  Fields not     \
-     representing a real value are ignored.  */                         \
-                                                                        \
-  double val = INIT_VAL;                                                \
-  rec_field_t field;                                                    \
-  rec_mset_iterator_t iter = rec_mset_iterator (rec_record_mset (record)); \
-                                                                        \
-  while (rec_mset_iterator_next (&iter, MSET_FIELD, (void *) &field, NULL)) \
-    {                                                                   \
-  const char *field_value = rec_field_value (field);                    \
-  double field_value_double = 0;                                        \
-                                                                        \
-  if (rec_field_name_equal_p (rec_field_name (field), field_name)       \
-      && rec_atod (field_value, &field_value_double))                   \
-    {                                                                   \
-      val = OP (val, field_value_double);                               \
-    }                                                                   \
-    }                                                                   \
-  rec_mset_iterator_free (&iter);                                       \
+    state->num = OP (state->num, other->num);                           \
+    state->count = state->count + other->count;                         \
+    return true;                                                        \
+  }                                                                     \
                                                                         \
-  return val;                                                           \
+  static char *                                                         \
+  rec_aggregate_std_##NAME##_finalize (rec_aggregate_state_t *state)    \
+  {                                                                     \
+    return rec_aggregate_std_num_str (state->num);                      \
   }
 
 /*
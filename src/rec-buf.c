@@ -26,6 +26,7 @@
 #include <config.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <rec.h>
 
@@ -43,6 +44,8 @@ struct rec_buf_s
   size_t *size_pointer;
 };
 
+static bool rec_buf_grow (rec_buf_t buf, size_t size);
+
 /*
  * Public functions.
  */
@@ -90,6 +93,12 @@ rec_buf_close (rec_buf_t buf)
   free (buf);
 }
 
+size_t
+rec_buf_size (rec_buf_t buf)
+{
+  return buf->used;
+}
+
 void
 rec_buf_rewind (rec_buf_t buf, int n)
 {
@@ -110,18 +119,11 @@ rec_buf_putc (int c, rec_buf_t buf)
     }
 
   ret = (unsigned int) c;
-  if ((buf->used + 1) > buf->size)
+  if (((buf->used + 1) > buf->size)
+      && !rec_buf_grow (buf, 1))
     {
-      /* Allocate a new block */
-      buf->size = buf->size + REC_BUF_STEP;
-      buf->data = realloc (buf->data, buf->size);
-
-      if (!buf->data)
-        {
-          /* Not enough memory.
-           * REC_BUF_STEP should not be 0. */
-          ret = EOF;
-        }
+      /* Not enough memory.  */
+      ret = EOF;
     }
 
   if (ret != EOF)
@@ -136,25 +138,53 @@ rec_buf_putc (int c, rec_buf_t buf)
 int
 rec_buf_puts (const char *str, rec_buf_t buf)
 {
-  int ret;
-  const char *p;
+  return rec_buf_write (str, strlen (str), buf);
+}
 
-  ret = 0;
-  p = str;
-  while (*p != '\0')
+int
+rec_buf_write (const char *data, size_t size, rec_buf_t buf)
+{
+  if (((buf->used + size) > buf->size)
+      && !rec_buf_grow (buf, size))
     {
-      if (rec_buf_putc (*p, buf) == EOF)
-        {
-          /* Error.  */
-          ret = -1;
-          break;
-        }
+      /* Not enough memory.  */
+      return -1;
+    }
+
+  memcpy (buf->data + buf->used, data, size);
+  buf->used = buf->used + size;
 
-      ret++;
-      p++;
+  return size;
+}
+
+/*
+ * Private functions.
+ */
+
+static bool
+rec_buf_grow (rec_buf_t buf, size_t size)
+{
+  size_t new_size;
+  char *new_data;
+
+  /* Make room for SIZE more characters, at least doubling the size of
+     the buffer so appending to it takes linear time.  */
+
+  new_size = buf->size * 2;
+  if (new_size < (buf->used + size))
+    {
+      new_size = buf->used + size + REC_BUF_STEP;
     }
 
-  return ret;
+  new_data = realloc (buf->data, new_size);
+  if (!new_data)
+    {
+      return false;
+    }
+
+  buf->data = new_data;
+  buf->size = new_size;
+  return true;
 }
 
 /* End of rec-buf.c */
@@ -77,4 +77,61 @@ rec_decrypt_record (rec_rset_t rset,
   return false;
 }
 
+rec_crypt_ctx_t
+rec_crypt_ctx_new (const char *password)
+{
+  return NULL;
+}
+
+void
+rec_crypt_ctx_destroy (rec_crypt_ctx_t ctx)
+{
+}
+
+bool
+rec_crypt_ctx_encrypt_field (rec_crypt_ctx_t ctx,
+                             rec_field_t field)
+{
+  return false;
+}
+
+bool
+rec_crypt_ctx_encrypt_record (rec_crypt_ctx_t ctx,
+                              rec_rset_t rset,
+                              rec_record_t record)
+{
+  return false;
+}
+
+bool
+rec_crypt_ctx_decrypt_field (rec_crypt_ctx_t ctx,
+                             rec_field_t field)
+{
+  return false;
+}
+
+bool
+rec_crypt_ctx_decrypt_record (rec_crypt_ctx_t ctx,
+                              rec_rset_t rset,
+                              rec_record_t record)
+{
+  return false;
+}
+
+bool
+rec_encrypt_rset (rec_rset_t rset,
+                  const char *password,
+                  size_t jobs)
+{
+  return false;
+}
+
+bool
+rec_decrypt_rset (rec_rset_t rset,
+                  const char *password,
+                  size_t jobs)
+{
+  return false;
+}
+
 /* End of rec-crypt-dummy.c */
@@ -39,6 +39,45 @@
 
 #define SALT_SIZE 4
 
+/* Context shared by the threads encrypting or decrypting the records
+   of a record set.  The records are processed by a pool of threads in
+   chunks of REC_CRYPT_CHUNK records.  */
+
+#define REC_CRYPT_CHUNK 128
+
+struct rec_crypt_job_s
+{
+  size_t num_records;
+  rec_record_t *records;
+  rec_fex_t confidential_fields;
+  bool (*process_fn) (rec_crypt_ctx_t ctx, rec_field_t field);
+};
+
+struct rec_crypt_worker_s
+{
+  struct rec_crypt_job_s *job;
+  rec_crypt_ctx_t ctx;                /* Private encryption context.  */
+  bool error;                         /* Processing some record
+                                         failed.  */
+};
+
+static bool rec_crypt_ctx_process_record (rec_crypt_ctx_t ctx,
+                                          rec_rset_t rset,
+                                          rec_record_t record,
+                                          bool (*process_fn) (rec_crypt_ctx_t ctx,
+                                                              rec_field_t field));
+static bool rec_crypt_ctx_process_fields (rec_crypt_ctx_t ctx,
+                                          rec_fex_t confidential_fields,
+                                          rec_record_t record,
+                                          bool (*process_fn) (rec_crypt_ctx_t ctx,
+                                                              rec_field_t field));
+static bool rec_crypt_process_rset (rec_rset_t rset,
+                                    const char *password,
+                                    size_t jobs,
+                                    bool (*process_fn) (rec_crypt_ctx_t ctx,
+                                                        rec_field_t field));
+static bool rec_crypt_worker (void *worker, size_t first, size_t last);
+
 static bool
 rec_field_encrypted_p (rec_field_t field)
 {
@@ -47,17 +86,81 @@ rec_field_encrypted_p (rec_field_t field)
                        strlen (REC_ENCRYPTED_PREFIX)) == 0));
 }
 
-bool
-rec_encrypt (char   *in,
-             size_t  in_size,
-             const char   *password,
-             char  **out,
-             size_t *out_size)
+/* Encryption context.  The cipher handle is opened, and the key
+   derived from the password is set, when the context is created.
+   Only the IV changes from a value to the next.  */
+
+struct rec_crypt_ctx_s
 {
   gcry_cipher_hd_t handler;
+};
+
+rec_crypt_ctx_t
+rec_crypt_ctx_new (const char *password)
+{
+  rec_crypt_ctx_t ctx;
   size_t i;
   size_t password_size;
   char key[AESV2_KEYSIZE];
+
+  password_size = strlen (password);
+  if (password_size == 0)
+    {
+      return NULL;
+    }
+
+  ctx = malloc (sizeof (struct rec_crypt_ctx_s));
+  if (!ctx)
+    {
+      /* Out of memory.  */
+      return NULL;
+    }
+
+  /* Create the handler.  */
+  if (gcry_cipher_open (&ctx->handler,
+                        GCRY_CIPHER_AES128,
+                        GCRY_CIPHER_MODE_CBC,
+                        0) != GPG_ERR_NO_ERROR)
+    {
+      free (ctx);
+      return NULL;
+    }
+
+  /* Set the key of the cypher.  */
+  for (i = 0; i < AESV2_KEYSIZE; i++)
+    {
+      key[i] = password[i % password_size];
+    }
+
+  if (gcry_cipher_setkey (ctx->handler, key, AESV2_KEYSIZE)
+      != GPG_ERR_NO_ERROR)
+    {
+      gcry_cipher_close (ctx->handler);
+      free (ctx);
+      return NULL;
+    }
+
+  return ctx;
+}
+
+void
+rec_crypt_ctx_destroy (rec_crypt_ctx_t ctx)
+{
+  if (ctx)
+    {
+      gcry_cipher_close (ctx->handler);
+      free (ctx);
+    }
+}
+
+static bool
+rec_crypt_ctx_encrypt (rec_crypt_ctx_t ctx,
+                       char   *in,
+                       size_t  in_size,
+                       char  **out,
+                       size_t *out_size)
+{
+  size_t i;
   char iv[AESV2_BLKSIZE];
   size_t padding;
   uint32_t crc;
@@ -76,15 +179,11 @@ rec_encrypt (char   *in,
   crc = rec_endian_swap (crc);
 #endif
 
-  real_in_size = in_size + 4;
-  real_in = malloc (real_in_size + 4);
-  memcpy (real_in, in, real_in_size);
-  memcpy (real_in + real_in_size - 4, &crc, 4);
-
   /* The size of the input buffer must be bigger than AESV2_BLKSIZE,
      and must contain an entire number of blocks.  We assure that by
      padding the buffer with \0 characters.  */
 
+  real_in_size = in_size + 4;
   if ((real_in_size % AESV2_BLKSIZE) != 0)
     {
       padding = AESV2_BLKSIZE - (real_in_size % AESV2_BLKSIZE);
@@ -94,90 +193,75 @@ rec_encrypt (char   *in,
       padding = 0;
     }
 
-  if (padding != 0)
-    {
-      real_in_size = real_in_size + padding;
-      real_in = realloc (real_in, real_in_size);
-
-      for (i = 0; i < padding; i++)
-        {
-          real_in[real_in_size - i - 1] = '\0';
-        }
-    }  
-
-  /* Create the handler.  */
-  if (gcry_cipher_open (&handler,
-                        GCRY_CIPHER_AES128,
-                        GCRY_CIPHER_MODE_CBC,
-                        0) != GPG_ERR_NO_ERROR)
+  real_in = malloc (real_in_size + padding);
+  if (!real_in)
     {
+      /* Out of memory.  */
       return false;
     }
 
-  /* Set the key of the cypher.  */
-  password_size = strlen (password);
-  for (i = 0; i < AESV2_KEYSIZE; i++)
-    {
-      key[i] = password[i % password_size];
-    }
-
-  /* Set both the key and the IV vector.  */
-  if (gcry_cipher_setkey (handler, key, AESV2_KEYSIZE)
-      != GPG_ERR_NO_ERROR)
+  memcpy (real_in, in, in_size);
+  memcpy (real_in + in_size, &crc, 4);
+  for (i = 0; i < padding; i++)
     {
-      gcry_cipher_close (handler);
-      return false;
+      real_in[real_in_size + i] = '\0';
     }
+  real_in_size = real_in_size + padding;
 
+  /* Set the IV vector.  */
   gcry_create_nonce (iv, SALT_SIZE);
   for (i = SALT_SIZE; i < AESV2_BLKSIZE; i++)
     {
       iv[i] = i;
     }
-  if (gcry_cipher_setiv (handler, iv, AESV2_BLKSIZE)
+  if (gcry_cipher_setiv (ctx->handler, iv, AESV2_BLKSIZE)
       != GPG_ERR_NO_ERROR)
     {
-      gcry_cipher_close (handler);
+      free (real_in);
       return false;
     }
 
   *out_size = real_in_size + SALT_SIZE;
   *out = malloc (*out_size);
+  if (!*out)
+    {
+      /* Out of memory.  */
+      free (real_in);
+      return false;
+    }
 
   /* Append salt at the end of the output.  */
   memcpy (*out + real_in_size, iv, SALT_SIZE);
 
   /* Encrypt the data.  */
-  if (gcry_cipher_encrypt (handler,
+  if (gcry_cipher_encrypt (ctx->handler,
                            *out,
                            real_in_size,
                            real_in,
                            real_in_size) != 0)
     {
       /* Error.  */
-      gcry_cipher_close (handler);
+      free (real_in);
+      free (*out);
+      *out = NULL;
       return false;
     }
 
-  /* Close the handler.  */
-  gcry_cipher_close (handler);
-
+  free (real_in);
   return true;
 }
 
-bool
-rec_decrypt (char   *in,
-             size_t  in_size,
-             const char   *password,
-             char  **out,
-             size_t *out_size)
+static bool
+rec_crypt_ctx_decrypt (rec_crypt_ctx_t ctx,
+                       char   *in,
+                       size_t  in_size,
+                       char  **out,
+                       size_t *out_size)
 {
-  gcry_cipher_hd_t handler;
   size_t i;
-  size_t password_size;
-  char key[AESV2_KEYSIZE];
   char iv[AESV2_BLKSIZE];
   size_t salt_size = 0;
+  size_t out_len;
 
   if (((in_size - SALT_SIZE) % AESV2_BLKSIZE) == 0)
     {
@@ -188,142 +272,162 @@ rec_decrypt (char   *in,
       return false;
     }
 
-  /* Create the handler.  */
-  if (gcry_cipher_open (&handler,
-                        GCRY_CIPHER_AES128,
-                        GCRY_CIPHER_MODE_CBC,
-                        0) != GPG_ERR_NO_ERROR)
-    {
-      return false;
-    }
-
-  /* Set the key of the cypher.  */
-  password_size = strlen (password);
-  for (i = 0; i < AESV2_KEYSIZE; i++)
-    {
-      key[i] = password[i % password_size];
-    }
-
-  /* Set both the key and the IV vector.  */
-  if (gcry_cipher_setkey (handler, key, AESV2_KEYSIZE)
-      != GPG_ERR_NO_ERROR)
-    {
-      printf ("error setting key\n");
-      gcry_cipher_close (handler);
-      return false;
-    }
-
   /* Extract salt at the end of the output.  */
   memcpy (iv, in + in_size - salt_size, salt_size);
   for (i = salt_size; i < AESV2_BLKSIZE; i++)
     {
       iv[i] = i;
     }
-  if (gcry_cipher_setiv (handler, iv, AESV2_BLKSIZE)
+  if (gcry_cipher_setiv (ctx->handler, iv, AESV2_BLKSIZE)
       != GPG_ERR_NO_ERROR)
     {
-      gcry_cipher_close (handler);
       return false;
     }
 
-  /* Decrypt the data.  */
+  /* Decrypt the data.  The output buffer is terminated, since the
+     decrypted data doesn't contain the padding \0 characters if the
+     password is wrong.  */
   *out_size = in_size - salt_size;
-  *out = malloc (*out_size);
-  if (gcry_cipher_decrypt (handler,
+  *out = malloc (*out_size + 1);
+  if (!*out)
+    {
+      /* Out of memory.  */
+      return false;
+    }
+  (*out)[*out_size] = '\0';
+
+  if (gcry_cipher_decrypt (ctx->handler,
                            *out,
                            *out_size,
                            in,
                            in_size - salt_size) != 0)
     {
       /* Error.  */
-      gcry_cipher_close (handler);
+      free (*out);
+      *out = NULL;
       return false;
     }
 
   /* Make sure the decrypted data is ok by checking the CRC at the end
      of the sequence.  */
 
-  if (strlen(*out) > 4)
+  out_len = strlen (*out);
+  if (out_len > 4)
     {
       uint32_t crc = 0;
       
-      memcpy (&crc, *out + strlen(*out) - 4, 4);
+      memcpy (&crc, *out + out_len - 4, 4);
 #if defined WORDS_BIGENDIAN
       crc = rec_endian_swap (crc);
 #endif
 
-      if (crc32 (*out, strlen(*out) - 4) != crc)
+      if (crc32 (*out, out_len - 4) != crc)
         {
-          gcry_cipher_close (handler);
+          free (*out);
+          *out = NULL;
           return false;
         }
 
-      (*out)[strlen(*out) - 4] = '\0';
+      (*out)[out_len - 4] = '\0';
     }
   else
     {
-      gcry_cipher_close (handler);
+      free (*out);
+      *out = NULL;
       return false;
     }
 
-  /* Close the handler.  */
-  gcry_cipher_close (handler);
-
   return true;
 }
 
+bool
+rec_encrypt (char   *in,
+             size_t  in_size,
+             const char   *password,
+             char  **out,
+             size_t *out_size)
+{
+  rec_crypt_ctx_t ctx;
+  bool res;
+
+  ctx = rec_crypt_ctx_new (password);
+  if (!ctx)
+    {
+      return false;
+    }
+
+  res = rec_crypt_ctx_encrypt (ctx, in, in_size, out, out_size);
+  rec_crypt_ctx_destroy (ctx);
+
+  return res;
+}
+
+bool
+rec_decrypt (char   *in,
+             size_t  in_size,
+             const char   *password,
+             char  **out,
+             size_t *out_size)
+{
+  rec_crypt_ctx_t ctx;
+  bool res;
+
+  ctx = rec_crypt_ctx_new (password);
+  if (!ctx)
+    {
+      return false;
+    }
+
+  res = rec_crypt_ctx_decrypt (ctx, in, in_size, out, out_size);
+  rec_crypt_ctx_destroy (ctx);
+
+  return res;
+}
+
+bool
+rec_crypt_ctx_encrypt_record (rec_crypt_ctx_t ctx,
+                              rec_rset_t rset,
+                              rec_record_t record)
+{
+  return rec_crypt_ctx_process_record (ctx, rset, record,
+                                       rec_crypt_ctx_encrypt_field);
+}
+
 bool
 rec_encrypt_record (rec_rset_t rset,
                     rec_record_t record,
                     const char *password)
 {
-  rec_field_t field;
+  rec_crypt_ctx_t ctx;
   bool res;
-  const char *field_name;
-  rec_fex_t confidential_fields;
-  size_t i, k, num_fields;
-
-  res = true;
 
-  if (rset)
+  if (!rset)
     {
-      confidential_fields = rec_rset_confidential (rset);
-      for (i = 0; i < rec_fex_size (confidential_fields); i++)
-        {
-          field_name = rec_fex_elem_field_name (rec_fex_get (confidential_fields, i));
+      return true;
+    }
 
-          num_fields = rec_record_get_num_fields_by_name (record, field_name);
-          for (k = 0; k < num_fields; k++)
-            {
-              field = rec_record_get_field_by_name (record, field_name, k);
-              if (field)
-                {
-                  res = rec_encrypt_field (field, password);
-                  if (!res)
-                    break;
-                }
-            }
-        }
+  ctx = rec_crypt_ctx_new (password);
+  if (!ctx)
+    {
+      return false;
     }
 
+  res = rec_crypt_ctx_encrypt_record (ctx, rset, record);
+  rec_crypt_ctx_destroy (ctx);
+
   return res;
 }
 
 bool
-rec_encrypt_field (rec_field_t field,
-                   const char *password)
+rec_crypt_ctx_encrypt_field (rec_crypt_ctx_t ctx,
+                             rec_field_t field)
 {
   char *field_value;
   char *field_value_encrypted;
   char *field_value_base64;
   size_t out_size, base64_size;
   char *aux;
-
-  field_value = strdup (rec_field_value (field));
-  if (!field_value)
-    {
-      return false;
-    }
+  bool res;
 
   /* Make sure the field is not already encrypted.  */
   if ((strlen (rec_field_value (field)) >= strlen (REC_ENCRYPTED_PREFIX))
@@ -331,12 +435,19 @@ rec_encrypt_field (rec_field_t field,
                    strlen (REC_ENCRYPTED_PREFIX)) == 0))
     return true;
 
-  if (!rec_encrypt (field_value,
-                    strlen (field_value),
-                    password,
-                    &field_value_encrypted,
-                    &out_size))
+  field_value = strdup (rec_field_value (field));
+  if (!field_value)
+    {
+      return false;
+    }
+
+  if (!rec_crypt_ctx_encrypt (ctx,
+                              field_value,
+                              strlen (field_value),
+                              &field_value_encrypted,
+                              &out_size))
     {
+      free (field_value);
       return false;
     }
   
@@ -345,45 +456,75 @@ rec_encrypt_field (rec_field_t field,
   base64_size = base64_encode_alloc (field_value_encrypted,
                                      out_size,
                                      &field_value_base64);
-  base64_encode (field_value_encrypted,
-                 out_size,
-                 field_value_base64,
-                 base64_size);
+  if (!field_value_base64)
+    {
+      /* Out of memory.  */
+      free (field_value);
+      free (field_value_encrypted);
+      return false;
+    }
 
   /* Prepennd "encrypted-".  */
-  aux = malloc (strlen (field_value_base64)
-                + strlen (REC_ENCRYPTED_PREFIX) + 1);
+  aux = malloc (base64_size + strlen (REC_ENCRYPTED_PREFIX) + 1);
+  if (!aux)
+    {
+      /* Out of memory.  */
+      free (field_value);
+      free (field_value_encrypted);
+      free (field_value_base64);
+      return false;
+    }
+
   memcpy (aux,
           REC_ENCRYPTED_PREFIX,
           strlen (REC_ENCRYPTED_PREFIX));
   memcpy (aux + strlen (REC_ENCRYPTED_PREFIX),
           field_value_base64,
-          strlen (field_value_base64));
-  aux[strlen (field_value_base64)
-      + strlen (REC_ENCRYPTED_PREFIX)] = '\0';
+          base64_size);
+  aux[base64_size + strlen (REC_ENCRYPTED_PREFIX)] = '\0';
   free (field_value_base64);
   field_value_base64 = aux;
   
   /* Replace the value of the field.  */
-  rec_field_set_value (field, field_value_base64);
+  res = rec_field_set_value (field, field_value_base64);
   
   /* Free resources.  */
   free (field_value);
   free (field_value_encrypted);
   free (field_value_base64);
 
-  return true;
+  return res;
 }
 
 bool
-rec_decrypt_field (rec_field_t field,
+rec_encrypt_field (rec_field_t field,
                    const char *password)
+{
+  rec_crypt_ctx_t ctx;
+  bool res;
+
+  ctx = rec_crypt_ctx_new (password);
+  if (!ctx)
+    {
+      return false;
+    }
+
+  res = rec_crypt_ctx_encrypt_field (ctx, field);
+  rec_crypt_ctx_destroy (ctx);
+
+  return res;
+}
+
+bool
+rec_crypt_ctx_decrypt_field (rec_crypt_ctx_t ctx,
+                             rec_field_t field)
 {
   const char *field_value;
   char *base64_decoded;
   size_t base64_decoded_size;
   char *decrypted_value;
   size_t decrypted_value_size;
+  bool res = true;
 
   /* Make sure the field is encrypted.  */
   if ((strlen (rec_field_value (field)) < strlen (REC_ENCRYPTED_PREFIX))
@@ -394,34 +535,61 @@ rec_decrypt_field (rec_field_t field,
   /* Skip the "encrypted-" prefix.  */
   field_value = rec_field_value (field) + strlen (REC_ENCRYPTED_PREFIX);
 
-  /* Decode the Base64.  */
+  /* Decode the Base64.  If the value can't be decrypted, because it
+     is not valid or the password is not correct, then it is left
+     as-is.  */
 
   if (base64_decode_alloc (field_value,
                            strlen(field_value),
                            &base64_decoded,
-                           &base64_decoded_size))
+                           &base64_decoded_size)
+      && base64_decoded)
     {
-      base64_decode (field_value,
-                     strlen(field_value),
-                     base64_decoded,
-                     &base64_decoded_size);
-      
       /* Decrypt.  */
 
-      if (rec_decrypt (base64_decoded,
-                       base64_decoded_size,
-                       password,
-                       &decrypted_value,
-                       &decrypted_value_size))
+      if (rec_crypt_ctx_decrypt (ctx,
+                                 base64_decoded,
+                                 base64_decoded_size,
+                                 &decrypted_value,
+                                 &decrypted_value_size))
         {
-          rec_field_set_value (field, decrypted_value);
+          res = rec_field_set_value (field, decrypted_value);
+          free (decrypted_value);
         }
 
       /* Free resources.  */
       free (base64_decoded);
     }
 
-  return true;
+  return res;
+}
+
+bool
+rec_decrypt_field (rec_field_t field,
+                   const char *password)
+{
+  rec_crypt_ctx_t ctx;
+  bool res;
+
+  ctx = rec_crypt_ctx_new (password);
+  if (!ctx)
+    {
+      return false;
+    }
+
+  res = rec_crypt_ctx_decrypt_field (ctx, field);
+  rec_crypt_ctx_destroy (ctx);
+
+  return res;
+}
+
+bool
+rec_crypt_ctx_decrypt_record (rec_crypt_ctx_t ctx,
+                              rec_rset_t rset,
+                              rec_record_t record)
+{
+  return rec_crypt_ctx_process_record (ctx, rset, record,
+                                       rec_crypt_ctx_decrypt_field);
 }
 
 bool
@@ -429,34 +597,251 @@ rec_decrypt_record (rec_rset_t rset,
                     rec_record_t record,
                     const char *password)
 {
+  rec_crypt_ctx_t ctx;
+  bool res;
+
+  if (!rset)
+    {
+      return true;
+    }
+
+  ctx = rec_crypt_ctx_new (password);
+  if (!ctx)
+    {
+      return false;
+    }
+
+  res = rec_crypt_ctx_decrypt_record (ctx, rset, record);
+  rec_crypt_ctx_destroy (ctx);
+
+  return res;
+}
+
+static bool
+rec_crypt_ctx_process_record (rec_crypt_ctx_t ctx,
+                              rec_rset_t rset,
+                              rec_record_t record,
+                              bool (*process_fn) (rec_crypt_ctx_t ctx,
+                                                  rec_field_t field))
+{
+  /* Apply PROCESS_FN to the fields of RECORD which are declared as
+     confidential in RSET.  */
+
   bool res = true;
-  size_t i, num_fields, k;
   rec_field_t field;
-  const char *field_name;
+  rec_mset_iterator_t iter;
+
+  if (!rset)
+    {
+      return true;
+    }
+
+  iter = rec_mset_iterator (rec_record_mset (record));
+  while (rec_mset_iterator_next (&iter, MSET_FIELD, (const void **) &field, NULL))
+    {
+      if (rec_rset_field_confidential_p (rset, rec_field_name (field)))
+        {
+          res = process_fn (ctx, field);
+          if (!res)
+            break;
+        }
+    }
+  rec_mset_iterator_free (&iter);
+
+  return res;
+}
+
+static bool
+rec_crypt_ctx_process_fields (rec_crypt_ctx_t ctx,
+                              rec_fex_t confidential_fields,
+                              rec_record_t record,
+                              bool (*process_fn) (rec_crypt_ctx_t ctx,
+                                                  rec_field_t field))
+{
+  bool res = true;
+  rec_field_t field;
+  rec_mset_iterator_t iter;
+
+  if (rec_fex_size (confidential_fields) == 0)
+    {
+      return true;
+    }
+
+  iter = rec_mset_iterator (rec_record_mset (record));
+  while (rec_mset_iterator_next (&iter, MSET_FIELD, (const void **) &field, NULL))
+    {
+      if (rec_fex_member_p (confidential_fields,
+                            rec_field_name (field),
+                            -1, -1))
+        {
+          res = process_fn (ctx, field);
+          if (!res)
+            break;
+        }
+    }
+  rec_mset_iterator_free (&iter);
+
+  return res;
+}
+
+bool
+rec_encrypt_rset (rec_rset_t rset,
+                  const char *password,
+                  size_t jobs)
+{
+  return rec_crypt_process_rset (rset, password, jobs,
+                                 rec_crypt_ctx_encrypt_field);
+}
+
+bool
+rec_decrypt_rset (rec_rset_t rset,
+                  const char *password,
+                  size_t jobs)
+{
+  return rec_crypt_process_rset (rset, password, jobs,
+                                 rec_crypt_ctx_decrypt_field);
+}
+
+static bool
+rec_crypt_process_rset (rec_rset_t rset,
+                        const char *password,
+                        size_t jobs,
+                        bool (*process_fn) (rec_crypt_ctx_t ctx,
+                                            rec_field_t field))
+{
+  struct rec_crypt_job_s job;
+  struct rec_crypt_worker_s *workers = NULL;
+  rec_pool_t pool = NULL;
   rec_fex_t confidential_fields;
+  size_t num_workers, i;
+  bool ret = true;
+
+  job.process_fn = process_fn;
+
+  /* Nothing to do if the record set doesn't have confidential
+     fields.  */
 
-  if (rset)
+  confidential_fields = rec_rset_confidential (rset);
+  if (!confidential_fields)
     {
-      confidential_fields = rec_rset_confidential (rset);
-      for (i = 0; i < rec_fex_size (confidential_fields); i++)
+      /* Out of memory.  */
+      return false;
+    }
+
+  job.num_records = rec_rset_num_records (rset);
+  if ((rec_fex_size (confidential_fields) == 0) || (job.num_records == 0))
+    {
+      rec_fex_destroy (confidential_fields);
+      return true;
+    }
+
+  /* Collect the records to process in an array, so the workers can
+     access them by position.  */
+
+  job.records = malloc (sizeof (rec_record_t) * job.num_records);
+  if (!job.records)
+    {
+      /* Out of memory.  */
+      rec_fex_destroy (confidential_fields);
+      return false;
+    }
+
+  {
+    rec_record_t record = NULL;
+    rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
+
+    i = 0;
+    while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+      {
+        job.records[i++] = record;
+      }
+    rec_mset_iterator_free (&iter);
+  }
+
+  num_workers = rec_pool_num_workers (jobs, job.num_records, REC_CRYPT_CHUNK);
+  workers = calloc (num_workers, sizeof (struct rec_crypt_worker_s));
+  if (!workers)
+    {
+      /* Out of memory.  */
+      ret = false;
+      goto exit;
+    }
+
+  /* Every worker gets its own encryption context, since a cipher
+     handle can't be shared among threads.  */
+
+  job.confidential_fields = confidential_fields;
+  for (i = 0; i < num_workers; i++)
+    {
+      workers[i].job = &job;
+      workers[i].error = false;
+      workers[i].ctx = rec_crypt_ctx_new (password);
+      if (!workers[i].ctx)
         {
-          field_name = rec_fex_elem_field_name (rec_fex_get (confidential_fields, i));
+          ret = false;
+          break;
+        }
+    }
 
-          num_fields = rec_record_get_num_fields_by_name (record, field_name);
-          for (k = 0; k < num_fields; k++)
+  if (ret)
+    {
+      pool = rec_pool_new (job.num_records, REC_CRYPT_CHUNK,
+                           num_workers, 0,
+                           rec_crypt_worker,
+                           workers, sizeof (struct rec_crypt_worker_s));
+      ret = pool && rec_pool_run (pool);
+      rec_pool_destroy (pool);
+
+      for (i = 0; i < num_workers; i++)
+        {
+          if (workers[i].error)
             {
-              field = rec_record_get_field_by_name (record, field_name, k);
-              if (field)
-                {
-                  res = rec_decrypt_field (field, password);
-                  if (!res)
-                    break;
-                }
+              ret = false;
             }
         }
     }
 
-  return res;
+ exit:
+
+  if (workers)
+    {
+      for (i = 0; i < num_workers; i++)
+        {
+          rec_crypt_ctx_destroy (workers[i].ctx);
+        }
+    }
+
+  free (workers);
+  free (job.records);
+  rec_fex_destroy (confidential_fields);
+
+  return ret;
+}
+
+static bool
+rec_crypt_worker (void *worker,
+                  size_t first,
+                  size_t last)
+{
+  struct rec_crypt_worker_s *crypt_worker = (struct rec_crypt_worker_s *) worker;
+  struct rec_crypt_job_s *job = crypt_worker->job;
+  size_t i;
+
+  /* A failure in a record doesn't prevent processing the rest of
+     them, so it is not reported to the pool.  */
+
+  for (i = first; i < last; i++)
+    {
+      if (!rec_crypt_ctx_process_fields (crypt_worker->ctx,
+                                         job->confidential_fields,
+                                         job->records[i],
+                                         job->process_fn))
+        {
+          crypt_worker->error = true;
+        }
+    }
+
+  return true;
 }
 
 /* End of rec-crypt.c */
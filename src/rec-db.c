@@ -44,6 +44,53 @@ struct rec_db_s
                                      in this database.  */
   gl_list_t rset_list;            /* List of record sets.  */
   rec_aggregate_reg_t aggregates; /* Registry with the aggregates.  */
+  size_t jobs;                    /* Number of threads to use.  */
+  bool modified_p;                /* Whether the database was
+                                     modified by rec_db_insert,
+                                     rec_db_delete or rec_db_set.  */
+  size_t modified_char_location;  /* Smallest character location of
+                                     the records affected by those
+                                     modifications.  */
+};
+
+/* Set of record positions used to select records by position.  It
+   is a sorted array of disjoint intervals Min,Max, so it can be
+   looked up using binary search.  */
+
+struct rec_db_index_s
+{
+  size_t size;                    /* Number of intervals.  */
+  size_t *intervals;              /* Pairs Min,Max.  */
+};
+
+typedef struct rec_db_index_s *rec_db_index_t;
+
+/* Context shared by the threads performing a parallel query.  The
+   records are processed by a pool of threads in chunks of
+   REC_DB_QUERY_CHUNK records.  */
+
+#define REC_DB_QUERY_CHUNK 128
+
+struct rec_db_query_job_s
+{
+  rec_db_t db;
+  rec_rset_t rset;
+  rec_db_index_t index;
+  const char *fast_string;
+  rec_fex_t fex;
+  const char *password;
+  int flags;
+
+  size_t num_records;
+  rec_record_t *records;          /* Records to process.  */
+  rec_record_t *results;          /* Processed records, or NULL.  */
+};
+
+struct rec_db_query_worker_s
+{
+  struct rec_db_query_job_s *job;
+  rec_sex_t sex;                  /* Private copy of the sex.  */
+  rec_crypt_ctx_t crypt_ctx;      /* Private encryption context.  */
 };
 
 /* Static functions defined in this file.  */
@@ -57,14 +104,43 @@ static rec_record_t rec_db_process_fex (rec_db_t db,
                                         rec_record_t record,
                                         rec_fex_t fex);
 
+static bool rec_db_query_record (rec_db_t db,
+                                 rec_rset_t rset,
+                                 rec_record_t record,
+                                 size_t num_rec,
+                                 rec_db_index_t index,
+                                 rec_sex_t sex,
+                                 const char *fast_string,
+                                 rec_fex_t fex,
+                                 rec_crypt_ctx_t crypt_ctx,
+                                 int flags,
+                                 rec_record_t *res_record);
+static bool rec_db_query_parallel (rec_db_t db,
+                                   rec_rset_t rset,
+                                   rec_rset_t res,
+                                   rec_db_index_t index,
+                                   rec_sex_t sex,
+                                   const char *fast_string,
+                                   rec_fex_t fex,
+                                   const char *password,
+                                   rec_crypt_ctx_t crypt_ctx,
+                                   int flags);
+static bool rec_db_query_worker (void *worker, size_t first, size_t last);
+
 static bool rec_db_record_selected_p (size_t num_rec,
                                       rec_record_t record,
-                                      size_t *index,
+                                      rec_db_index_t index,
                                       rec_sex_t sex,
                                       const char *fast_string,
                                       bool case_insensitive_p);
-static void rec_db_add_random_indexes (size_t **index, size_t num, size_t limit);
-static bool rec_db_index_p (size_t *index, size_t num);
+static rec_db_index_t rec_db_index_new (size_t *index);
+static rec_db_index_t rec_db_index_new_random (size_t num, size_t limit);
+static void rec_db_index_destroy (rec_db_index_t index);
+static int rec_db_index_compare_fn (const void *interval1, const void *interval2);
+static bool rec_db_index_p (rec_db_index_t index, size_t num);
+
+static void rec_db_mark_modified (rec_db_t db, rec_record_t record);
+static void rec_db_mark_changed (rec_rset_t rset, rec_record_t record);
 
 static bool rec_db_set_act_rename (rec_rset_t rset, rec_record_t record, rec_fex_t fex, bool rename_descriptor, const char *arg);
 static bool rec_db_set_act_set (rec_rset_t rset, rec_record_t record, rec_fex_t fex, bool xxx, const char *arg);
@@ -87,6 +163,9 @@ rec_db_new (void)
   if (new)
     {
       new->size = 0;
+      new->jobs = 1;
+      new->modified_p = false;
+      new->modified_char_location = 0;
       new->rset_list = gl_list_nx_create_empty (GL_ARRAY_LIST,
                                                 rec_db_rset_equals_fn,
                                                 NULL,
@@ -279,6 +358,8 @@ rec_db_query (rec_db_t     db,
 {
   rec_rset_t res = NULL;
   rec_rset_t rset = NULL;
+  rec_db_index_t sel_index = NULL;
+  rec_crypt_ctx_t crypt_ctx = NULL;
 
   /* Create a new, empty, record set, that will contain the contents
      of the selection.  */
@@ -355,8 +436,7 @@ rec_db_query (rec_db_t     db,
           if (!descriptor)
             {
               /* Out of memory.  */
-              free (res);
-              return NULL;
+              goto error;
             }
         }
 
@@ -364,16 +444,26 @@ rec_db_query (rec_db_t     db,
     }
   
   /* Generate a list of random indexes here if requested.  The
-     generated random indexes are added to the indexes list, which
-     must be NULL if random > 0 (mutually exclusive arguments).  */
+     generated random indexes are used instead of the indexes list,
+     which must be NULL if random > 0 (mutually exclusive
+     arguments).  */
 
   if (random > 0)
     {
-      rec_db_add_random_indexes (&index, random, rec_rset_num_records (rset));
-      if (!index)
+      sel_index = rec_db_index_new_random (random, rec_rset_num_records (rset));
+      if (!sel_index)
         {
           /* Out of memory.  */
-          return NULL;
+          goto error;
+        }
+    }
+  else if (index)
+    {
+      sel_index = rec_db_index_new (index);
+      if (!sel_index)
+        {
+          /* Out of memory.  */
+          goto error;
         }
     }
 
@@ -395,7 +485,8 @@ rec_db_query (rec_db_t     db,
                                 MSET_RECORD))
             {
               /* Out of memory.  */
-              return NULL;
+              rec_record_destroy (record);
+              goto error;
             }
         }
     }
@@ -414,86 +505,74 @@ rec_db_query (rec_db_t     db,
           if (!rec_rset_sort (rset, group_by))
             {
               /* Out of memory.  */
-              return NULL;
+              goto error;
             }
 
           if (!rec_rset_group (rset, group_by))
             {
               /* Out of memory.  */
-              return NULL;
+              goto error;
             }
         }
 
       if (!rec_rset_sort (rset, sort_by))
         {
           /* Out of memory.  */
-          return NULL;
+          goto error;
         }
 
-      rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
-      while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
-        {
-          rec_record_t res_record;
-          num_rec++;
-        
-          /* Determine whether we must skip this record.  */
-        
-          if (!rec_db_record_selected_p (num_rec,
-                                         record,
-                                         index,
-                                         sex,
-                                         fast_string,
-                                         flags & REC_F_ICASE))
-            {
-              continue;
-            }
-              
-          /* Process this record.  */
+#if defined REC_CRYPT_SUPPORT
 
-          /* Transform the record through the field expression and add
-             it to the result record set.  */
-      
-          res_record
-            = rec_db_process_fex (db, rset, record, fex);
+      /* The confidential fields of the selected records are decrypted
+         using the same encryption context, so the cipher is set up
+         just once.  */
 
-          if (!res_record)
+      if (password && (password[0] != '\0'))
+        {
+          crypt_ctx = rec_crypt_ctx_new (password);
+          if (!crypt_ctx)
             {
               /* Out of memory.  */
-              return NULL;
+              goto error;
             }
+        }
+#endif
 
-          /* Do not add empty records to the result record set.  */
-
-          if (rec_record_num_elems (res_record) == 0)
+      if ((flags & REC_F_PARALLEL) && (rec_db_jobs (db) != 1))
+        {
+          if (!rec_db_query_parallel (db, rset, res,
+                                      sel_index, sex, fast_string,
+                                      fex, password, crypt_ctx, flags))
             {
-              continue;
+              /* Out of memory.  */
+              goto error;
             }
 
-#if defined REC_CRYPT_SUPPORT
+          goto exit;
+        }
 
-          /* Decrypt the confidential fields in the record if some
-             of the fields are declared as "confidential", but only
-             do that if the user provided a password.  Note that we
-             use 'rset' instead of 'res' to cover cases where (flags
-             & REC_F_DESCRIPTOR) == 0.  */
-        
-          if (password)
+      rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
+      while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+        {
+          rec_record_t res_record;
+          num_rec++;
+
+          if (!rec_db_query_record (db, rset, record, num_rec,
+                                    sel_index, sex, fast_string,
+                                    fex, crypt_ctx, flags,
+                                    &res_record))
             {
-              if (!rec_decrypt_record (rset, res_record, password))
-                {
-                  /* Out of memory.  */
-                  return NULL;
-                }
+              /* Out of memory.  */
+              rec_mset_iterator_free (&iter);
+              goto error;
             }
-#endif
 
-          /* Remove duplicated fields if requested by the user.  */
-        
-          if (flags & REC_F_UNIQ)
+          if (!res_record)
             {
-              rec_record_uniq (res_record);
+              /* The record was not selected.  */
+              continue;
             }
-        
+
           /* Append.  */
 
           rec_record_set_container (res_record, res);
@@ -503,13 +582,25 @@ rec_db_query (rec_db_t     db,
                                 MSET_RECORD))
             {
               /* Out of memory.  */
-              return NULL;
+              rec_record_destroy (res_record);
+              rec_mset_iterator_free (&iter);
+              goto error;
             }
-        
         }
       rec_mset_iterator_free (&iter);
     }
 
+  goto exit;
+
+ error:
+
+  rec_rset_destroy (res);
+  res = NULL;
+
+ exit:
+
+  rec_crypt_ctx_destroy (crypt_ctx);
+  rec_db_index_destroy (sel_index);
   return res;
 }
 
@@ -541,14 +632,24 @@ rec_db_insert (rec_db_t db,
       if (rset)
         {
           size_t num_rec = -1;
+          rec_db_index_t sel_index = NULL;
 
           /* If the user requested to replace random records,
              calculate them now for this record set.  */
 
           if (random > 0)
             {
-              rec_db_add_random_indexes (&index, random, rec_rset_num_records (rset));
-              if (!index)
+              sel_index = rec_db_index_new_random (random, rec_rset_num_records (rset));
+              if (!sel_index)
+                {
+                  /* Out of memory.  */
+                  return false;
+                }
+            }
+          else if (index)
+            {
+              sel_index = rec_db_index_new (index);
+              if (!sel_index)
                 {
                   /* Out of memory.  */
                   return false;
@@ -587,6 +688,7 @@ rec_db_insert (rec_db_t db,
 
           {
             rec_record_t rset_record = NULL;
+            rec_record_t new_record;
             rec_mset_elem_t elem;
             rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
 
@@ -598,7 +700,7 @@ rec_db_insert (rec_db_t db,
 
                 if (!rec_db_record_selected_p (num_rec,
                                                rset_record,
-                                               index,
+                                               sel_index,
                                                sex,
                                                fast_string,
                                                flags & REC_F_ICASE))
@@ -608,12 +710,24 @@ rec_db_insert (rec_db_t db,
 
                 /* Replace the record.  */
 
+                rec_db_mark_modified (db, rset_record);
                 rec_record_set_container (record, rset);
-                rec_mset_elem_set_data (elem, (void *) rec_record_dup (record));
+                new_record = rec_record_dup (record);
+                if (!new_record)
+                  {
+                    /* Out of memory.  */
+                    return false;
+                  }
+
+                rec_db_mark_changed (rset, new_record);
+                rec_rset_reset_auto_fields (rset);
+                rec_mset_elem_set_data (elem, (void *) new_record);
                 
               }
             rec_mset_iterator_free (&iter);
           }
+
+          rec_db_index_destroy (sel_index);
         }
     }
   else
@@ -624,10 +738,11 @@ rec_db_insert (rec_db_t db,
 
       if (rset)
         {
-          rec_record_set_container (record, rset);
-
           /* Add auto-set fields required by this record set, unless
-             the addition of auto-fields is disabled by the user.  */
+             the addition of auto-fields is disabled by the user.  The
+             record is not stored in RSET yet, which is taken into
+             account when caching the next values of the auto
+             fields.  */
 
           if (!(flags & REC_F_NOAUTO))
             {
@@ -652,11 +767,16 @@ rec_db_insert (rec_db_t db,
             }
 #endif
 
+          rec_record_set_container (record, rset);
+
           if (rec_rset_num_records (rset) == 0)
             {
               /* The rset is empty => Insert the new record just after
                  the relative position of the record descriptor.  */
 
+              rec_db_mark_modified (db, rec_rset_descriptor (rset));
+              rec_db_mark_changed (rset, record);
+
               rec_mset_insert_at (rec_rset_mset (rset),
                                   MSET_RECORD,
                                   (void *) record,
@@ -673,6 +793,9 @@ rec_db_insert (rec_db_t db,
                                                 MSET_RECORD,
                                                 rec_rset_num_records (rset) - 1);
 
+              rec_db_mark_modified (db, last_record);
+              rec_db_mark_changed (rset, record);
+
               if (!rec_mset_insert_after (mset,
                                           MSET_RECORD,
                                           (void *) record,
@@ -694,6 +817,8 @@ rec_db_insert (rec_db_t db,
               return false;
             }
 
+          rec_db_mark_modified (db, NULL);
+          rec_db_mark_changed (rset, record);
           rec_rset_set_type (rset, type);
           rec_record_set_container (record, rset);
           if (!rec_mset_append (rec_rset_mset (rset),
@@ -735,6 +860,7 @@ rec_db_delete (rec_db_t     db,
      the default record set does not exist, and the database contains
      only one record set, then select it.  */
 
+  rec_db_index_t sel_index = NULL;
   rec_rset_t rset = rec_db_get_rset_by_type (db, type);
   if (!type && !rset && (rec_db_size (db) == 1))
     {
@@ -753,8 +879,17 @@ rec_db_delete (rec_db_t     db,
 
   if (random > 0)
     {
-      rec_db_add_random_indexes (&index, random, rec_rset_num_records (rset));
-      if (!index)
+      sel_index = rec_db_index_new_random (random, rec_rset_num_records (rset));
+      if (!sel_index)
+        {
+          /* Out of memory.  */
+          return false;
+        }
+    }
+  else if (index)
+    {
+      sel_index = rec_db_index_new (index);
+      if (!sel_index)
         {
           /* Out of memory.  */
           return false;
@@ -776,7 +911,7 @@ rec_db_delete (rec_db_t     db,
 
         if (!rec_db_record_selected_p (num_rec,
                                        record,
-                                       index,
+                                       sel_index,
                                        sex,
                                        fast_string,
                                        flags & REC_F_ICASE))
@@ -784,6 +919,10 @@ rec_db_delete (rec_db_t     db,
             continue;
           }
 
+        rec_db_mark_modified (db, record);
+        rec_db_mark_changed (rset, NULL);
+        rec_rset_reset_auto_fields (rset);
+
         if (flags & REC_F_COMMENT_OUT)
           {
             /* Replace the record with a comment in the current
@@ -811,6 +950,7 @@ rec_db_delete (rec_db_t     db,
     rec_mset_iterator_free (&iter);
   }
 
+  rec_db_index_destroy (sel_index);
   return true;
 }
 
@@ -829,6 +969,7 @@ bool rec_db_set (rec_db_t    db,
      the default record set does not exist, and the database contains
      only one record set, then select it.  */
 
+  rec_db_index_t sel_index = NULL;
   rec_rset_t rset = rec_db_get_rset_by_type (db, type);
   if (!type && !rset && (rec_db_size (db) == 1))
     {
@@ -847,8 +988,17 @@ bool rec_db_set (rec_db_t    db,
 
   if (random > 0)
     {
-      rec_db_add_random_indexes (&index, random, rec_rset_num_records (rset));
-      if (!index)
+      sel_index = rec_db_index_new_random (random, rec_rset_num_records (rset));
+      if (!sel_index)
+        {
+          /* Out of memory.  */
+          return false;
+        }
+    }
+  else if (index)
+    {
+      sel_index = rec_db_index_new (index);
+      if (!sel_index)
         {
           /* Out of memory.  */
           return false;
@@ -869,7 +1019,7 @@ bool rec_db_set (rec_db_t    db,
 
         if (!rec_db_record_selected_p (num_rec,
                                        record,
-                                       index,
+                                       sel_index,
                                        sex,
                                        fast_string,
                                        flags & REC_F_ICASE))
@@ -877,6 +1027,10 @@ bool rec_db_set (rec_db_t    db,
             continue;
           }
 
+        rec_db_mark_modified (db, record);
+        rec_db_mark_changed (rset, record);
+        rec_rset_reset_auto_fields (rset);
+
         switch (action)
           {
           case REC_SET_ACT_RENAME:
@@ -891,6 +1045,8 @@ bool rec_db_set (rec_db_t    db,
                 {
                   rename_descriptor = true;
                   descriptor_renamed = true;
+                  rec_db_mark_modified (db, rec_rset_descriptor (rset));
+                  rec_db_mark_changed (rset, rec_rset_descriptor (rset));
                 }
 
               if (!rec_db_set_act_rename (rset, record, fex, rename_descriptor, action_arg))
@@ -949,6 +1105,7 @@ bool rec_db_set (rec_db_t    db,
           default:
             {
               /* Ignore an invalid action.  */
+              rec_db_index_destroy (sel_index);
               return true;
             }
           }
@@ -956,6 +1113,7 @@ bool rec_db_set (rec_db_t    db,
     rec_mset_iterator_free (&iter);
   }
 
+  rec_db_index_destroy (sel_index);
   return true;
 }
 
@@ -965,10 +1123,65 @@ rec_db_aggregates (rec_db_t db)
   return db->aggregates;
 }
 
+size_t
+rec_db_jobs (rec_db_t db)
+{
+  return db->jobs;
+}
+
+void
+rec_db_set_jobs (rec_db_t db, size_t jobs)
+{
+  db->jobs = jobs;
+}
+
+bool
+rec_db_modified_p (rec_db_t db,
+                   size_t *char_location)
+{
+  if (db->modified_p && char_location)
+    {
+      *char_location = db->modified_char_location;
+    }
+
+  return db->modified_p;
+}
+
 /*
  * Private functions.
  */
 
+static void
+rec_db_mark_modified (rec_db_t db,
+                      rec_record_t record)
+{
+  /* Records not read from a file, and records for which there is no
+     better approximation (RECORD is NULL) have location 0, which
+     means that everything may have changed.  */
+
+  size_t char_location = record ? rec_record_char_location (record) : 0;
+
+  if (!db->modified_p || (char_location < db->modified_char_location))
+    {
+      db->modified_char_location = char_location;
+      db->modified_p = true;
+    }
+}
+
+static void
+rec_db_mark_changed (rec_rset_t rset,
+                     rec_record_t record)
+{
+  /* Keep track of the record sets and records that must be checked
+     again by rec_int_check_db_incremental.  */
+
+  rec_rset_set_modified (rset, true);
+  if (record)
+    {
+      rec_record_set_modified (record, true);
+    }
+}
+
 static rec_record_t
 rec_db_merge_records (rec_record_t record1,
                       rec_record_t record2,
@@ -1456,98 +1669,202 @@ rec_db_set_act_delete (rec_rset_t rset,
   return true;
 }
 
-static bool
-rec_db_index_p (size_t *index,
-                size_t num)
+static rec_db_index_t
+rec_db_index_new (size_t *index)
 {
-  while ((index[0] != REC_Q_NOINDEX) || (index[1] != REC_Q_NOINDEX))
+  /* Build a set of record positions from the list of indexes INDEX,
+     which contains pairs of indexes Min,Max in any order, possibly
+     overlapping.  Max is REC_Q_NOINDEX in single indexes.  The final
+     pair is always REC_Q_NOINDEX,REC_Q_NOINDEX.  */
+
+  rec_db_index_t new;
+  size_t num_intervals, i, j;
+
+  num_intervals = 0;
+  while ((index[2 * num_intervals] != REC_Q_NOINDEX)
+         || (index[2 * num_intervals + 1] != REC_Q_NOINDEX))
     {
-      bool found = false;
-      size_t min = index[0];
-      size_t max = index[1];
-      
-      if (max == REC_Q_NOINDEX)
+      num_intervals++;
+    }
+
+  new = malloc (sizeof (struct rec_db_index_s));
+  if (!new)
+    {
+      /* Out of memory.  */
+      return NULL;
+    }
+
+  new->size = 0;
+  new->intervals = malloc (sizeof (size_t) * 2 * (num_intervals + 1));
+  if (!new->intervals)
+    {
+      /* Out of memory.  */
+      free (new);
+      return NULL;
+    }
+
+  for (i = 0; i < num_intervals; i++)
+    {
+      new->intervals[2 * i] = index[2 * i];
+      new->intervals[2 * i + 1] = index[2 * i + 1];
+      if (new->intervals[2 * i + 1] == REC_Q_NOINDEX)
         {
-          found = (num == min);
+          new->intervals[2 * i + 1] = new->intervals[2 * i];
         }
-      else
+    }
+
+  /* Sort the intervals and merge the overlapping ones.  */
+
+  qsort (new->intervals, num_intervals, sizeof (size_t) * 2,
+         rec_db_index_compare_fn);
+
+  for (i = 0, j = 0; i < num_intervals; i++)
+    {
+      size_t min = new->intervals[2 * i];
+      size_t max = new->intervals[2 * i + 1];
+
+      if ((j > 0) && (min <= new->intervals[2 * (j - 1) + 1]))
         {
-          found = ((num >= min) && (num <= max));
+          if (max > new->intervals[2 * (j - 1) + 1])
+            {
+              new->intervals[2 * (j - 1) + 1] = max;
+            }
         }
-      
-      if (found)
+      else
         {
-          return true;
+          new->intervals[2 * j] = min;
+          new->intervals[2 * j + 1] = max;
+          j++;
         }
-      
-      index = index + 2;
     }
 
-  return false;
+  new->size = j;
+  return new;
 }
 
-static void
-rec_db_add_random_indexes (size_t **index,
-                           size_t num,
-                           size_t limit)
+static rec_db_index_t
+rec_db_index_new_random (size_t num,
+                         size_t limit)
 {
-  /* Create NUM different random numbers in the [0..limit-1] range,
-     without repetition, and store them in a buffer pointed by
-     INDEX.  */
-
-  size_t i;
+  /* Create a set of NUM different random positions in the [0..limit-1]
+     range.  The positions are chosen using selection sampling: every
+     position is considered in turn and selected with probability
+     (NUM - SELECTED) / (LIMIT - POSITION).  This runs in time
+     proportional to LIMIT, and the selected positions are already
+     sorted.  */
+
+  rec_db_index_t new;
+  size_t position, selected;
   char random_state[128];
   struct random_data random_data;
 
-  *index = malloc (sizeof(size_t) * ((num + 1) * 2));
-  if (*index == NULL)
+  if (num > limit)
     {
-      /* Out of memory.  */
-      return;
+      num = limit;
     }
-  
-  for (i = 0; i < ((num + 1) * 2); i++)
+
+  new = malloc (sizeof (struct rec_db_index_s));
+  if (!new)
     {
-      (*index)[i]   = REC_Q_NOINDEX;
+      /* Out of memory.  */
+      return NULL;
     }
 
-  /* Insert the random indexes.  */
+  new->size = 0;
+  new->intervals = malloc (sizeof (size_t) * 2 * (num + 1));
+  if (!new->intervals)
+    {
+      /* Out of memory.  */
+      free (new);
+      return NULL;
+    }
 
   memset (&random_data, 0, sizeof (random_data));
   initstate_r (time(NULL), (char *) &random_state, 128, &random_data);
-  for (i = 0; i < (num * 2); i = i + 2)
+
+  selected = 0;
+  for (position = 0; (position < limit) && (selected < num); position++)
     {
-      size_t random_value = 0;
-      
-      random_r (&random_data, (int32_t *) &random_value); /* Can't fail.  */
-      random_value = random_value % limit;
+      int32_t random_value;
+      double probability;
 
-      /* Avoid having repeated random indexes.  */
-      
-      if (rec_db_index_p (*index, random_value))
+      random_r (&random_data, &random_value); /* Can't fail.  */
+      probability = (double) random_value / ((double) RAND_MAX + 1);
+      if ((limit - position) * probability < (num - selected))
         {
-          /* Pick the first available number.  */
-
-          size_t i;
-          for (i = 0; i < limit; i++)
-            {
-              if (!rec_db_index_p (*index, i))
-                {
-                  random_value = i;
-                  break;
-                }
-            }
+          new->intervals[2 * selected] = position;     /* Min.  */
+          new->intervals[2 * selected + 1] = position; /* Max.  */
+          selected++;
         }
+    }
+
+  new->size = selected;
+  return new;
+}
+
+static void
+rec_db_index_destroy (rec_db_index_t index)
+{
+  if (index)
+    {
+      free (index->intervals);
+      free (index);
+    }
+}
+
+static int
+rec_db_index_compare_fn (const void *interval1,
+                         const void *interval2)
+{
+  size_t min1 = *((const size_t *) interval1);
+  size_t min2 = *((const size_t *) interval2);
+
+  if (min1 < min2)
+    {
+      return -1;
+    }
+  else if (min1 > min2)
+    {
+      return 1;
+    }
 
-      (*index)[i]   = random_value;  /* Min.  */
-      (*index)[i+1] = REC_Q_NOINDEX; /* Max.  */
+  return 0;
+}
+
+static bool
+rec_db_index_p (rec_db_index_t index,
+                size_t num)
+{
+  /* Look for the interval containing NUM using binary search.  */
+
+  size_t low = 0;
+  size_t high = index->size;
+
+  while (low < high)
+    {
+      size_t middle = low + (high - low) / 2;
+
+      if (num < index->intervals[2 * middle])
+        {
+          high = middle;
+        }
+      else if (num > index->intervals[2 * middle + 1])
+        {
+          low = middle + 1;
+        }
+      else
+        {
+          return true;
+        }
     }
+
+  return false;
 }
 
 static bool
 rec_db_record_selected_p (size_t num_record,
                           rec_record_t record,
-                          size_t *index,
+                          rec_db_index_t index,
                           rec_sex_t sex,
                           const char *fast_string,
                           bool case_insensitive_p)
@@ -1576,10 +1893,8 @@ rec_db_record_selected_p (size_t num_record,
       return rec_sex_eval (sex, record, &eval_status);
     }
 
-  /* The memory pointed by INDEX contains pairs of indexes Min,Max.
-     The final pair is always REC_Q_NOINDEX,REC_Q_NOINDEX.  Select the
-     current record only if its position is into some of the defined
-     intervals.  */
+  /* Select the current record only if its position is into some of
+     the intervals in INDEX.  */
   
   if (index)
     {
@@ -1636,13 +1951,18 @@ rec_db_process_fex (rec_db_t db,
              the indexes.  The value returned by the funciton is then
              appended into the current record in a new field, named
              after the name of the aggregate and the name of the
-             argument field.  Non-existing aggregates are simply
-             ignored.  */
+             argument field.  Incremental implementations of the
+             aggregates are preferred.  Non-existing aggregates are
+             simply ignored.  */
 
+          const rec_aggregate_incr_t *incr
+            = rec_aggregate_reg_get_incr (rec_db_aggregates (db), function_name);
           rec_aggregate_t func = rec_aggregate_reg_get (rec_db_aggregates (db), function_name);
-          if (func)
+          if (incr || func)
             {
-              char *func_res = (func) (rset, record, field_name);
+              char *func_res = incr
+                ? rec_aggregate_incr_apply (incr, rset, record, field_name)
+                : (func) (rset, record, field_name);
               if (func_res)
                 {
                   /* Add a new field with the result of the aggregate
@@ -1772,6 +2092,284 @@ rec_db_process_fex (rec_db_t db,
   return res;
 }
 
+static bool
+rec_db_query_record (rec_db_t db,
+                     rec_rset_t rset,
+                     rec_record_t record,
+                     size_t num_rec,
+                     rec_db_index_t index,
+                     rec_sex_t sex,
+                     const char *fast_string,
+                     rec_fex_t fex,
+                     rec_crypt_ctx_t crypt_ctx,
+                     int flags,
+                     rec_record_t *res_record)
+{
+  /* Process a record being queried, storing the record to be added to
+     the result record set in RES_RECORD.  If the record is not
+     selected, or if it results in an empty record, then NULL is
+     stored in RES_RECORD.  This function returns 'false' if there is
+     not enough memory to perform the operation.  */
+
+  *res_record = NULL;
+
+  /* Determine whether we must skip this record.  */
+
+  if (!rec_db_record_selected_p (num_rec,
+                                 record,
+                                 index,
+                                 sex,
+                                 fast_string,
+                                 flags & REC_F_ICASE))
+    {
+      return true;
+    }
+
+  /* Transform the record through the field expression.  */
+
+  *res_record = rec_db_process_fex (db, rset, record, fex);
+  if (!*res_record)
+    {
+      /* Out of memory.  */
+      return false;
+    }
+
+  /* Do not add empty records to the result record set.  */
+
+  if (rec_record_num_elems (*res_record) == 0)
+    {
+      rec_record_destroy (*res_record);
+      *res_record = NULL;
+      return true;
+    }
+
+#if defined REC_CRYPT_SUPPORT
+
+  /* Decrypt the confidential fields in the record if some of the
+     fields are declared as "confidential", but only do that if the
+     user provided a password.  Note that we use 'rset' instead of the
+     result record set to cover cases where (flags & REC_F_DESCRIPTOR)
+     == 0.  */
+
+  if (crypt_ctx)
+    {
+      if (!rec_crypt_ctx_decrypt_record (crypt_ctx, rset, *res_record))
+        {
+          /* Out of memory.  */
+          return false;
+        }
+    }
+#endif
+
+  /* Remove duplicated fields if requested by the user.  */
+
+  if (flags & REC_F_UNIQ)
+    {
+      rec_record_uniq (*res_record);
+    }
+
+  return true;
+}
+
+static bool
+rec_db_query_parallel (rec_db_t db,
+                       rec_rset_t rset,
+                       rec_rset_t res,
+                       rec_db_index_t index,
+                       rec_sex_t sex,
+                       const char *fast_string,
+                       rec_fex_t fex,
+                       const char *password,
+                       rec_crypt_ctx_t crypt_ctx,
+                       int flags)
+{
+  struct rec_db_query_job_s job;
+  struct rec_db_query_worker_s *workers = NULL;
+  rec_pool_t pool = NULL;
+  size_t num_workers, i;
+  bool ret = true;
+
+  job.db = db;
+  job.rset = rset;
+  job.index = index;
+  job.fast_string = fast_string;
+  job.fex = fex;
+  job.password = password;
+  job.flags = flags;
+
+  /* Collect the records to process in an array, so the workers can
+     access them by position.  */
+
+  job.num_records = rec_rset_num_records (rset);
+  if (job.num_records == 0)
+    {
+      return true;
+    }
+
+  job.records = malloc (sizeof (rec_record_t) * job.num_records);
+  job.results = malloc (sizeof (rec_record_t) * job.num_records);
+  if (!job.records || !job.results)
+    {
+      /* Out of memory.  */
+      free (job.records);
+      free (job.results);
+      return false;
+    }
+
+  {
+    rec_record_t record = NULL;
+    rec_mset_iterator_t iter = rec_mset_iterator (rec_rset_mset (rset));
+
+    i = 0;
+    while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+      {
+        job.records[i] = record;
+        job.results[i] = NULL;
+        i++;
+      }
+    rec_mset_iterator_free (&iter);
+  }
+
+  num_workers = rec_pool_num_workers (rec_db_jobs (db), job.num_records,
+                                      REC_DB_QUERY_CHUNK);
+  workers = calloc (num_workers, sizeof (struct rec_db_query_worker_s));
+  if (!workers)
+    {
+      /* Out of memory.  */
+      ret = false;
+      goto exit;
+    }
+
+  /* Every worker gets its own copy of the selection expression, since
+     evaluating a sex modifies its internal state, and its own
+     encryption context.  The first worker can use the original
+     ones.  */
+
+  for (i = 0; i < num_workers; i++)
+    {
+      workers[i].job = &job;
+      workers[i].sex = sex;
+      workers[i].crypt_ctx = crypt_ctx;
+
+      if (i == 0)
+        {
+          continue;
+        }
+
+      if (sex)
+        {
+          workers[i].sex = rec_sex_dup (sex);
+          if (!workers[i].sex)
+            {
+              /* Out of memory.  */
+              num_workers = i;
+              ret = false;
+              break;
+            }
+        }
+
+      if (crypt_ctx)
+        {
+          workers[i].crypt_ctx = rec_crypt_ctx_new (password);
+          if (!workers[i].crypt_ctx)
+            {
+              /* Out of memory.  */
+              num_workers = i + 1;
+              ret = false;
+              break;
+            }
+        }
+    }
+
+  if (ret)
+    {
+      pool = rec_pool_new (job.num_records, REC_DB_QUERY_CHUNK,
+                           num_workers, 0,
+                           rec_db_query_worker,
+                           workers, sizeof (struct rec_db_query_worker_s));
+      ret = pool && rec_pool_run (pool);
+      rec_pool_destroy (pool);
+    }
+
+  /* Append the resulting records to RES, preserving the order of the
+     original records.  */
+
+  for (i = 0; i < job.num_records; i++)
+    {
+      rec_record_t res_record = job.results[i];
+
+      if (!res_record)
+        {
+          continue;
+        }
+
+      if (ret)
+        {
+          rec_record_set_container (res_record, res);
+          if (!rec_mset_append (rec_rset_mset (res),
+                                MSET_RECORD,
+                                (void *) res_record,
+                                MSET_RECORD))
+            {
+              /* Out of memory.  */
+              ret = false;
+            }
+        }
+
+      if (!ret)
+        {
+          rec_record_destroy (res_record);
+        }
+    }
+
+ exit:
+
+  if (workers)
+    {
+      for (i = 1; i < num_workers; i++)
+        {
+          if (workers[i].sex != sex)
+            {
+              rec_sex_destroy (workers[i].sex);
+            }
+          if (workers[i].crypt_ctx != crypt_ctx)
+            {
+              rec_crypt_ctx_destroy (workers[i].crypt_ctx);
+            }
+        }
+    }
+
+  free (workers);
+  free (job.records);
+  free (job.results);
+
+  return ret;
+}
+
+static bool
+rec_db_query_worker (void *worker,
+                     size_t first,
+                     size_t last)
+{
+  struct rec_db_query_worker_s *query_worker = (struct rec_db_query_worker_s *) worker;
+  struct rec_db_query_job_s *job = query_worker->job;
+  size_t i;
+
+  for (i = first; i < last; i++)
+    {
+      if (!rec_db_query_record (job->db, job->rset, job->records[i], i,
+                                job->index, query_worker->sex, job->fast_string,
+                                job->fex, query_worker->crypt_ctx, job->flags,
+                                &job->results[i]))
+        {
+          /* Out of memory.  */
+          return false;
+        }
+    }
+
+  return true;
+}
+
 static bool
 rec_db_rset_equals_fn (const void *elt1,
                        const void *elt2)
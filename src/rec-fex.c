@@ -28,6 +28,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <gettext.h>
+#include <gl_linkedhash_list.h>
+#include <gl_list.h>
+#include <hash-pjw.h>
 #define _(str) dgettext (PACKAGE, str)
 
 #include <rec-utils.h>
@@ -48,15 +51,28 @@ struct rec_fex_elem_s
 
   char *function_name;
   void *function_data;
+
+  rec_fex_t fex;     /* Field expression containing this element.  */
 };
 
-#define REC_FEX_MAX_ELEMS 256
+/* Field expressions with at least REC_FEX_HASH_MIN elements keep a
+   hash table with the names of their fields, which is used to
+   determine whether a given field name is in the fex.  The table is
+   updated every time an element is added or renamed, so looking up a
+   name never modifies the fex and can be done by several threads at
+   the same time.  If the table can't be built the elements are
+   scanned instead.  */
+
+#define REC_FEX_HASH_MIN 8
 
 struct rec_fex_s
 {
   int num_elems;
   char *str;
-  rec_fex_elem_t elems[REC_FEX_MAX_ELEMS];
+  rec_fex_elem_t *elems;
+  size_t elems_alloc;
+
+  gl_list_t names;
 };
 
 /*
@@ -64,6 +80,10 @@ struct rec_fex_s
  */
 
 static void rec_fex_init (rec_fex_t fex);
+static bool rec_fex_add_elem (rec_fex_t fex, rec_fex_elem_t elem);
+static void rec_fex_reset_names (rec_fex_t fex);
+static bool rec_fex_build_names (rec_fex_t fex);
+static void rec_fex_add_name (rec_fex_t fex, const char *field_name);
 
 static bool rec_fex_parse_str_simple     (rec_fex_t new,       const char *str, const char *sep);
 static bool rec_fex_parse_str_subscripts (rec_fex_t new,       const char *str);
@@ -78,20 +98,12 @@ rec_fex_new (const char *str,
              enum rec_fex_kind_e kind)
 {
   rec_fex_t new;
-  int i;
 
   new = malloc (sizeof (struct rec_fex_s));
   if (new)
     {
       rec_fex_init (new);
 
-      new->num_elems = 0;
-      new->str = NULL;
-      for (i = 0; i < REC_FEX_MAX_ELEMS; i++)
-        {
-          new->elems[i] = 0;
-        }
-
       if (str != NULL)
         {
           /* Parse the string, using the proper parsing routine
@@ -103,6 +115,7 @@ rec_fex_new (const char *str,
               if (!rec_fex_parse_str_subscripts (new, str))
                 {
                   /* Out of memory or parse error.  */
+                  free (new->elems);
                   free (new);
                   return NULL;
                 }
@@ -112,6 +125,7 @@ rec_fex_new (const char *str,
               if (!rec_fex_parse_str_simple (new, str, " \t\n"))
                 {
                   /* Out of memory or parse error.  */
+                  free (new->elems);
                   free (new);
                   return NULL;
                 }
@@ -121,6 +135,7 @@ rec_fex_new (const char *str,
               if (!rec_fex_parse_str_simple (new, str, ","))
                 {
                   /* Out of memory or parse error.  */
+                  free (new->elems);
                   free (new);
                   return NULL;
                 }
@@ -140,12 +155,17 @@ rec_fex_destroy (rec_fex_t fex)
     {
       for (i = 0; i < fex->num_elems; i++)
         {
+          if (!fex->elems[i])
+            continue;
+
           free (fex->elems[i]->rewrite_to);
           free (fex->elems[i]->field_name);
           free (fex->elems[i]->str);
           free (fex->elems[i]);
         }
       
+      rec_fex_reset_names (fex);
+      free (fex->elems);
       free (fex->str);
       free (fex);
     }
@@ -162,14 +182,16 @@ rec_fex_dup (rec_fex_t fex)
     {
       rec_fex_init (copy);
   
-      copy->num_elems = fex->num_elems;
-      copy->str = strdup (fex->str);
-      if (!copy->str)
+      copy->str = fex->str ? strdup (fex->str) : NULL;
+      copy->elems = calloc (fex->num_elems + 1, sizeof (rec_fex_elem_t));
+      if ((fex->str && !copy->str) || !copy->elems)
         {
           /* Out of memory.  */
           rec_fex_destroy (copy);
           return NULL;
         }
+      copy->num_elems = fex->num_elems;
+      copy->elems_alloc = fex->num_elems + 1;
 
       for (i = 0; i < fex->num_elems; i++)
         {
@@ -189,6 +211,7 @@ rec_fex_dup (rec_fex_t fex)
 
           copy->elems[i]->max = fex->elems[i]->max;
           copy->elems[i]->min = fex->elems[i]->min;
+          copy->elems[i]->fex = copy;
 
 #define REC_COPY_STR_MAYBE_RETURN(FNAME)                                \
           do                                                            \
@@ -214,6 +237,11 @@ rec_fex_dup (rec_fex_t fex)
           REC_COPY_STR_MAYBE_RETURN (rewrite_to);
           REC_COPY_STR_MAYBE_RETURN (function_name);
         }
+
+      if (copy->num_elems >= REC_FEX_HASH_MIN)
+        {
+          rec_fex_build_names (copy);
+        }
     }
 
   return copy;
@@ -281,6 +309,17 @@ rec_fex_elem_set_field_name (rec_fex_elem_t elem,
 {
   free (elem->field_name);
   elem->field_name = strdup (fname);
+
+  /* The old name may still be used by other elements, so rebuild the
+     table of names from scratch.  */
+
+  if (elem->fex && elem->fex->names)
+    {
+      rec_fex_reset_names (elem->fex);
+      if (elem->field_name)
+        rec_fex_build_names (elem->fex);
+    }
+
   return (elem->field_name != NULL);
 }
 
@@ -422,6 +461,12 @@ rec_fex_member_p (rec_fex_t fex,
 {
   bool res = false;
   int i;
+
+  /* Use the hash table of field names when only the field name
+     matters.  */
+
+  if ((min == -1) && (max == -1) && fex->names)
+    return (gl_list_search (fex->names, fname) != NULL);
   
   for (i = 0; i < fex->num_elems; i++)
     {
@@ -446,12 +491,6 @@ rec_fex_append (rec_fex_t fex,
 {
   rec_fex_elem_t new_elem;
 
-  if (fex->num_elems >= REC_FEX_MAX_ELEMS)
-    {
-      fprintf (stderr, _("internal error: REC_FEX_MAX_ELEMS exceeded.  Please report this.\n"));
-      return NULL;
-    }
-
   new_elem = malloc (sizeof (struct rec_fex_elem_s));
   if (new_elem)
     {
@@ -475,7 +514,14 @@ rec_fex_append (rec_fex_t fex,
 
       new_elem->min = min;
       new_elem->max = max;
-      fex->elems[fex->num_elems++] = new_elem;
+      if (!rec_fex_add_elem (fex, new_elem))
+        {
+          /* Out of memory.  */
+          free (new_elem->str);
+          free (new_elem->field_name);
+          free (new_elem);
+          return NULL;
+        }
     }
 
   return new_elem;
@@ -525,6 +571,110 @@ rec_fex_init (rec_fex_t fex)
   memset (fex, 0 /* NULL */, sizeof (struct rec_fex_s));
 }
 
+static bool
+rec_fex_add_elem (rec_fex_t fex,
+                  rec_fex_elem_t elem)
+{
+  rec_fex_elem_t *elems;
+  size_t elems_alloc;
+
+  if (fex->num_elems >= fex->elems_alloc)
+    {
+      elems_alloc = (fex->elems_alloc == 0) ? 8 : 2 * fex->elems_alloc;
+      elems = realloc (fex->elems, elems_alloc * sizeof (rec_fex_elem_t));
+      if (!elems)
+        /* Out of memory.  */
+        return false;
+
+      fex->elems = elems;
+      fex->elems_alloc = elems_alloc;
+    }
+
+  elem->fex = fex;
+  fex->elems[fex->num_elems++] = elem;
+  rec_fex_add_name (fex, elem->field_name);
+  return true;
+}
+
+static bool
+rec_fex_names_equals_fn (const void *elt1,
+                         const void *elt2)
+{
+  return rec_field_name_equal_p ((const char *) elt1,
+                                 (const char *) elt2);
+}
+
+static size_t
+rec_fex_names_hash_fn (const void *elt)
+{
+  return hash_pjw (elt, SIZE_MAX);
+}
+
+static void
+rec_fex_reset_names (rec_fex_t fex)
+{
+  if (fex->names)
+    {
+      gl_list_free (fex->names);
+      fex->names = NULL;
+    }
+}
+
+static bool
+rec_fex_build_names (rec_fex_t fex)
+{
+  /* The names in the table are the ones of the elements of the fex,
+     which are not copied.  */
+
+  size_t i;
+
+  fex->names = gl_list_nx_create_empty (GL_LINKEDHASH_LIST,
+                                        rec_fex_names_equals_fn,
+                                        rec_fex_names_hash_fn,
+                                        NULL,
+                                        false);
+  if (!fex->names)
+    /* Out of memory.  */
+    return false;
+
+  for (i = 0; i < fex->num_elems; i++)
+    {
+      const char *field_name = fex->elems[i]->field_name;
+
+      if (!gl_list_search (fex->names, field_name)
+          && !gl_list_nx_add_last (fex->names, field_name))
+        {
+          /* Out of memory.  */
+          rec_fex_reset_names (fex);
+          return false;
+        }
+    }
+
+  return true;
+}
+
+static void
+rec_fex_add_name (rec_fex_t fex,
+                  const char *field_name)
+{
+  /* Build the table when the fex gets big enough, and keep it up to
+     date afterwards.  */
+
+  if (fex->num_elems < REC_FEX_HASH_MIN)
+    return;
+
+  if (!fex->names)
+    {
+      rec_fex_build_names (fex);
+    }
+  else if (!gl_list_search (fex->names, field_name)
+           && !gl_list_nx_add_last (fex->names, field_name))
+    {
+      /* Out of memory.  */
+      rec_fex_reset_names (fex);
+    }
+}
+
 static bool
 rec_fex_parse_str_simple (rec_fex_t new,
                           const char *str,
@@ -613,7 +763,15 @@ rec_fex_parse_str_simple (rec_fex_t new,
               elem->str = strdup (elem_str);
               elem->min = -1;
               elem->max = -1;
-              new->elems[new->num_elems++] = elem;
+              if (!rec_fex_add_elem (new, elem))
+                {
+                  /* Out of memory.  */
+                  free (elem->field_name);
+                  free (elem->str);
+                  free (elem);
+                  res = false;
+                  break;
+                }
             }
           else
             {
@@ -696,7 +854,15 @@ rec_fex_parse_str_subscripts (rec_fex_t new,
         }
 
       /* Add the elem to the FEX.  */
-      new->elems[new->num_elems++] = elem;
+      if (!rec_fex_add_elem (new, elem))
+        {
+          /* Out of memory.  */
+          free (elem->field_name);
+          free (elem->str);
+          free (elem);
+          res = false;
+          break;
+        }
     }
   while ((elem_str = strsep (&fex_str, ",")));
 
@@ -55,6 +55,11 @@ struct rec_field_s
   /* Field marks.  */
 
   int mark;
+
+  /* Whether the name or the value of the field were changed after its
+     creation.  */
+
+  bool modified_p;
 };
 
 /* Static functions defined below.  */
@@ -76,6 +81,7 @@ rec_field_set_name (rec_field_t field, const char *name)
 {
   free (field->name);
   field->name = strdup (name);
+  field->modified_p = true;
   return (field->name != NULL);
 }
 
@@ -91,6 +97,7 @@ rec_field_set_value (rec_field_t field,
 {
   free (field->value);
   field->value = strdup (value);
+  field->modified_p = true;
   return (field->value != NULL);
 }
 
@@ -119,6 +126,8 @@ rec_field_new (const char *name,
           rec_field_destroy (field);
           return NULL;
         }
+
+      field->modified_p = false;
     }
   
   return field;
@@ -136,6 +145,7 @@ rec_field_dup (rec_field_t field)
       new_field->location = field->location;
       new_field->char_location = field->char_location;
       new_field->mark = field->mark;
+      new_field->modified_p = field->modified_p;
 
       if (field->source)
         {
@@ -222,6 +232,12 @@ rec_field_to_comment (rec_field_t field)
   return res;
 }
 
+bool
+rec_field_modified_p (rec_field_t field)
+{
+  return field->modified_p;
+}
+
 const char *
 rec_field_source (rec_field_t field)
 {
@@ -68,6 +68,13 @@ static int rec_int_check_record_secrets (rec_rset_t rset, rec_record_t record,
                                          rec_buf_t errors);
 #endif
 
+static int rec_int_check_rset_records (rec_db_t db,
+                                       rec_rset_t rset,
+                                       rec_record_t only_record,
+                                       bool modified_only_p,
+                                       bool check_descriptor_p,
+                                       bool remote_descriptor_p,
+                                       rec_buf_t errors);
 static int rec_int_merge_remote (rec_rset_t rset, rec_buf_t errors);
 static bool rec_int_rec_type_p (const char *str);
 
@@ -120,100 +127,92 @@ rec_int_check_db (rec_db_t db,
 }
 
 int
-rec_int_check_rset (rec_db_t db,
-                    rec_rset_t rset,
-                    bool check_descriptor_p,
-                    bool remote_descriptor_p,
-                    rec_buf_t errors)
+rec_int_check_db_incremental (rec_db_t db,
+                              bool check_descriptors_p,
+                              bool remote_descriptors_p,
+                              rec_buf_t errors)
 {
-  int res;
-  rec_mset_iterator_t iter;
-  rec_record_t record;
+  int ret;
+  size_t db_size;
+  size_t n_rset;
+  rec_rset_t rset;
   rec_record_t descriptor;
-  size_t num_records, min_records, max_records;
 
-  res = 0;
+  ret = 0;
+  db_size = rec_db_size (db);
 
-  if (remote_descriptor_p
-      && (descriptor = rec_rset_descriptor (rset)))
-    {
-      /* Make a backup of the record descriptor to restore it
-         later.  */
-      descriptor = rec_record_dup (descriptor);
+  /* A modified record descriptor may affect the records of any
+     record set, for example through the type of a foreign key, so
+     check everything in that case.  */
 
-      /* Fetch the remote descriptor, if any, and merge it with the
-         local descriptor.  If there is any error, stop and report
-         it.  */
-      res = rec_int_merge_remote (rset, errors);
-      if (res > 0)
+  for (n_rset = 0; n_rset < db_size; n_rset++)
+    {
+      descriptor = rec_rset_descriptor (rec_db_get_rset (db, n_rset));
+      if (descriptor && rec_record_modified_p (descriptor))
         {
-          return res;
+          return rec_int_check_db (db,
+                                   check_descriptors_p,
+                                   remote_descriptors_p,
+                                   errors);
         }
     }
 
-  if (check_descriptor_p)
-    {
-      res += rec_int_check_descriptor (rset, errors);
-    }
-
-  if (res > 0)
-    {
-      /* Stop here, since a lot of errors in the records will be
-         generated due to errors in the record descriptor.  */
-      return res;
-    }
-
-  /* Verify rset size restrictions.  */
-  num_records = rec_rset_num_records (rset);
-  min_records = rec_rset_min_records (rset);
-  max_records = rec_rset_max_records (rset);
+  /* Otherwise only the modified records can violate the
+     restrictions on their own fields and the uniqueness of keys, and
+     deletions can only violate the size restrictions of their record
+     sets.  */
 
-  if (min_records == max_records)
-    {
-      if (num_records != min_records)
-        {
-          ADD_ERROR (errors,
-                     _("%s: error: the number of records of type %s should be %zd.\n"),
-                     rec_rset_source (rset), rec_rset_type (rset), min_records);
-          res++;
-        }
-    }
-  else
+  for (n_rset = 0; n_rset < db_size; n_rset++)
     {
-      if (num_records > rec_rset_max_records (rset))
-        {
-          ADD_ERROR (errors,
-                     _("%s: error: too many records of type %s. Maximum allowed are %zd.\n"),
-                     rec_rset_source (rset), rec_rset_type (rset), rec_rset_max_records (rset));
-          res++;
-        }
-      if (num_records < rec_rset_min_records (rset))
+      rset = rec_db_get_rset (db, n_rset);
+      if (!rec_rset_modified_p (rset))
         {
-          ADD_ERROR (errors,
-                     _("%s: error: too few records of type %s. Minimum allowed are %zd.\n"),
-                    rec_rset_source (rset), rec_rset_type (rset), rec_rset_min_records (rset));
-          res++;
+          continue;
         }
-    }
-  
-  iter = rec_mset_iterator (rec_rset_mset (rset));
-  while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
-    {
-      res += rec_int_check_record (db,
-                                   rset,
-                                   record, record,
-                                   errors);
+
+      ret = ret + rec_int_check_rset_records (db,
+                                              rset,
+                                              NULL,
+                                              true,
+                                              check_descriptors_p,
+                                              remote_descriptors_p,
+                                              errors);
     }
 
-  rec_mset_iterator_free (&iter);
+  return ret;
+}
 
-  if (remote_descriptor_p)
-    {
-      /* Restore the original descriptor in the record set.  */
-      rec_rset_set_descriptor (rset, descriptor);
-    }
+int
+rec_int_check_rset (rec_db_t db,
+                    rec_rset_t rset,
+                    bool check_descriptor_p,
+                    bool remote_descriptor_p,
+                    rec_buf_t errors)
+{
+  return rec_int_check_rset_records (db,
+                                     rset,
+                                     NULL,
+                                     false,
+                                     check_descriptor_p,
+                                     remote_descriptor_p,
+                                     errors);
+}
 
-  return res;
+int
+rec_int_check_rset_append (rec_db_t db,
+                           rec_rset_t rset,
+                           rec_record_t record,
+                           bool check_descriptor_p,
+                           bool remote_descriptor_p,
+                           rec_buf_t errors)
+{
+  return rec_int_check_rset_records (db,
+                                     rset,
+                                     record,
+                                     false,
+                                     check_descriptor_p,
+                                     remote_descriptor_p,
+                                     errors);
 }
 
 int
@@ -326,6 +325,123 @@ rec_int_check_field_type (rec_db_t db,
  * Private functions
  */
 
+static int
+rec_int_check_rset_records (rec_db_t db,
+                            rec_rset_t rset,
+                            rec_record_t only_record,
+                            bool modified_only_p,
+                            bool check_descriptor_p,
+                            bool remote_descriptor_p,
+                            rec_buf_t errors)
+{
+  int res;
+  rec_mset_iterator_t iter;
+  rec_record_t record;
+  rec_record_t descriptor;
+  size_t num_records, min_records, max_records;
+
+  res = 0;
+
+  if (remote_descriptor_p
+      && (descriptor = rec_rset_descriptor (rset)))
+    {
+      /* Make a backup of the record descriptor to restore it
+         later.  */
+      descriptor = rec_record_dup (descriptor);
+
+      /* Fetch the remote descriptor, if any, and merge it with the
+         local descriptor.  If there is any error, stop and report
+         it.  */
+      res = rec_int_merge_remote (rset, errors);
+      if (res > 0)
+        {
+          return res;
+        }
+    }
+
+  if (check_descriptor_p)
+    {
+      res += rec_int_check_descriptor (rset, errors);
+    }
+
+  if (res > 0)
+    {
+      /* Stop here, since a lot of errors in the records will be
+         generated due to errors in the record descriptor.  */
+      return res;
+    }
+
+  /* Verify rset size restrictions.  */
+  num_records = rec_rset_num_records (rset);
+  min_records = rec_rset_min_records (rset);
+  max_records = rec_rset_max_records (rset);
+
+  if (min_records == max_records)
+    {
+      if (num_records != min_records)
+        {
+          ADD_ERROR (errors,
+                     _("%s: error: the number of records of type %s should be %zd.\n"),
+                     rec_rset_source (rset), rec_rset_type (rset), min_records);
+          res++;
+        }
+    }
+  else
+    {
+      if (num_records > rec_rset_max_records (rset))
+        {
+          ADD_ERROR (errors,
+                     _("%s: error: too many records of type %s. Maximum allowed are %zd.\n"),
+                     rec_rset_source (rset), rec_rset_type (rset), rec_rset_max_records (rset));
+          res++;
+        }
+      if (num_records < rec_rset_min_records (rset))
+        {
+          ADD_ERROR (errors,
+                     _("%s: error: too few records of type %s. Minimum allowed are %zd.\n"),
+                    rec_rset_source (rset), rec_rset_type (rset), rec_rset_min_records (rset));
+          res++;
+        }
+    }
+  
+  if (only_record)
+    {
+      /* Only the given record is checked, since the rest of the
+         record set is assumed to be valid.  */
+      res += rec_int_check_record (db,
+                                   rset,
+                                   only_record, only_record,
+                                   errors);
+    }
+  else
+    {
+      iter = rec_mset_iterator (rec_rset_mset (rset));
+      while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+        {
+          if (modified_only_p && !rec_record_modified_p (record))
+            {
+              /* This record is assumed to be valid.  */
+              continue;
+            }
+
+          res += rec_int_check_record (db,
+                                       rset,
+                                       record, record,
+                                       errors);
+        }
+
+      rec_mset_iterator_free (&iter);
+    }
+
+  if (remote_descriptor_p)
+    {
+      /* Restore the original descriptor in the record set.  */
+      rec_rset_set_descriptor (rset, descriptor);
+    }
+
+  return res;
+}
+
 static rec_fex_t
 rec_int_collect_field_list (rec_record_t record,
                             const char *fname)
@@ -227,11 +227,14 @@ rec_mset_sort (rec_mset_t mset)
   rec_mset_elem_t elem;
   gl_list_iterator_t iter;
   gl_list_t list;
+  size_t count[MAX_NTYPES];
 
   /* Save a reference to the old gnulib list and create a new, empty
-     one.  */
+     one.  The statistics are recalculated as the elements are
+     inserted in the new list.  */
 
   list = mset->elem_list;
+  memcpy (count, mset->count, sizeof (count));
   mset->elem_list = gl_list_nx_create_empty (GL_ARRAY_LIST,
                                              rec_mset_elem_equal_fn,
                                              NULL,
@@ -240,9 +243,12 @@ rec_mset_sort (rec_mset_t mset)
   if (!mset->elem_list)
     {
       /* Out of memory.  */
+      mset->elem_list = list;
       return NULL;
     }
 
+  memset (mset->count, 0, sizeof (mset->count));
+
   /* Iterate on the old list getting the data of the elements and
      inserting it into the new sorted gl_list.  */
 
@@ -260,6 +266,7 @@ rec_mset_sort (rec_mset_t mset)
 
           gl_list_free (mset->elem_list);
           mset->elem_list = list;
+          memcpy (mset->count, count, sizeof (count));
           return NULL;
         }
 
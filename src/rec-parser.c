@@ -51,6 +51,10 @@ static bool rec_parser_digit_p (char c);
 static bool rec_parser_letter_p (char c);
 static bool rec_parser_init_common (rec_parser_t parser, const char *source);
 
+static bool rec_parser_read_record_text (rec_parser_t parser);
+static bool rec_parser_record_text_p (rec_parser_t parser);
+static bool rec_parse_record_text (rec_parser_t parser, rec_record_t *record);
+
 /*
  * Parser Data Structure
  */
@@ -85,6 +89,24 @@ struct rec_parser_s
   size_t line; /* Current line number. */
   size_t character; /* Current offset from the beginning of the file,
                        in characters.  */
+
+  /* Prefilter.  If PREFILTER is not NULL then the text of every
+     record is read into TEXT before parsing it, and the record is
+     skipped if the text does not contain PREFILTER.  */
+
+  char *prefilter;
+  struct rec_search_s prefilter_search;
+  char *text;
+  size_t text_size;
+  size_t text_alloc;
+  size_t text_line;       /* Line where TEXT starts.  */
+  size_t text_character;  /* Offset where TEXT starts.  */
+
+  /* Record callback.  If RECORD_FN is not NULL then it is called with
+     every regular record parsed by rec_parse_rset.  */
+
+  rec_parser_record_fn_t record_fn;
+  void *record_fn_data;
 };
 
 const char *rec_parser_error_strings[] =
@@ -170,6 +192,8 @@ rec_parser_destroy (rec_parser_t parser)
   if (parser)
     {
       free (parser->source);
+      free (parser->prefilter);
+      free (parser->text);
       free (parser);
     }
 }
@@ -406,6 +430,8 @@ rec_parse_record (rec_parser_t parser,
   char c;
   rec_comment_t comment;
   size_t char_location;
+  size_t char_start;
+  size_t char_end;
 
   /* Sanity check */
   if (rec_parser_eof (parser)
@@ -423,6 +449,7 @@ rec_parse_record (rec_parser_t parser,
   rec_record_set_source (new, parser->source);
   rec_record_set_location (new, parser->line);
   char_location = parser->character;
+  char_start = char_location;
 
   if (char_location != 0)
     char_location++;
@@ -434,8 +461,11 @@ rec_parse_record (rec_parser_t parser,
    *  FIELD (FIELD|COMMENT)*
    */
   if (rec_parse_field (parser, &field))
-    /* Add the field to the record */
-    rec_mset_append (rec_record_mset (new), MSET_FIELD, (void *) field, MSET_ANY);
+    {
+      /* Add the field to the record */
+      rec_mset_append (rec_record_mset (new), MSET_FIELD, (void *) field, MSET_ANY);
+      char_end = parser->character;
+    }
   else
     {
       /* Expected a field.  */
@@ -454,8 +484,11 @@ rec_parse_record (rec_parser_t parser,
         {
           rec_parser_ungetc (parser, ci);
           if (rec_parse_comment (parser, &comment))
-            /* Add the comment to the record.  */
-            rec_mset_append (rec_record_mset (new), MSET_COMMENT, (void *) comment, MSET_ANY);
+            {
+              /* Add the comment to the record.  */
+              rec_mset_append (rec_record_mset (new), MSET_COMMENT, (void *) comment, MSET_ANY);
+              char_end = parser->character;
+            }
         }
       else if ((c == ' ') || (c == '\t'))
         {
@@ -487,8 +520,11 @@ rec_parse_record (rec_parser_t parser,
           /* Try to parse a field */
           rec_parser_ungetc (parser, ci);
           if (rec_parse_field (parser, &field))
-            /* Add the field to the record */
-            rec_mset_append (rec_record_mset (new), MSET_FIELD, (void *) field, MSET_ANY);
+            {
+              /* Add the field to the record */
+              rec_mset_append (rec_record_mset (new), MSET_FIELD, (void *) field, MSET_ANY);
+              char_end = parser->character;
+            }
           else
             {
               /* Parse error: field expected */
@@ -500,7 +536,12 @@ rec_parse_record (rec_parser_t parser,
     }
 
   if (ret)
-    *record = new;
+    {
+      /* Remember the extent of the text of the record, so it can be
+         copied verbatim by writers.  See rec_writer_set_source.  */
+      rec_record_set_char_size (new, char_end - char_start);
+      *record = new;
+    }
   else
     {
       rec_record_destroy (new);
@@ -521,6 +562,8 @@ rec_parse_rset (rec_parser_t parser,
   rec_record_t record;
   rec_comment_t comment;
   size_t comments_added = 0;
+  size_t records_taken = 0;
+  bool parsed;
 
   ret = false;
 
@@ -555,9 +598,28 @@ rec_parse_rset (rec_parser_t parser,
         }
       else
         {
-          /* Try to parse a record */
+          /* Try to parse a record.  If there is a prefilter then
+             read the text of the record first, and skip it if it
+             cannot contain the prefilter.  */
           rec_parser_ungetc (parser, c);
-          if (rec_parse_record (parser, &record))
+          if (parser->prefilter)
+            {
+              if (!rec_parser_read_record_text (parser))
+                {
+                  /* Out of memory.  */
+                  parser->error = REC_PARSER_ENOMEM;
+                  break;
+                }
+
+              if (!rec_parser_record_text_p (parser))
+                continue;
+
+              parsed = rec_parse_record_text (parser, &record);
+            }
+          else
+            parsed = rec_parse_record (parser, &record);
+
+          if (parsed)
             {
               /* Check if the parsed record is a descriptor.  In that
                  case, set it as the previous descriptor in the parser
@@ -570,8 +632,9 @@ rec_parse_rset (rec_parser_t parser,
                  set. */
               if (rec_record_field_p (record, FNAME(REC_FIELD_REC)))
                 {
-                  if ((rec_rset_num_records (new) == 0) &&
-                      (!rec_rset_descriptor (new)))
+                  if ((rec_rset_num_records (new) == 0)
+                      && (records_taken == 0)
+                      && (!rec_rset_descriptor (new)))
                     {
                       /* Special case: the first record found in the
                          input stream is a descriptor. */
@@ -588,7 +651,12 @@ rec_parse_rset (rec_parser_t parser,
               else
                 {
                   rec_record_set_container (record, new);
-                  rec_mset_append (rec_rset_mset (new), MSET_RECORD, (void *) record, MSET_ANY);
+                  if (parser->record_fn
+                      && parser->record_fn (record, new, parser->record_fn_data))
+                    /* The callback took the record.  */
+                    records_taken++;
+                  else
+                    rec_mset_append (rec_rset_mset (new), MSET_RECORD, (void *) record, MSET_ANY);
                 }
             }
           else
@@ -602,7 +670,8 @@ rec_parse_rset (rec_parser_t parser,
 
   if ((parser->error == REC_PARSER_NOERROR)
       && (rec_rset_descriptor (new)
-          || (rec_rset_num_records (new) > 0)))
+          || (rec_rset_num_records (new) > 0)
+          || (records_taken > 0)))
     ret = true;
 
   if (ret)
@@ -741,6 +810,40 @@ rec_parser_seek (rec_parser_t parser,
   return true;
 }
 
+bool
+rec_parser_set_prefilter (rec_parser_t parser,
+                          const char *str,
+                          bool case_insensitive)
+{
+  free (parser->prefilter);
+  parser->prefilter = NULL;
+
+  if (str && (str[0] != '\0') && !strchr (str, '\n'))
+    {
+      parser->prefilter = strdup (str);
+      if (!parser->prefilter)
+        {
+          /* Out of memory.  */
+          return false;
+        }
+
+      rec_search_init (&parser->prefilter_search,
+                       parser->prefilter,
+                       case_insensitive);
+    }
+
+  return true;
+}
+
+void
+rec_parser_set_record_callback (rec_parser_t parser,
+                                rec_parser_record_fn_t fn,
+                                void *data)
+{
+  parser->record_fn = fn;
+  parser->record_fn_data = data;
+}
+
 long
 rec_parser_tell (rec_parser_t parser)
 {
@@ -1155,8 +1258,154 @@ rec_parser_init_common (rec_parser_t parser,
   parser->character = 0;
   parser->prev_descriptor = NULL;
   parser->p = parser->in_buffer;
+  parser->prefilter = NULL;
+  parser->text = NULL;
+  parser->text_size = 0;
+  parser->text_alloc = 0;
+  parser->record_fn = NULL;
+  parser->record_fn_data = NULL;
 
   return true;
 }
 
+static bool
+rec_parser_read_record_text (rec_parser_t parser)
+{
+  /* Read the text of the record starting at the current position
+     into the text buffer of the parser.  The text includes the line
+     terminating the record, if any.  A record is terminated by an
+     empty line or by a line containing just blanks, unless the
+     previous line ended with a backslash: in that case the newline is
+     escaped and the line belongs to the previous field.  */
+
+  int ci;
+  size_t line_start;
+  bool continued = false;
+
+  parser->text_size = 0;
+  parser->text_line = parser->line;
+  parser->text_character = parser->character;
+
+  do
+    {
+      line_start = parser->text_size;
+      while ((ci = rec_parser_getc (parser)) != EOF)
+        {
+          if (parser->text_size + 1 >= parser->text_alloc)
+            {
+              size_t alloc;
+              char *text;
+
+              alloc = (parser->text_alloc == 0) ? 512 : 2 * parser->text_alloc;
+              text = realloc (parser->text, alloc);
+              if (!text)
+                {
+                  /* Out of memory.  */
+                  return false;
+                }
+
+              parser->text = text;
+              parser->text_alloc = alloc;
+            }
+
+          parser->text[parser->text_size++] = (char) ci;
+          if (((char) ci) == '\n')
+            {
+              break;
+            }
+        }
+
+      if (parser->text_size == line_start)
+        {
+          /* End of file.  */
+          break;
+        }
+
+      if ((line_start > 0)
+          && !continued
+          && ((parser->text[line_start] == '\n')
+              || (parser->text[line_start] == ' ')
+              || (parser->text[line_start] == '\t')))
+        {
+          /* End of record.  */
+          break;
+        }
+
+      continued = ((parser->text[line_start] != '#')
+                   && (parser->text_size - line_start >= 2)
+                   && (parser->text[parser->text_size - 1] == '\n')
+                   && (parser->text[parser->text_size - 2] == '\\'));
+    }
+  while (ci != EOF);
+
+  if (parser->text)
+    {
+      parser->text[parser->text_size] = '\0';
+    }
+
+  return true;
+}
+
+static bool
+rec_parser_record_text_p (rec_parser_t parser)
+{
+  /* Determine whether the text of the record in the text buffer of
+     the parser can contain the prefilter.  Records that can be
+     descriptors, i.e. containing some field whose name starts with %,
+     are always accepted.  So are records containing escaped newlines,
+     since these join lines in field values.  */
+
+  const char *text = parser->text;
+
+  if ((parser->text_size == 0)
+      || (text[0] == '%')
+      || strstr (text, "\n%")
+      || strstr (text, "\\\n"))
+    {
+      return true;
+    }
+
+  return rec_search_p (&parser->prefilter_search, text);
+}
+
+static bool
+rec_parse_record_text (rec_parser_t parser,
+                       rec_record_t *record)
+{
+  /* Parse a record from the text buffer of the parser, restoring the
+     input of the parser afterwards.  */
+
+  FILE *in_file = parser->in_file;
+  const char *in_buffer = parser->in_buffer;
+  size_t in_size = parser->in_size;
+  const char *p = parser->p;
+  size_t line = parser->line;
+  size_t character = parser->character;
+  bool eof = parser->eof;
+  bool ret;
+
+  parser->in_file = NULL;
+  parser->in_buffer = parser->text;
+  parser->in_size = parser->text_size;
+  parser->p = parser->text;
+  parser->line = parser->text_line;
+  parser->character = parser->text_character;
+  parser->eof = false;
+
+  ret = rec_parse_record (parser, record);
+
+  parser->in_file = in_file;
+  parser->in_buffer = in_buffer;
+  parser->in_size = in_size;
+  parser->p = p;
+  parser->eof = eof;
+  if (ret)
+    {
+      parser->line = line;
+      parser->character = character;
+    }
+
+  return ret;
+}
+
 /* End of rec-parser.c */
@@ -26,6 +26,9 @@
 #include <config.h>
 #include <stdlib.h>
 #include <string.h>
+#include <gl_linkedhash_list.h>
+#include <gl_list.h>
+#include <hash-pjw.h>
 
 #include <rec.h>
 #include <rec-utils.h>
@@ -54,6 +57,16 @@ struct rec_record_s
   size_t char_location;
   char *char_location_str;
 
+  /* Size of the text the record was read from, and number of elements
+     in the record when it was set.  */
+
+  size_t char_size;
+  size_t char_size_elems;
+
+  /* Whether the record was modified since it was read.  */
+
+  bool modified_p;
+
   /* The internal multi-set storing the data.  */
 
   rec_mset_t mset;
@@ -573,6 +586,36 @@ rec_record_set_char_location (rec_record_t record,
   asprintf (&(record->char_location_str), "%zu", record->char_location);
 }
 
+size_t
+rec_record_char_size (rec_record_t record)
+{
+  if (record->char_size_elems != rec_record_num_elems (record))
+    return 0;
+
+  return record->char_size;
+}
+
+void
+rec_record_set_char_size (rec_record_t record,
+                          size_t char_size)
+{
+  record->char_size = char_size;
+  record->char_size_elems = rec_record_num_elems (record);
+}
+
+bool
+rec_record_modified_p (rec_record_t record)
+{
+  return record->modified_p;
+}
+
+void
+rec_record_set_modified (rec_record_t record,
+                         bool modified_p)
+{
+  record->modified_p = modified_p;
+}
+
 bool
 rec_record_contains_value (rec_record_t record,
                            const char *str,
@@ -581,24 +624,14 @@ rec_record_contains_value (rec_record_t record,
   bool res = false;
   rec_mset_iterator_t iter;
   rec_field_t field;
-  const char *field_value;
-  char *occur;
+  struct rec_search_s search;
+
+  rec_search_init (&search, str, case_insensitive);
 
   iter = rec_mset_iterator (record->mset);
   while (rec_mset_iterator_next (&iter, MSET_FIELD, (const void **) &field, NULL))
     {
-      field_value = rec_field_value (field);
-
-      if (case_insensitive)
-        {
-          occur = strcasestr (field_value, str);
-        }
-      else
-        {
-          occur = strstr (field_value, str);
-        }
-
-      res = (occur != NULL);
+      res = rec_search_p (&search, rec_field_value (field));
       if (res)
         {
           break;
@@ -647,72 +680,65 @@ rec_record_set_container (rec_record_t record, void *container)
   record->container = container;
 }
 
-void
-rec_record_uniq (rec_record_t record)
+static bool
+rec_record_uniq_equals_fn (const void *elt1,
+                           const void *elt2)
 {
-  rec_mset_iterator_t iter1, iter2;
-  rec_mset_elem_t elem1;
-  rec_field_t field1, field2;
-  bool *to_remove;
-  size_t num_fields, i, j;
+  rec_field_t field1 = (rec_field_t) elt1;
+  rec_field_t field2 = (rec_field_t) elt2;
 
-  /* Create a map of the fields to remove and initialize all the
-     entries to false.  */
-
-  num_fields = rec_record_num_fields (record);
-  to_remove = malloc (sizeof(bool) * num_fields);
-  memset (to_remove, false, num_fields);
-
-  /* Iterate on the fields of the record an mark the fields that will
-     be removed in the removal mask.  */
+  return (rec_field_name_equal_p (rec_field_name (field1), rec_field_name (field2))
+          && (strcmp (rec_field_value (field1), rec_field_value (field2)) == 0));
+}
 
-  i = 0;
-  iter1 = rec_mset_iterator (record->mset);
-  while (rec_mset_iterator_next (&iter1, MSET_FIELD, (const void **) &field1, NULL))
-    {
-      if (!to_remove[i])
-        {
-          /* Mark any other occurrence of this field having the same
-             value for removal. */
+static size_t
+rec_record_uniq_hash_fn (const void *elt)
+{
+  rec_field_t field = (rec_field_t) elt;
 
-          j = 0;
-          iter2 = rec_mset_iterator (record->mset);
-          while (rec_mset_iterator_next (&iter2, MSET_FIELD, (const void **) &field2, NULL))
-            {
-              if ((j != i)
-                  && rec_field_name_equal_p (rec_field_name (field1), rec_field_name (field2))
-                  && rec_field_name_equal_p (rec_field_value (field1), rec_field_value (field2)))
-                {
-                  to_remove[j] = true;
-                }
-              
-              j++;
-            }
-          rec_mset_iterator_free (&iter2);
-        }
+  return (31 * hash_pjw (rec_field_name (field), SIZE_MAX))
+    ^ hash_pjw (rec_field_value (field), SIZE_MAX);
+}
 
-      i++;
-    }
-  rec_mset_iterator_free (&iter1);
+void
+rec_record_uniq (rec_record_t record)
+{
+  rec_mset_iterator_t iter;
+  rec_mset_elem_t elem;
+  rec_field_t field;
+  gl_list_t fields;
 
+  /* Keep a hash table with the distinct fields found so far, compared
+     by name and value, and remove the fields which are already in the
+     table.  */
 
-  /* Remove the fields marked for removal.  */
+  fields = gl_list_nx_create_empty (GL_LINKEDHASH_LIST,
+                                    rec_record_uniq_equals_fn,
+                                    rec_record_uniq_hash_fn,
+                                    NULL,
+                                    false);
+  if (!fields)
+    /* Out of memory.  */
+    return;
 
-  i = 0;
-  iter1 = rec_mset_iterator (record->mset);
-  while (rec_mset_iterator_next (&iter1, MSET_FIELD, (const void **) &field1, &elem1))
+  iter = rec_mset_iterator (record->mset);
+  while (rec_mset_iterator_next (&iter, MSET_FIELD, (const void **) &field, &elem))
     {
-      if (to_remove[i])
+      if (gl_list_search (fields, field))
         {
-          rec_mset_remove_elem (record->mset, elem1);
+          rec_mset_remove_elem (record->mset, elem);
+        }
+      else if (!gl_list_nx_add_last (fields, field))
+        {
+          /* Out of memory.  */
+          break;
         }
-
-      i++;
     }
+  rec_mset_iterator_free (&iter);
 
   /* Cleanup.  */
 
-  free (to_remove);
+  gl_list_free (fields);
 }
 
 void
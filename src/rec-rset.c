@@ -31,6 +31,9 @@
 #include <locale.h>
 #include <string.h>
 #include <parse-datetime.h>
+#include <gl_linkedhash_list.h>
+#include <gl_list.h>
+#include <hash-pjw.h>
 
 #if defined UUID_TYPE
 #  include <uuid/uuid.h>
@@ -61,6 +64,13 @@ struct rec_rset_fprops_s
   rec_type_t type; /* The field has an anonymous type.  */
   char *type_name; /* The field has a type in the types registry.  */
 
+  /* Cached next value of an integer auto field.  The cached value is
+     only valid while the record set contains AUTO_NUM_RECORDS
+     records.  */
+  bool auto_next_p;
+  int auto_next;
+  size_t auto_num_records;
+
   struct rec_rset_fprops_s *next;
 };
 
@@ -78,8 +88,10 @@ struct rec_rset_s
                             need to track it in order to write back
                             the record properly.  */
 
-  /* Field properties.  */
+  /* Field properties, and a hash table indexing them by field name.
+     The index can be NULL, in which case the list is scanned.  */
   rec_rset_fprops_t field_props;
+  gl_list_t field_props_index;
 
   /* Type registry.  */
   rec_type_reg_t type_reg;
@@ -96,6 +108,10 @@ struct rec_rset_s
   rec_sex_t *constraints;
   size_t num_constraints;
 
+  /* Whether records were inserted, deleted or modified since the
+     record set was read.  */
+  bool modified_p;
+
   /* Storage for records and comments.  */
   int record_type;
   int comment_type;
@@ -125,6 +141,9 @@ static bool rec_rset_type_field_p (const char *str);
 static rec_fex_t rec_rset_type_field_fex (const char *str);
 static char *rec_rset_type_field_type (const char *str);
 
+static bool rec_rset_props_equals_fn (const void *elt1,
+                                      const void *elt2);
+static size_t rec_rset_props_hash_fn (const void *elt);
 static rec_rset_fprops_t rec_rset_get_props (rec_rset_t rset,
                                              const char *fname,
                                              bool create_p);
@@ -194,6 +213,18 @@ rec_rset_new (void)
 
           /* No field properties, initially.  */
           rset->field_props = NULL;
+          rset->field_props_index =
+            gl_list_nx_create_empty (GL_LINKEDHASH_LIST,
+                                     rec_rset_props_equals_fn,
+                                     rec_rset_props_hash_fn,
+                                     NULL,
+                                     false);
+          if (!rset->field_props_index)
+            {
+              /* Out of memory.  */
+              rec_rset_destroy (rset);
+              return NULL;
+            }
 
           /* No order by field, initially.  */
           rset->order_by_fields = NULL;
@@ -235,7 +266,11 @@ rec_rset_destroy (rec_rset_t rset)
   if (rset)
     {
       rec_record_destroy (rset->descriptor);
-      rec_type_reg_destroy (rset->type_reg);
+      if (rset->type_reg)
+        {
+          /* Copies made by rec_rset_dup don't have a registry.  */
+          rec_type_reg_destroy (rset->type_reg);
+        }
 
       for (i = 0; i < rset->num_constraints; i++)
         {
@@ -243,6 +278,11 @@ rec_rset_destroy (rec_rset_t rset)
         }
       free (rset->constraints);
 
+      if (rset->field_props_index)
+        {
+          gl_list_free (rset->field_props_index);
+        }
+
       props = rset->field_props;
       while (props)
         {
@@ -283,6 +323,7 @@ rec_rset_dup (rec_rset_t rset)
       /* XXX: make copies of the following structures.  */
       new->type_reg = NULL;
       new->field_props = NULL;
+      new->field_props_index = NULL;
       new->constraints = NULL;
       new->num_constraints = 0;
 
@@ -356,6 +397,19 @@ rec_rset_set_descriptor (rec_rset_t rset, rec_record_t record)
   rec_rset_update_sex_constraints (rset);
 }
 
+bool
+rec_rset_modified_p (rec_rset_t rset)
+{
+  return rset->modified_p;
+}
+
+void
+rec_rset_set_modified (rec_rset_t rset,
+                       bool modified_p)
+{
+  rset->modified_p = modified_p;
+}
+
 size_t
 rec_rset_descriptor_pos (rec_rset_t rset)
 {
@@ -598,32 +652,80 @@ rec_rset_auto (rec_rset_t rset)
   return fex;
 }
 
-#if defined REC_CRYPT_SUPPORT
-
-bool
-rec_rset_field_confidential_p (rec_rset_t rset,
-                               const char *field_name)
+rec_fex_t
+rec_rset_declared_fields (rec_rset_t rset)
 {
   rec_fex_t fex;
-  size_t fex_size;
+  rec_fex_t names;
+  rec_field_t field;
+  rec_mset_iterator_t iter;
   size_t i;
-  bool result = false;
-  const char *fex_field_name;
 
-  fex = rec_rset_confidential (rset);
-  fex_size = rec_fex_size (fex);
+  fex = rec_fex_new (NULL, REC_FEX_SIMPLE);
+  if (!fex)
+    /* Out of memory.  */
+    return NULL;
+
+  if (!rset->descriptor)
+    return fex;
 
-  for (i = 0; i < fex_size; i++)
+  iter = rec_mset_iterator (rec_record_mset (rset->descriptor));
+  while (rec_mset_iterator_next (&iter, MSET_FIELD, (const void**) &field, NULL))
     {
-      fex_field_name = rec_fex_elem_field_name (rec_fex_get (fex, i));
-      if (rec_field_name_equal_p (field_name, fex_field_name))
+      const char *field_name = rec_field_name (field);
+      const char *field_value = rec_field_value (field);
+
+      /* Invalid lists of field names are ignored, like in
+         rec_rset_update_field_props.  */
+
+      names = NULL;
+      if (rec_field_name_equal_p (field_name, FNAME(REC_FIELD_TYPE)))
         {
-          result = true;
-          break;
+          if (rec_rset_type_field_p (field_value))
+            names = rec_rset_type_field_fex (field_value);
+        }
+      else if (rec_field_name_equal_p (field_name, FNAME(REC_FIELD_KEY))
+               || rec_field_name_equal_p (field_name, FNAME(REC_FIELD_MANDATORY))
+               || rec_field_name_equal_p (field_name, FNAME(REC_FIELD_ALLOWED)))
+        names = rec_fex_new (field_value, REC_FEX_SIMPLE);
+
+      if (!names)
+        continue;
+
+      for (i = 0; i < rec_fex_size (names); i++)
+        {
+          const char *name = rec_fex_elem_field_name (rec_fex_get (names, i));
+          if (!rec_fex_member_p (fex, name, -1, -1)
+              && !rec_fex_append (fex, name, -1, -1))
+            {
+              /* Out of memory.  */
+              rec_fex_destroy (names);
+              rec_fex_destroy (fex);
+              fex = NULL;
+              break;
+            }
         }
+
+      if (!fex)
+        break;
+
+      rec_fex_destroy (names);
     }
+  rec_mset_iterator_free (&iter);
 
-  return result;
+  return fex;
+}
+
+#if defined REC_CRYPT_SUPPORT
+
+bool
+rec_rset_field_confidential_p (rec_rset_t rset,
+                               const char *field_name)
+{
+  rec_rset_fprops_t props;
+
+  props = rec_rset_get_props (rset, field_name, false);
+  return (props && props->confidential_p);
 }
 
 rec_fex_t
@@ -912,6 +1014,18 @@ rec_rset_add_auto_fields (rec_rset_t rset,
   return rset;
 }
 
+void
+rec_rset_reset_auto_fields (rec_rset_t rset)
+{
+  rec_rset_fprops_t props = rset->field_props;
+
+  while (props)
+    {
+      props->auto_next_p = false;
+      props = props->next;
+    }
+}
+
 size_t
 rec_rset_num_sex_constraints (rec_rset_t rset)
 {
@@ -1208,6 +1322,7 @@ rec_rset_update_field_props (rec_rset_t rset)
     {
       props->key_p = false;
       props->auto_p = false;
+      props->auto_next_p = false;
       if (props->type)
         {
           rec_type_destroy (props->type);
@@ -1302,7 +1417,10 @@ rec_rset_update_field_props (rec_rset_t rset)
               rec_skip_blanks (&field_value);
               rec_parse_regexp (&field_value, "^" REC_RECORD_TYPE_RE, &type_name);
               props = rec_rset_get_props (rset, type_name, true);
-              props->key_p = true;
+              if (props)
+                {
+                  props->key_p = true;
+                }
               free (type_name);
             }
 
@@ -1530,16 +1648,40 @@ rec_rset_get_props (rec_rset_t rset,
                     bool create_p)
 {
   rec_rset_fprops_t props = NULL;
-  
-  props = rset->field_props;
-  while (props)
+
+  if (!fname)
     {
-      if (rec_field_name_equal_p (fname, props->fname))
+      /* No field has that name.  This happens for example when
+         looking up the properties of the key of a record set not
+         having a key.  */
+      return NULL;
+    }
+
+  if (rset->field_props_index)
+    {
+      struct rec_rset_fprops_s key;
+      gl_list_node_t node;
+
+      key.fname = (char *) fname;
+      node = gl_list_search (rset->field_props_index, &key);
+      if (node)
         {
-          break;
+          props = (rec_rset_fprops_t) gl_list_node_value (rset->field_props_index,
+                                                          node);
         }
+    }
+  else
+    {
+      props = rset->field_props;
+      while (props)
+        {
+          if (rec_field_name_equal_p (fname, props->fname))
+            {
+              break;
+            }
 
-      props = props->next;
+          props = props->next;
+        }
     }
 
   if (!props && create_p)
@@ -1550,7 +1692,18 @@ rec_rset_get_props (rec_rset_t rset,
       if (props)
         {
           props->fname = strdup (fname);
+          if (!props->fname
+              || (rset->field_props_index
+                  && !gl_list_nx_add_last (rset->field_props_index, props)))
+            {
+              /* Out of memory.  */
+              free (props->fname);
+              free (props);
+              return NULL;
+            }
+
           props->auto_p = false;
+          props->auto_next_p = false;
           props->key_p = false;
 
 #if defined REC_CRYPT_SUPPORT
@@ -1569,46 +1722,90 @@ rec_rset_get_props (rec_rset_t rset,
   return props;
 }
 
+static bool
+rec_rset_props_equals_fn (const void *elt1,
+                          const void *elt2)
+{
+  return rec_field_name_equal_p (((rec_rset_fprops_t) elt1)->fname,
+                                 ((rec_rset_fprops_t) elt2)->fname);
+}
+
+static size_t
+rec_rset_props_hash_fn (const void *elt)
+{
+  return hash_pjw (((rec_rset_fprops_t) elt)->fname, SIZE_MAX);
+}
+
 static bool
 rec_rset_add_auto_field_int (rec_rset_t rset,
                              const char *field_name,
                              rec_record_t record)
 {
+  rec_rset_fprops_t props;
   rec_mset_iterator_t iter;
   rec_record_t rec;
   rec_field_t field;
-  size_t num_fields, i;
+  size_t num_fields, num_records, i;
   int auto_value, field_value;
   char *end;
   char *auto_value_str;
 
-  /* Find the auto value.  */
+  /* Find the auto value.  The high-water mark of the field is cached
+     in its properties, assuming that RECORD will be added to the
+     record set unless it is already stored in it.  This makes
+     consecutive insertions of records constant-time operations.  If
+     the number of records in the record set is not the expected one
+     then the record set was modified by other means, and the records
+     are scanned again.  */
 
-  auto_value = 0;
+  props = rec_rset_get_props (rset, field_name, true);
+  if (!props)
+    {
+      /* Out of memory.  */
+      return false;
+    }
 
-  iter = rec_mset_iterator (rec_rset_mset (rset));
-  while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &rec, NULL))
+  num_records = rec_rset_num_records (rset);
+  if (props->auto_next_p && (props->auto_num_records == num_records))
+    {
+      auto_value = props->auto_next;
+    }
+  else
     {
-      num_fields = rec_record_get_num_fields_by_name (rec, field_name);
-      for (i = 0; i < num_fields; i++)
+      auto_value = 0;
+
+      iter = rec_mset_iterator (rec_rset_mset (rset));
+      while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &rec, NULL))
         {
-          field = rec_record_get_field_by_name (rec, field_name, i);
-          
-          /* Ignore fields that can't be converted to integer
-             values.  */
-          errno = 0;
-          field_value = strtol (rec_field_value (field), &end, 10);
-          if ((errno == 0) && (*end == '\0'))
+          num_fields = rec_record_get_num_fields_by_name (rec, field_name);
+          for (i = 0; i < num_fields; i++)
             {
-              if (auto_value <= field_value)
+              field = rec_record_get_field_by_name (rec, field_name, i);
+
+              /* Ignore fields that can't be converted to integer
+                 values.  */
+              errno = 0;
+              field_value = strtol (rec_field_value (field), &end, 10);
+              if ((errno == 0) && (*end == '\0'))
                 {
-                  auto_value = field_value + 1;
+                  if (auto_value <= field_value)
+                    {
+                      auto_value = field_value + 1;
+                    }
                 }
             }
         }
+
+      rec_mset_iterator_free (&iter);
     }
 
-  rec_mset_iterator_free (&iter);
+  props->auto_next_p = true;
+  props->auto_next = auto_value + 1;
+  props->auto_num_records = num_records;
+  if (rec_record_container (record) != (void *) rset)
+    {
+      props->auto_num_records++;
+    }
        
   /* Create and insert the auto field.  */
 
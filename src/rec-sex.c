@@ -44,6 +44,7 @@ struct rec_sex_s
 {
   rec_sex_ast_t ast;
   rec_sex_parser_t parser;
+  char *expr;              /* Source of the compiled sex.  */
 };
 
 #define REC_SEX_VAL_INT  0
@@ -66,6 +67,7 @@ static struct rec_sex_val_s rec_sex_eval_node (rec_sex_t sex,
                                                bool *status);
 static bool rec_sex_op_real_p (struct rec_sex_val_s op1,
                                struct rec_sex_val_s op2);
+static const char *rec_sex_literal_node (rec_sex_ast_node_t node);
 
 /*
  * Public functions.
@@ -86,6 +88,7 @@ rec_sex_new (bool case_insensitive)
 
       /* Initialize a new AST.  */
       new->ast = NULL;
+      new->expr = NULL;
     }
 
   return new;
@@ -105,7 +108,8 @@ rec_sex_destroy (rec_sex_t sex)
         {
           rec_sex_ast_destroy (sex->ast);
         }
-      
+
+      free (sex->expr);
       free (sex);  /* yeah! :D */
     }
 }
@@ -120,10 +124,43 @@ rec_sex_compile (rec_sex_t sex,
   if (res)
     {
       sex->ast = rec_sex_parser_ast (sex->parser);
+
+      free (sex->expr);
+      sex->expr = strdup (expr);
+      if (!sex->expr)
+        {
+          /* Out of memory.  */
+          return false;
+        }
     }
   return res;
 }
 
+rec_sex_t
+rec_sex_dup (rec_sex_t sex)
+{
+  rec_sex_t new;
+
+  if (!sex->expr)
+    {
+      /* The sex is not compiled.  */
+      return NULL;
+    }
+
+  new = rec_sex_new (rec_sex_parser_case_insensitive (sex->parser));
+  if (new)
+    {
+      if (!rec_sex_compile (new, sex->expr))
+        {
+          /* Out of memory.  */
+          rec_sex_destroy (new);
+          new = NULL;
+        }
+    }
+
+  return new;
+}
+
 #define EXEC_AST(RECORD)                                                \
   do                                                                    \
     {                                                                   \
@@ -267,6 +304,18 @@ rec_sex_eval (rec_sex_t sex,
   return res;
 }
 
+const char *
+rec_sex_literal (rec_sex_t sex)
+{
+  if (!sex->ast)
+    {
+      /* The sex is not compiled.  */
+      return NULL;
+    }
+
+  return rec_sex_literal_node (rec_sex_ast_top (sex->ast));
+}
+
 void
 rec_sex_print_ast (rec_sex_t sex)
 {
@@ -1094,6 +1143,63 @@ rec_sex_eval_node (rec_sex_t sex,
   return res;
 }
 
+static const char *
+rec_sex_literal_node (rec_sex_ast_node_t node)
+{
+  const char *res = NULL;
+  rec_sex_ast_node_t child1;
+  rec_sex_ast_node_t child2;
+
+  switch (rec_sex_ast_node_type (node))
+    {
+    case REC_SEX_OP_EQL:
+      {
+        /* A field compared with a string literal.  Note that string
+           comparisons are always performed if both operands are
+           strings, and that missing fields evaluate to the empty
+           string.  */
+
+        child1 = rec_sex_ast_node_child (node, 0);
+        child2 = rec_sex_ast_node_child (node, 1);
+
+        if (rec_sex_ast_node_type (child1) == REC_SEX_STR)
+          {
+            rec_sex_ast_node_t tmp = child1;
+            child1 = child2;
+            child2 = tmp;
+          }
+
+        if ((rec_sex_ast_node_type (child1) == REC_SEX_NAME)
+            && (rec_sex_ast_node_type (child2) == REC_SEX_STR)
+            && (rec_sex_ast_node_str (child2)[0] != '\0'))
+          {
+            res = rec_sex_ast_node_str (child2);
+          }
+
+        break;
+      }
+    case REC_SEX_OP_AND:
+      {
+        /* Both operands must be true, so any literal required by
+           either of them will do.  */
+
+        res = rec_sex_literal_node (rec_sex_ast_node_child (node, 0));
+        if (!res)
+          {
+            res = rec_sex_literal_node (rec_sex_ast_node_child (node, 1));
+          }
+
+        break;
+      }
+    default:
+      {
+        break;
+      }
+    }
+
+  return res;
+}
+
 static bool
 rec_sex_op_real_p (struct rec_sex_val_s op1,
                    struct rec_sex_val_s op2)
@@ -27,11 +27,16 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <ctype.h>
 #include <regex.h>
 #include <string.h>
 #include <limits.h>
 #include <regex.h>
 #include <parse-datetime.h>
+#include <gl_linkedhash_list.h>
+#include <gl_list.h>
+#include <hash-pjw.h>
+#include <glthread/lock.h>
 #include <gettext.h>
 #define _(str) dgettext (PACKAGE, str)
 
@@ -74,7 +79,10 @@
 #define REC_TYPE_NO_BLANKS_RE REC_TYPE_NO_BLANK_RE "+"
 #define REC_TYPE_ZBLANKS_RE REC_TYPE_BLANK_RE "*"
 
-/* Regular expressions denoting values.  */
+/* Regular expressions denoting values.  The values of the int, bool,
+   real, line and email types are checked by hand-written scanners
+   accepting exactly the same strings than the regular expressions
+   below.  */
 #define REC_TYPE_INT_VALUE_RE                   \
   "^" REC_TYPE_ZBLANKS_RE REC_INT_RE REC_TYPE_ZBLANKS_RE "$"
 
@@ -224,6 +232,27 @@
  * Data types.
  */
 
+/* Regular expressions used to check the values of the built-in
+   types not having a scanner.  They are compiled just once per
+   process, the first time a value is checked.  */
+
+enum rec_type_value_re_e
+{
+  REC_TYPE_VALUE_RE_ENUM,
+  REC_TYPE_VALUE_RE_FIELD,
+  REC_TYPE_VALUE_RE_NUM
+};
+
+static const char *rec_type_value_res[REC_TYPE_VALUE_RE_NUM] =
+  {
+    REC_TYPE_ENUM_VALUE_RE,
+    REC_TYPE_FIELD_VALUE_RE
+  };
+
+static regex_t rec_type_value_regexps[REC_TYPE_VALUE_RE_NUM];
+static bool rec_type_value_regexps_p[REC_TYPE_VALUE_RE_NUM];
+gl_once_define (static, rec_type_value_regexps_once)
+
 struct rec_type_s
 {
   char *name;                 /* Name of the type.  May be NULL in an
@@ -233,6 +262,9 @@ struct rec_type_s
                                  create the type.  */
   size_t size;                /* Used for enumerations: number of
                                  names.  */
+  gl_list_t names_set;        /* Used for enumerations having at least
+                                 REC_TYPE_ENUM_HASH_MIN names: hash
+                                 table with the names.  */
 
   union
   {
@@ -246,6 +278,8 @@ struct rec_type_s
   } data;
 };
 
+#define REC_TYPE_ENUM_HASH_MIN 8
+
 #define REC_TYPE_REG_ALLOC_TYPES 100
 
 struct rec_type_reg_entry_s
@@ -269,6 +303,19 @@ struct rec_type_reg_s
 
 static enum rec_type_kind_e rec_type_parse_type_kind (char *str);
 
+static bool rec_type_int_value_p (const char *str);
+static bool rec_type_bool_value_p (const char *str);
+static bool rec_type_bool_true_p (const char *str);
+static bool rec_type_real_value_p (const char *str);
+static bool rec_type_email_value_p (const char *str);
+static void rec_type_compile_value_regexps (void);
+static bool rec_type_match_value (enum rec_type_value_re_e re,
+                                  const char *str);
+static bool rec_type_enum_names_equals_fn (const void *elt1,
+                                           const void *elt2);
+static size_t rec_type_enum_names_hash_fn (const void *elt);
+static void rec_type_build_enum_names_set (rec_type_t type);
+
 static bool rec_type_check_int (rec_type_t type, const char *str, rec_buf_t errors);
 static bool rec_type_check_bool (rec_type_t type, const char *str, rec_buf_t errors);
 static bool rec_type_check_range (rec_type_t type, const char *str, rec_buf_t errors);
@@ -362,6 +409,7 @@ rec_type_new (const char *str)
     }
   new->name = NULL; /* Newly created types are anonyous. */
   new->size = 0;
+  new->names_set = NULL;
 
   rec_skip_blanks (&p);
 
@@ -684,6 +732,11 @@ rec_type_destroy (rec_type_t type)
     {
       if (type->kind == REC_TYPE_ENUM)
         {
+          if (type->names_set)
+            {
+              gl_list_free (type->names_set);
+            }
+
           for (i = 0; i < type->size; i++)
             {
               free (type->data.names[i]);
@@ -1030,10 +1083,8 @@ rec_type_values_cmp (rec_type_t type,
 
         /* Boolean fields storing 'false' come first.  */
             
-        bool1 = rec_match (val1,
-                           REC_TYPE_ZBLANKS_RE "(" REC_TYPE_BOOL_TRUE_VALUES_RE ")" REC_TYPE_ZBLANKS_RE);
-        bool2 = rec_match (val2,
-                           REC_TYPE_ZBLANKS_RE "(" REC_TYPE_BOOL_TRUE_VALUES_RE ")" REC_TYPE_ZBLANKS_RE);
+        bool1 = rec_type_bool_true_p (val1);
+        bool2 = rec_type_bool_true_p (val2);
 
         if (!bool1 && bool2)
           {
@@ -1172,7 +1223,7 @@ rec_type_check_int (rec_type_t type,
 {
   bool ret;
 
-  ret = rec_match (str, REC_TYPE_INT_VALUE_RE);
+  ret = rec_type_int_value_p (str);
   if (!ret && errors)
     {
       rec_buf_puts (_("invalid integer."), errors);
@@ -1202,7 +1253,7 @@ rec_type_check_field (rec_type_t type,
 {
   bool ret;
 
-  ret = rec_match (str, REC_TYPE_FIELD_VALUE_RE);
+  ret = rec_type_match_value (REC_TYPE_VALUE_RE_FIELD, str);
   if (!ret && errors)
     {
       rec_buf_puts (_("invalid 'field' value."), errors);
@@ -1243,7 +1294,7 @@ rec_type_check_bool (rec_type_t type,
 {
   bool ret;
 
-  ret = rec_match (str, REC_TYPE_BOOL_VALUE_RE);
+  ret = rec_type_bool_value_p (str);
   if (!ret && errors)
     {
       rec_buf_puts (_("invalid 'bool' value."), errors);
@@ -1296,7 +1347,7 @@ rec_type_check_real (rec_type_t type,
 {
   bool ret;
 
-  ret = rec_match (str, REC_TYPE_REAL_VALUE_RE);
+  ret = rec_type_real_value_p (str);
   if (!ret && errors)
     {
       rec_buf_puts (_("invalid 'real' value."), errors);
@@ -1335,7 +1386,7 @@ rec_type_check_line (rec_type_t type,
 {
   bool ret;
 
-  ret = rec_match (str, REC_TYPE_LINE_VALUE_RE);
+  ret = (strchr (str, '\n') == NULL);
   if (!ret && errors)
     {
       rec_buf_puts (_("invalid 'line' value."), errors);
@@ -1393,7 +1444,7 @@ rec_type_check_email (rec_type_t type,
 {
   bool ret;
 
-  ret = rec_match (str, REC_TYPE_EMAIL_VALUE_RE);
+  ret = rec_type_email_value_p (str);
   if (!ret && errors)
     {
       rec_buf_puts (_("invalid email."), errors);
@@ -1409,9 +1460,11 @@ rec_type_check_enum (rec_type_t type,
 {
   size_t i;
   const char *p, *b;
-  char name[100];
+  char name_buf[100];
+  char *name;
+  bool found = false;
 
-  if (rec_match (str, REC_TYPE_ENUM_VALUE_RE))
+  if (rec_type_match_value (REC_TYPE_VALUE_RE_ENUM, str))
     {
       /* Get the name from STR.  */
       p = str;
@@ -1428,15 +1481,46 @@ rec_type_check_enum (rec_type_t type,
                    || (*p == '_')
                    || (*p == '-')))
         {
-          name[p - b] = *p;
           p++;
         }
+
+      name = name_buf;
+      if ((size_t) (p - b) >= sizeof (name_buf))
+        {
+          name = malloc (p - b + 1);
+          if (!name)
+            {
+              /* Out of memory.  */
+              return false;
+            }
+        }
+      memcpy (name, b, p - b);
       name[p - b] = '\0';
       
       /* Check for the name in the enum types.  */
-      for (i = 0; i < type->size; i++)
-        if (strcmp (name, type->data.names[i]) == 0)
+      if (type->names_set)
+        {
+          found = (gl_list_search (type->names_set, name) != NULL);
+        }
+      else
+        {
+          for (i = 0; i < type->size; i++)
+            if (strcmp (name, type->data.names[i]) == 0)
+              {
+                found = true;
+                break;
+              }
+        }
+
+      if (name != name_buf)
+        {
+          free (name);
+        }
+
+      if (found)
+        {
           return true;
+        }
     }
 
   if (errors)
@@ -1540,10 +1624,274 @@ rec_type_parse_enum (const char *str, rec_type_t type)
           free (type->data.names[i]);
         }
     }
+  else
+    {
+      rec_type_build_enum_names_set (type);
+    }
 
   return p;
 }
 
+static bool
+rec_type_enum_names_equals_fn (const void *elt1,
+                               const void *elt2)
+{
+  return (strcmp ((const char *) elt1, (const char *) elt2) == 0);
+}
+
+static size_t
+rec_type_enum_names_hash_fn (const void *elt)
+{
+  return hash_pjw (elt, SIZE_MAX);
+}
+
+static void
+rec_type_build_enum_names_set (rec_type_t type)
+{
+  /* The names in the table are the ones in the names array of the
+     type, which are not copied.  The table is just an optimization,
+     so if it can't be built due to an out-of-memory condition then
+     the names are looked up linearly.  */
+
+  size_t i;
+
+  if (type->size < REC_TYPE_ENUM_HASH_MIN)
+    {
+      return;
+    }
+
+  type->names_set = gl_list_nx_create_empty (GL_LINKEDHASH_LIST,
+                                             rec_type_enum_names_equals_fn,
+                                             rec_type_enum_names_hash_fn,
+                                             NULL,
+                                             false);
+  if (!type->names_set)
+    {
+      /* Out of memory.  */
+      return;
+    }
+
+  for (i = 0; i < type->size; i++)
+    {
+      if (!gl_list_search (type->names_set, type->data.names[i])
+          && !gl_list_nx_add_last (type->names_set, type->data.names[i]))
+        {
+          /* Out of memory.  */
+          gl_list_free (type->names_set);
+          type->names_set = NULL;
+          return;
+        }
+    }
+}
+
+static bool
+rec_type_int_value_p (const char *str)
+{
+  /* Scanner for REC_TYPE_INT_VALUE_RE.  */
+
+  const char *p = str;
+
+  rec_skip_blanks (&p);
+
+  if (*p == '-')
+    {
+      p++;
+    }
+
+  if ((p[0] == '0') && (p[1] == 'x'))
+    {
+      /* Hexadecimal number.  At least one digit is required.  */
+      p += 2;
+      if (!isxdigit ((unsigned char) *p))
+        {
+          return false;
+        }
+      while (isxdigit ((unsigned char) *p))
+        {
+          p++;
+        }
+    }
+  else
+    {
+      /* Decimal or octal number.  */
+      if (!rec_digit_p (*p))
+        {
+          return false;
+        }
+      while (rec_digit_p (*p))
+        {
+          p++;
+        }
+    }
+
+  rec_skip_blanks (&p);
+  return (*p == '\0');
+}
+
+static bool
+rec_type_bool_value_p (const char *str)
+{
+  /* Scanner for REC_TYPE_BOOL_VALUE_RE.  */
+
+  static const char *values[] = { "1", "yes", "true", "0", "no", "false", NULL };
+  const char *p = str;
+  size_t i, len;
+
+  rec_skip_blanks (&p);
+
+  for (i = 0; values[i]; i++)
+    {
+      len = strlen (values[i]);
+      if (strncmp (p, values[i], len) == 0)
+        {
+          p += len;
+          rec_skip_blanks (&p);
+          return (*p == '\0');
+        }
+    }
+
+  return false;
+}
+
+static bool
+rec_type_bool_true_p (const char *str)
+{
+  /* Determine whether STR contains a true value, like the unanchored
+     regexp ZBLANKS (REC_TYPE_BOOL_TRUE_VALUES_RE) ZBLANKS used to
+     do.  */
+
+  return ((strchr (str, '1') != NULL)
+          || (strstr (str, "yes") != NULL)
+          || (strstr (str, "true") != NULL));
+}
+
+static bool
+rec_type_real_value_p (const char *str)
+{
+  /* Scanner for REC_TYPE_REAL_VALUE_RE.  Note that both the integral
+     and the fractional parts are optional.  */
+
+  const char *p = str;
+
+  rec_skip_blanks (&p);
+
+  if (*p == '-')
+    {
+      p++;
+    }
+
+  while (rec_digit_p (*p))
+    {
+      p++;
+    }
+
+  if (*p == '.')
+    {
+      /* The fractional part requires at least one digit.  */
+      p++;
+      if (!rec_digit_p (*p))
+        {
+          return false;
+        }
+      while (rec_digit_p (*p))
+        {
+          p++;
+        }
+    }
+
+  rec_skip_blanks (&p);
+  return (*p == '\0');
+}
+
+static bool
+rec_type_email_value_p (const char *str)
+{
+  /* Scanner for REC_TYPE_EMAIL_VALUE_RE.  The local part is made of
+     the characters preceding the '@'.  The domain is the longest
+     sequence of domain characters following it, and it must end with
+     a dot followed by two to four letters.  Only blanks are allowed
+     after the domain.  */
+
+  const char *p = str;
+  const char *domain, *tld;
+
+  rec_skip_blanks (&p);
+
+  /* Local part.  */
+  if (*p == '@')
+    {
+      return false;
+    }
+  while (*p != '@')
+    {
+      if (!(rec_letter_p (*p) || rec_digit_p (*p)
+            || (*p == '.') || (*p == '_') || (*p == '%')
+            || (*p == '+') || (*p == '-')))
+        {
+          return false;
+        }
+      p++;
+    }
+  p++;
+
+  /* Domain.  */
+  domain = p;
+  while (rec_letter_p (*p) || rec_digit_p (*p)
+         || (*p == '.') || (*p == '-'))
+    {
+      p++;
+    }
+
+  tld = p;
+  while ((tld > domain) && rec_letter_p (*(tld - 1)))
+    {
+      tld--;
+    }
+
+  if (((p - tld) < 2) || ((p - tld) > 4)
+      || ((tld - domain) < 2)
+      || (*(tld - 1) != '.'))
+    {
+      return false;
+    }
+
+  rec_skip_blanks (&p);
+  return (*p == '\0');
+}
+
+static void
+rec_type_compile_value_regexps (void)
+{
+  size_t i;
+
+  for (i = 0; i < REC_TYPE_VALUE_RE_NUM; i++)
+    {
+      rec_type_value_regexps_p[i] =
+        (regcomp (&rec_type_value_regexps[i],
+                  rec_type_value_res[i],
+                  REG_EXTENDED) == 0);
+    }
+}
+
+static bool
+rec_type_match_value (enum rec_type_value_re_e re,
+                      const char *str)
+{
+  /* The compiled regexps are never freed, since they can be used
+     until the process terminates.  If some of them could not be
+     compiled then fall back to rec_match, which reports the
+     error.  */
+
+  gl_once (rec_type_value_regexps_once, rec_type_compile_value_regexps);
+
+  if (!rec_type_value_regexps_p[re])
+    {
+      return rec_match (str, rec_type_value_res[re]);
+    }
+
+  return (regexec (&rec_type_value_regexps[re], str, 0, NULL, 0) == 0);
+}
+
 static const char *
 rec_type_parse_regexp_type (const char *str, rec_type_t type)
 {
@@ -30,10 +30,48 @@
 #include <gettext.h>
 #define _(str) dgettext (PACKAGE, str)
 #include <string.h>
+#include <c-ctype.h>
 #include <locale.h>
+#include <nproc.h>
+#include <glthread/lock.h>
+#include <glthread/cond.h>
+#include <glthread/thread.h>
 
 #include <rec-utils.h>
 
+/* Pools of threads.  */
+
+struct rec_pool_thread_s
+{
+  rec_pool_t pool;
+  size_t worker;
+  gl_thread_t thread;
+};
+
+struct rec_pool_s
+{
+  size_t num_items;
+  size_t chunk_size;
+  size_t num_chunks;
+  size_t num_workers;
+  size_t ahead;
+  rec_pool_fn_t process_fn;
+  char *workers;
+  size_t worker_size;
+  struct rec_pool_thread_s *threads;
+  size_t num_threads;             /* Number of launched threads.  */
+
+  gl_lock_define (, lock);        /* Protects the fields below.  */
+  gl_cond_define (, cond);        /* Signaled when any of them
+                                     changes.  */
+  bool *done;                     /* Processed chunks.  */
+  size_t next_chunk;
+  size_t released_chunks;
+  bool error;
+};
+
+static void *rec_pool_worker (void *arg);
+
 bool
 rec_atoi (const char *str,
           int *number)
@@ -444,4 +482,353 @@ rec_concat_strings (const char *str1,
   return res;
 }
 
+void
+rec_search_init (struct rec_search_s *search,
+                 const char *str,
+                 bool case_insensitive)
+{
+  const char *p;
+
+  search->str = str;
+  search->len = strlen (str);
+  search->case_insensitive = case_insensitive;
+
+  /* Precompute the set of bytes that can start a match of STR, which
+     is used to quickly locate candidate positions in the searched
+     text.  ASCII letters are folded when performing a
+     case-insensitive search.  If STR is empty, or if it contains
+     non-ASCII characters and the search is case-insensitive, then the
+     set is left empty and rec_search_p falls back to strstr or
+     strcasestr, the latter honoring the current locale.  */
+
+  search->accept[0] = str[0];
+  search->accept[1] = '\0';
+  search->accept[2] = '\0';
+
+  if (case_insensitive)
+    {
+      for (p = str; *p; p++)
+        {
+          if (!c_isascii ((unsigned char) *p))
+            {
+              search->accept[0] = '\0';
+              return;
+            }
+        }
+
+      search->accept[0] = c_tolower ((unsigned char) str[0]);
+      if (c_toupper ((unsigned char) str[0]) != search->accept[0])
+        {
+          search->accept[1] = c_toupper ((unsigned char) str[0]);
+        }
+    }
+}
+
+bool
+rec_search_p (struct rec_search_s *search,
+              const char *text)
+{
+  /* Candidate positions are located using strchr or strpbrk, which
+     are heavily optimized in most C libraries, and then discarded as
+     early as possible by checking the last byte of the match before
+     comparing the rest of it.  */
+
+  const char *str = search->str;
+  size_t str_len = search->len;
+  const char *accept = search->accept;
+  const char *p;
+  const char *last;
+  size_t text_len, i;
+
+  if (accept[0] == '\0')
+    {
+      if (search->case_insensitive)
+        {
+          return (strcasestr (text, str) != NULL);
+        }
+
+      return (strstr (text, str) != NULL);
+    }
+
+  text_len = strlen (text);
+  if (text_len < str_len)
+    {
+      return false;
+    }
+  last = text + (text_len - str_len);
+
+  p = text;
+  while (p <= last)
+    {
+      if (accept[1] == '\0')
+        {
+          p = strchr (p, accept[0]);
+        }
+      else
+        {
+          p = strpbrk (p, accept);
+        }
+
+      if (!p || (p > last))
+        {
+          break;
+        }
+
+      if (search->case_insensitive)
+        {
+          if (c_tolower ((unsigned char) p[str_len - 1])
+              == c_tolower ((unsigned char) str[str_len - 1]))
+            {
+              for (i = 1; i < str_len; i++)
+                {
+                  if (c_tolower ((unsigned char) p[i])
+                      != c_tolower ((unsigned char) str[i]))
+                    {
+                      break;
+                    }
+                }
+
+              if (i == str_len)
+                {
+                  return true;
+                }
+            }
+        }
+      else
+        {
+          if ((p[str_len - 1] == str[str_len - 1])
+              && (memcmp (p + 1, str + 1, str_len - 1) == 0))
+            {
+              return true;
+            }
+        }
+
+      p++;
+    }
+
+  return false;
+}
+
+size_t
+rec_pool_num_workers (size_t jobs,
+                      size_t num_items,
+                      size_t chunk_size)
+{
+  size_t num_chunks;
+
+  if (jobs == 0)
+    {
+      jobs = num_processors (NPROC_CURRENT);
+    }
+
+  num_chunks = (num_items + chunk_size - 1) / chunk_size;
+  return (jobs < num_chunks) ? jobs : num_chunks;
+}
+
+rec_pool_t
+rec_pool_new (size_t num_items,
+              size_t chunk_size,
+              size_t num_workers,
+              size_t ahead,
+              rec_pool_fn_t process_fn,
+              void *workers,
+              size_t worker_size)
+{
+  rec_pool_t pool;
+
+  pool = malloc (sizeof (struct rec_pool_s));
+  if (!pool)
+    {
+      /* Out of memory.  */
+      return NULL;
+    }
+
+  pool->num_items = num_items;
+  pool->chunk_size = chunk_size;
+  pool->num_chunks = (num_items + chunk_size - 1) / chunk_size;
+  pool->num_workers = num_workers;
+  pool->ahead = ahead;
+  pool->process_fn = process_fn;
+  pool->workers = workers;
+  pool->worker_size = worker_size;
+  pool->num_threads = 0;
+  pool->next_chunk = 0;
+  pool->released_chunks = 0;
+  pool->error = false;
+  pool->threads = calloc (num_workers, sizeof (struct rec_pool_thread_s));
+  pool->done = calloc (pool->num_chunks + 1, sizeof (bool));
+  if (!pool->threads || !pool->done)
+    {
+      /* Out of memory.  */
+      free (pool->threads);
+      free (pool->done);
+      free (pool);
+      return NULL;
+    }
+
+  gl_lock_init (pool->lock);
+  gl_cond_init (pool->cond);
+
+  return pool;
+}
+
+bool
+rec_pool_run (rec_pool_t pool)
+{
+  size_t i;
+
+  /* The current thread acts as the first worker.  */
+
+  for (i = 1; i < pool->num_workers; i++)
+    {
+      pool->threads[i].pool = pool;
+      pool->threads[i].worker = i;
+      pool->threads[i].thread = gl_thread_create (rec_pool_worker,
+                                                  &pool->threads[i]);
+      pool->num_threads = i;
+    }
+
+  pool->threads[0].pool = pool;
+  pool->threads[0].worker = 0;
+  rec_pool_worker (&pool->threads[0]);
+
+  for (i = 1; i <= pool->num_threads; i++)
+    {
+      gl_thread_join (pool->threads[i].thread, NULL);
+    }
+  pool->num_threads = 0;
+
+  return !pool->error;
+}
+
+void
+rec_pool_start (rec_pool_t pool)
+{
+  size_t i;
+
+  for (i = 0; i < pool->num_workers; i++)
+    {
+      pool->threads[i].pool = pool;
+      pool->threads[i].worker = i;
+      pool->threads[i].thread = gl_thread_create (rec_pool_worker,
+                                                  &pool->threads[i]);
+      pool->num_threads = i + 1;
+    }
+}
+
+bool
+rec_pool_wait (rec_pool_t pool,
+               size_t chunk)
+{
+  bool ret;
+
+  gl_lock_lock (pool->lock);
+  while (!pool->done[chunk] && !pool->error)
+    {
+      gl_cond_wait (pool->cond, pool->lock);
+    }
+  ret = pool->done[chunk];
+  gl_lock_unlock (pool->lock);
+
+  return ret;
+}
+
+void
+rec_pool_release (rec_pool_t pool)
+{
+  gl_lock_lock (pool->lock);
+  pool->released_chunks++;
+  gl_cond_broadcast (pool->cond);
+  gl_lock_unlock (pool->lock);
+}
+
+void
+rec_pool_destroy (rec_pool_t pool)
+{
+  size_t i;
+
+  if (!pool)
+    {
+      return;
+    }
+
+  /* Stop the threads, in case not every chunk was processed.  */
+
+  gl_lock_lock (pool->lock);
+  pool->error = true;
+  gl_cond_broadcast (pool->cond);
+  gl_lock_unlock (pool->lock);
+
+  for (i = 0; i < pool->num_threads; i++)
+    {
+      gl_thread_join (pool->threads[i].thread, NULL);
+    }
+
+  gl_cond_destroy (pool->cond);
+  gl_lock_destroy (pool->lock);
+  free (pool->threads);
+  free (pool->done);
+  free (pool);
+}
+
+static void *
+rec_pool_worker (void *arg)
+{
+  struct rec_pool_thread_s *thread = (struct rec_pool_thread_s *) arg;
+  rec_pool_t pool = thread->pool;
+  void *worker;
+  size_t chunk, first, last;
+  bool ret;
+
+  worker = pool->workers + thread->worker * pool->worker_size;
+
+  while (true)
+    {
+      /* Pick the next unprocessed chunk, if it is not too far ahead
+         of the released ones.  */
+
+      gl_lock_lock (pool->lock);
+      while (pool->ahead
+             && !pool->error
+             && (pool->next_chunk < pool->num_chunks)
+             && (pool->next_chunk >= (pool->released_chunks
+                                      + pool->ahead * pool->num_workers)))
+        {
+          gl_cond_wait (pool->cond, pool->lock);
+        }
+
+      if (pool->error || (pool->next_chunk >= pool->num_chunks))
+        {
+          gl_lock_unlock (pool->lock);
+          break;
+        }
+
+      chunk = pool->next_chunk++;
+      gl_lock_unlock (pool->lock);
+
+      first = chunk * pool->chunk_size;
+      last = first + pool->chunk_size;
+      if (last > pool->num_items)
+        {
+          last = pool->num_items;
+        }
+
+      ret = pool->process_fn (worker, first, last);
+
+      gl_lock_lock (pool->lock);
+      if (ret)
+        {
+          pool->done[chunk] = true;
+        }
+      else
+        {
+          pool->error = true;
+        }
+      gl_cond_broadcast (pool->cond);
+      gl_lock_unlock (pool->lock);
+    }
+
+  return NULL;
+}
+
 /* End of rec-utils.c */
@@ -79,6 +79,68 @@ bool rec_parse_regexp (const char **str, const char *re, char **result);
 /* String utilities.  */
 char *rec_concat_strings (const char *str1, const char *str2, const char *str3);
 
+/* Substring search.  rec_search_init precomputes in SEARCH whatever
+   is needed to look for the string STR, which must remain valid
+   while SEARCH is used.  rec_search_p determines whether the
+   NULL-terminated string TEXT contains STR.  */
+
+struct rec_search_s
+{
+  const char *str;
+  size_t len;
+  bool case_insensitive;
+  char accept[3];     /* Bytes starting a match, or empty.  */
+};
+
+void rec_search_init (struct rec_search_s *search, const char *str, bool case_insensitive);
+bool rec_search_p (struct rec_search_s *search, const char *text);
+
+/* Pools of threads processing an array of NUM_ITEMS items in chunks
+   of CHUNK_SIZE consecutive items.  The chunks are handed in order to
+   the workers as they get free, and every worker processes a chunk
+   by calling PROCESS_FN with its own data and the positions of the
+   first item of the chunk and the item following the last one.
+   PROCESS_FN returns false if the operation failed, in which case no
+   more chunks are handed.
+
+   The data of the workers is passed in WORKERS, an array of
+   NUM_WORKERS elements of WORKER_SIZE bytes.  If WORKER_SIZE is 0
+   then every worker gets WORKERS itself.
+
+   rec_pool_run processes all the chunks using the current thread as
+   the first worker, and returns false if processing some chunk
+   failed.
+
+   Alternatively, rec_pool_start launches all the workers in other
+   threads and returns immediately.  rec_pool_wait waits until the
+   chunk CHUNK is processed, and returns false if that is not going to
+   happen because of an error.  The results of a pool started this way
+   can be consumed in order while other chunks are being processed.
+   If AHEAD is not 0 the workers don't get more than AHEAD chunks per
+   worker ahead of the chunks consumed so far, which are notified by
+   calling rec_pool_release.
+
+   rec_pool_destroy stops the workers, waits for them to finish and
+   frees the pool.
+
+   rec_pool_num_workers returns the number of workers to use for
+   NUM_ITEMS items when JOBS threads are requested.  0 means one per
+   processor.  It makes no sense to use more workers than chunks.  */
+
+typedef struct rec_pool_s *rec_pool_t;
+typedef bool (*rec_pool_fn_t) (void *worker, size_t first, size_t last);
+
+size_t rec_pool_num_workers (size_t jobs, size_t num_items, size_t chunk_size);
+rec_pool_t rec_pool_new (size_t num_items, size_t chunk_size,
+                         size_t num_workers, size_t ahead,
+                         rec_pool_fn_t process_fn,
+                         void *workers, size_t worker_size);
+bool rec_pool_run (rec_pool_t pool);
+void rec_pool_start (rec_pool_t pool);
+bool rec_pool_wait (rec_pool_t pool, size_t chunk);
+void rec_pool_release (rec_pool_t pool);
+void rec_pool_destroy (rec_pool_t pool);
+
 /* Miscellanea.  */
 int rec_timespec_subtract (struct timespec *result,
                            struct timespec *x,
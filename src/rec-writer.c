@@ -38,15 +38,35 @@
  */
 static bool rec_writer_putc (rec_writer_t writer, char c);
 static bool rec_writer_puts (rec_writer_t writer, const char *s);
+static bool rec_writer_write (rec_writer_t writer, const char *data, size_t size);
+static bool rec_writer_flush (rec_writer_t writer);
+static bool rec_writer_write_comment (rec_writer_t writer, rec_comment_t comment);
+static bool rec_writer_write_field (rec_writer_t writer, rec_field_t field);
+static bool rec_writer_write_field_name (rec_writer_t writer, const char *field_name);
+static bool rec_writer_write_record (rec_writer_t writer, rec_record_t record);
+static bool rec_writer_write_rset (rec_writer_t writer, rec_rset_t rset);
+static bool rec_writer_write_db (rec_writer_t writer, rec_db_t db);
+static void rec_writer_check_start (rec_writer_t writer, const void *data);
+static const char *rec_writer_source_text (rec_writer_t writer, rec_record_t record, size_t *size);
 
 /* Writer Data Structure
  *
  */
+/* Size of the output buffer of writers writing to files.  */
+
+#define REC_WRITER_BUF_SIZE 65536
+
 struct rec_writer_s
 {
   FILE *file_out;    /* File stream used by the writer. */
   rec_buf_t buf_out; /* Growable buffer used by the writer. */
 
+  char *out;         /* Buffer accumulating the output for file_out,
+                        which is written in big blocks.  It is flushed
+                        before returning from every public
+                        function.  */
+  size_t out_used;   /* Number of bytes used in OUT.  */
+
   bool eof;
   int line;  /* Current line number. */
 
@@ -60,19 +80,69 @@ struct rec_writer_s
   enum rec_writer_mode_e mode; /* The mode in which the writer operates.
                                   See the definition of the enumerated type
                                   in rec.h for a list of allowed modes.  */
+  rec_record_t start_record; /* If not NULL, output is discarded until
+                                this record is written as part of a
+                                record set.  */
+  const char *source;        /* If not NULL, unmodified records read
+                                from this source are written by
+                                copying their text from SOURCE_TEXT.  */
+  const char *source_text;
+  size_t source_size;
+  size_t jobs;               /* Number of threads formatting records.  */
+
+};
+
+/* Context shared by the threads formatting the elements of a record
+   set in parallel.  The elements are formatted by a pool of threads
+   in chunks of REC_WRITER_CHUNK elements, each one into its own
+   buffer, and the writing thread outputs every chunk in order as soon
+   as it is ready.  To bound the memory used, the formatting threads
+   do not get more than REC_WRITER_AHEAD chunks per thread ahead of
+   the writing thread.  */
+
+#define REC_WRITER_CHUNK 256
+#define REC_WRITER_AHEAD 4
+
+struct rec_writer_chunk_s
+{
+  char *text;                     /* Formatted elements, or NULL.  */
+  size_t *ends;                   /* Offsets in TEXT where the
+                                     elements end.  */
+};
 
+struct rec_writer_job_s
+{
+  rec_writer_t writer;
+  size_t num_elems;
+  void **elems;                   /* Elements to format.  */
+  int *types;                     /* MSET_RECORD or MSET_COMMENT.  */
+  size_t num_chunks;
+  struct rec_writer_chunk_s *chunks;
+  rec_pool_t pool;
 };
 
+static struct rec_writer_job_s *rec_writer_job_new (rec_writer_t writer, rec_rset_t rset);
+static bool rec_writer_job_write (struct rec_writer_job_s *job, size_t position);
+static void rec_writer_job_destroy (struct rec_writer_job_s *job);
+static bool rec_writer_job_worker (void *arg, size_t first, size_t last);
+
 static void
 rec_writer_new_common (rec_writer_t writer)
 {
   writer->file_out = NULL;
   writer->buf_out = NULL;
+  writer->out = NULL;
+  writer->out_used = 0;
   writer->line = 1;
   writer->eof = false;
   writer->collapse_p = false;
   writer->skip_comments_p = false;
   writer->mode = REC_WRITER_NORMAL;
+  writer->start_record = NULL;
+  writer->source = NULL;
+  writer->source_text = NULL;
+  writer->source_size = 0;
+  writer->jobs = 1;
 }
 
 rec_writer_t
@@ -85,6 +155,13 @@ rec_writer_new (FILE *file_out)
     {
       rec_writer_new_common (new);
       new->file_out = file_out;
+      new->out = malloc (REC_WRITER_BUF_SIZE);
+      if (!new->out)
+        {
+          /* Out of memory.  */
+          free (new);
+          new = NULL;
+        }
     }
 
   return new;
@@ -112,8 +189,10 @@ rec_writer_destroy (rec_writer_t writer)
     {
       if (writer->file_out)
         {
+          rec_writer_flush (writer);
           fflush (writer->file_out);
         }
+      free (writer->out);
       if (writer->buf_out)
         {
           rec_buf_close (writer->buf_out);
@@ -123,14 +202,14 @@ rec_writer_destroy (rec_writer_t writer)
     }
 }
 
-bool
-rec_write_comment (rec_writer_t writer,
-                   rec_comment_t comment)
+static bool
+rec_writer_write_comment (rec_writer_t writer,
+                          rec_comment_t comment)
 {
   char *line;
   char *str;
   char *orig_str;
-  size_t i;
+  size_t span;
   
   if (writer->mode == REC_WRITER_SEXP)
     {
@@ -144,21 +223,22 @@ rec_write_comment (rec_writer_t writer,
         }
 
       str = rec_comment_text (comment);
-      for (i = 0; i < strlen (str); i++)
+      while (*str != '\0')
         {
-          if (str[i] == '\n')
+          span = strcspn (str, "\n");
+          if (!rec_writer_write (writer, str, span))
             {
-              if (!rec_writer_puts (writer, "\\n"))
-                {
-                  return false;
-                }
+              return false;
             }
-          else
+
+          str = str + span;
+          if (*str == '\n')
             {
-              if (!rec_writer_putc (writer, str[i]))
+              if (!rec_writer_puts (writer, "\\n"))
                 {
                   return false;
                 }
+              str++;
             }
         }
 
@@ -206,11 +286,12 @@ rec_write_comment (rec_writer_t writer,
   return true;
 }
 
-bool
-rec_write_field (rec_writer_t writer,
-                 rec_field_t field)
+static bool
+rec_writer_write_field (rec_writer_t writer,
+                        rec_field_t field)
 {
-  size_t pos;
+  size_t span;
+  const char *special;
   const char *fname;
   const char *fvalue;
   enum rec_writer_mode_e mode = writer->mode;
@@ -234,7 +315,7 @@ rec_write_field (rec_writer_t writer,
   if ((mode != REC_WRITER_VALUES) && (mode != REC_WRITER_VALUES_ROW))
     {
       fname = rec_field_name (field);
-      if (!rec_write_field_name (writer, fname))
+      if (!rec_writer_write_field_name (writer, fname))
         {
           return false;
         }
@@ -256,7 +337,7 @@ rec_write_field (rec_writer_t writer,
 
   fvalue = rec_field_value (field);
 
-  if ((strlen (fvalue) > 0) && (mode == REC_WRITER_NORMAL))
+  if ((*fvalue != '\0') && (mode == REC_WRITER_NORMAL))
     {
       if (!rec_writer_putc (writer, ' '))
         {
@@ -264,48 +345,63 @@ rec_write_field (rec_writer_t writer,
         }
     }
 
-  for (pos = 0; pos < strlen (fvalue); pos++)
+  /* Write the value in spans, breaking them only at the characters
+     that must be transformed in the current mode: newlines, which
+     are written as continuation lines in normal mode, and the
+     characters that must be escaped in sexp mode.  */
+
+  if (mode == REC_WRITER_SEXP)
     {
-      if (fvalue[pos] == '\n')
+      special = "\n\"\\";
+    }
+  else if (mode == REC_WRITER_NORMAL)
+    {
+      special = "\n";
+    }
+  else
+    {
+      special = "";
+    }
+
+  while (*fvalue != '\0')
+    {
+      span = strcspn (fvalue, special);
+      if (!rec_writer_write (writer, fvalue, span))
         {
-          if (mode == REC_WRITER_SEXP)
-            {
-              if (!rec_writer_puts (writer, "\\n"))
-                {
-                  return false;
-                }
-            }
-          else if (mode == REC_WRITER_NORMAL)
-            {
-              if (!rec_writer_puts (writer, "\n+ "))
-                {
-                  return false;
-                }
-            }
-          else
+          /* EOF on output */
+          return false;
+        }
+
+      fvalue = fvalue + span;
+      if (*fvalue == '\0')
+        {
+          break;
+        }
+
+      if ((*fvalue == '\n') && (mode == REC_WRITER_SEXP))
+        {
+          if (!rec_writer_puts (writer, "\\n"))
             {
-              if (!rec_writer_putc (writer, '\n'))
-                {
-                  return false;
-                }
+              return false;
             }
         }
-      else if (((fvalue[pos] == '"') || (fvalue[pos] == '\\')) && (mode == REC_WRITER_SEXP))
+      else if (*fvalue == '\n')
         {
-          if ((!rec_writer_putc (writer, '\\'))
-              || (!rec_writer_putc (writer, fvalue[pos])))
+          if (!rec_writer_puts (writer, "\n+ "))
             {
               return false;
             }
         }
       else
         {
-          if (!rec_writer_putc (writer, fvalue[pos]))
+          if ((!rec_writer_putc (writer, '\\'))
+              || (!rec_writer_putc (writer, *fvalue)))
             {
-              /* EOF on output */
               return false;
             }
         }
+
+      fvalue++;
     }
 
   if (mode == REC_WRITER_SEXP)
@@ -327,9 +423,9 @@ rec_write_field (rec_writer_t writer,
   return true;
 }
 
-bool
-rec_write_field_name (rec_writer_t writer,
-                      const char *field_name)
+static bool
+rec_writer_write_field_name (rec_writer_t writer,
+                             const char *field_name)
 {
   /* Field names can be written in several formats, according to the
    * desired mode:
@@ -373,9 +469,9 @@ rec_write_field_name (rec_writer_t writer,
   return true;
 }
 
-bool
-rec_write_record (rec_writer_t writer,
-                  rec_record_t record)
+static bool
+rec_writer_write_record (rec_writer_t writer,
+                         rec_record_t record)
 {
   bool ret;
   rec_mset_iterator_t iter;
@@ -383,9 +479,18 @@ rec_write_record (rec_writer_t writer,
   char *data;
   size_t num_field, num_elem, num_fields, num_elems;
   enum rec_writer_mode_e mode = writer->mode;
+  const char *text;
+  size_t text_size;
 
   ret = true;
 
+  text = rec_writer_source_text (writer, record, &text_size);
+  if (text)
+    {
+      /* Copy the text of the record as it was read.  */
+      return rec_writer_write (writer, text, text_size);
+    }
+
   if (mode == REC_WRITER_SEXP)
     {
       if (!rec_writer_puts (writer, "(record "))
@@ -408,7 +513,7 @@ rec_write_record (rec_writer_t writer,
           /* Write a field.  */
           rec_field_t field = (rec_field_t) data;
 
-          if (!rec_write_field (writer, field))
+          if (!rec_writer_write_field (writer, field))
             {
               ret = false;
               break;
@@ -442,7 +547,7 @@ rec_write_record (rec_writer_t writer,
 
           if ((mode != REC_WRITER_VALUES) && (mode != REC_WRITER_VALUES_ROW))
             {
-              if (!rec_write_comment (writer, comment))
+              if (!rec_writer_write_comment (writer, comment))
                 {
                   ret = false;
                   break;
@@ -472,9 +577,9 @@ rec_write_record (rec_writer_t writer,
   return ret;
 }
 
-bool
-rec_write_rset (rec_writer_t writer,
-                rec_rset_t rset)
+static bool
+rec_writer_write_rset (rec_writer_t writer,
+                       rec_rset_t rset)
 {
   bool ret;
   rec_record_t descriptor;
@@ -485,6 +590,7 @@ rec_write_rset (rec_writer_t writer,
   rec_mset_elem_t elem;
   void *data;
   enum rec_writer_mode_e mode = writer->mode;
+  struct rec_writer_job_s *job;
   
   ret = true;
   wrote_descriptor = false;
@@ -496,13 +602,18 @@ rec_write_rset (rec_writer_t writer,
      descriptor.  */
   if ((rec_rset_num_elems (rset) == 0) && descriptor)
     {
-      rec_write_record (writer,
-                        rec_rset_descriptor (rset));
+      rec_writer_check_start (writer, descriptor);
+      rec_writer_write_record (writer,
+                               rec_rset_descriptor (rset));
       rec_writer_putc (writer, '\n');
 
       return true;
     }
 
+  /* Format the elements in other threads if requested.  If that is
+     not possible they are formatted below.  */
+  job = rec_writer_job_new (writer, rset);
+
   iter = rec_mset_iterator (rec_rset_mset (rset));
   while (rec_mset_iterator_next (&iter, MSET_ANY, (const void **) &data, &elem))
     {
@@ -516,9 +627,10 @@ rec_write_rset (rec_writer_t writer,
 
       if (position == descriptor_pos)
         {
+          rec_writer_check_start (writer, descriptor);
           if (descriptor 
-              && (!(wrote_descriptor = rec_write_record (writer,
-                                                         rec_rset_descriptor (rset)))))
+              && (!(wrote_descriptor = rec_writer_write_record (writer,
+                                                                rec_rset_descriptor (rset)))))
             {
               ret = false;
             }
@@ -534,13 +646,23 @@ rec_write_rset (rec_writer_t writer,
             }
         }
       
-      if (rec_mset_elem_type (elem) == MSET_RECORD)
+      rec_writer_check_start (writer, data);
+      if (writer->start_record)
         {
-          ret = rec_write_record (writer, (rec_record_t) data);
+          /* Don't bother formatting elements whose output would be
+             discarded anyway.  */
+        }
+      else if (job)
+        {
+          ret = rec_writer_job_write (job, position);
+        }
+      else if (rec_mset_elem_type (elem) == MSET_RECORD)
+        {
+          ret = rec_writer_write_record (writer, (rec_record_t) data);
         }
       else if (!writer->skip_comments_p)
         {
-          ret = rec_write_comment (writer, (rec_comment_t) data);
+          ret = rec_writer_write_comment (writer, (rec_comment_t) data);
         }
 
       if (!writer->collapse_p || (position == (rec_rset_num_elems (rset) - 1)))
@@ -560,6 +682,7 @@ rec_write_rset (rec_writer_t writer,
     }
 
   rec_mset_iterator_free (&iter);
+  rec_writer_job_destroy (job);
 
   /* Special case:
    *
@@ -577,7 +700,8 @@ rec_write_rset (rec_writer_t writer,
         {
           ret = false;
         }
-      if (!rec_write_record (writer, rec_rset_descriptor (rset)))
+      rec_writer_check_start (writer, descriptor);
+      if (!rec_writer_write_record (writer, rec_rset_descriptor (rset)))
         {
           ret = false;
         }
@@ -590,9 +714,9 @@ rec_write_rset (rec_writer_t writer,
   return ret;
 }
 
-bool
-rec_write_db (rec_writer_t writer,
-              rec_db_t db)
+static bool
+rec_writer_write_db (rec_writer_t writer,
+                     rec_db_t db)
 {
   bool ret;
   int i;
@@ -611,7 +735,7 @@ rec_write_db (rec_writer_t writer,
             }
         }
       
-      if (!rec_write_rset (writer, rset))
+      if (!rec_writer_write_rset (writer, rset))
         {
           ret = false;
           break;
@@ -621,6 +745,54 @@ rec_write_db (rec_writer_t writer,
   return ret;
 }
 
+bool
+rec_write_comment (rec_writer_t writer,
+                   rec_comment_t comment)
+{
+  bool ret = rec_writer_write_comment (writer, comment);
+  return rec_writer_flush (writer) && ret;
+}
+
+bool
+rec_write_field (rec_writer_t writer,
+                 rec_field_t field)
+{
+  bool ret = rec_writer_write_field (writer, field);
+  return rec_writer_flush (writer) && ret;
+}
+
+bool
+rec_write_field_name (rec_writer_t writer,
+                      const char *field_name)
+{
+  bool ret = rec_writer_write_field_name (writer, field_name);
+  return rec_writer_flush (writer) && ret;
+}
+
+bool
+rec_write_record (rec_writer_t writer,
+                  rec_record_t record)
+{
+  bool ret = rec_writer_write_record (writer, record);
+  return rec_writer_flush (writer) && ret;
+}
+
+bool
+rec_write_rset (rec_writer_t writer,
+                rec_rset_t rset)
+{
+  bool ret = rec_writer_write_rset (writer, rset);
+  return rec_writer_flush (writer) && ret;
+}
+
+bool
+rec_write_db (rec_writer_t writer,
+              rec_db_t db)
+{
+  bool ret = rec_writer_write_db (writer, db);
+  return rec_writer_flush (writer) && ret;
+}
+
 char *
 rec_write_field_str (rec_field_t field,
                      rec_writer_mode_t mode)
@@ -685,7 +857,8 @@ bool
 rec_write_string (rec_writer_t writer,
                   const char *str)
 {
-  return rec_writer_puts (writer, str);
+  bool ret = rec_writer_puts (writer, str);
+  return rec_writer_flush (writer) && ret;
 }
 
 void
@@ -709,41 +882,368 @@ rec_writer_set_mode (rec_writer_t writer,
   writer->mode = mode;
 }
 
+void
+rec_writer_set_start_record (rec_writer_t writer,
+                             rec_record_t record)
+{
+  writer->start_record = record;
+}
+
+void
+rec_writer_set_source (rec_writer_t writer,
+                       const char *source,
+                       const char *text,
+                       size_t size)
+{
+  writer->source = source;
+  writer->source_text = text;
+  writer->source_size = size;
+}
+
+void
+rec_writer_set_jobs (rec_writer_t writer,
+                     size_t jobs)
+{
+  writer->jobs = jobs;
+}
+
 /*
  * Private functions
  */
 
+static struct rec_writer_job_s *
+rec_writer_job_new (rec_writer_t writer,
+                    rec_rset_t rset)
+{
+  struct rec_writer_job_s *job;
+  rec_mset_iterator_t iter;
+  rec_mset_elem_t elem;
+  void *data;
+  size_t num_threads, i;
+
+  /* It makes no sense to format elements that would be discarded.  */
+
+  num_threads = rec_pool_num_workers (writer->jobs,
+                                      rec_rset_num_elems (rset),
+                                      REC_WRITER_CHUNK);
+  if ((num_threads <= 1) || writer->start_record)
+    {
+      return NULL;
+    }
+
+  job = malloc (sizeof (struct rec_writer_job_s));
+  if (!job)
+    {
+      /* Out of memory.  */
+      return NULL;
+    }
+
+  job->writer = writer;
+  job->num_elems = rec_rset_num_elems (rset);
+  job->num_chunks = (job->num_elems + REC_WRITER_CHUNK - 1) / REC_WRITER_CHUNK;
+  job->elems = malloc (sizeof (void *) * job->num_elems);
+  job->types = malloc (sizeof (int) * job->num_elems);
+  job->chunks = calloc (job->num_chunks, sizeof (struct rec_writer_chunk_s));
+  job->pool = rec_pool_new (job->num_elems, REC_WRITER_CHUNK,
+                            num_threads, REC_WRITER_AHEAD,
+                            rec_writer_job_worker, job, 0);
+
+  if (!job->elems || !job->types || !job->chunks || !job->pool)
+    {
+      /* Out of memory.  */
+      free (job->elems);
+      free (job->types);
+      free (job->chunks);
+      rec_pool_destroy (job->pool);
+      free (job);
+      return NULL;
+    }
+
+  /* Collect the elements in arrays, so the threads can access them by
+     position.  */
+
+  i = 0;
+  iter = rec_mset_iterator (rec_rset_mset (rset));
+  while (rec_mset_iterator_next (&iter, MSET_ANY, (const void **) &data, &elem))
+    {
+      job->elems[i] = data;
+      job->types[i] = rec_mset_elem_type (elem);
+      i++;
+    }
+  rec_mset_iterator_free (&iter);
+
+  rec_pool_start (job->pool);
+
+  return job;
+}
+
 static bool
-rec_writer_putc (rec_writer_t writer, char c)
+rec_writer_job_write (struct rec_writer_job_s *job,
+                      size_t position)
 {
+  struct rec_writer_chunk_s *chunk;
+  size_t index, start;
   bool ret;
 
-  ret = false;
-  if (writer->file_out)
+  chunk = job->chunks + (position / REC_WRITER_CHUNK);
+  index = position % REC_WRITER_CHUNK;
+
+  if (!rec_pool_wait (job->pool, position / REC_WRITER_CHUNK))
     {
-      ret = (fputc (c, writer->file_out) != EOF);
+      /* Out of memory.  */
+      return false;
     }
-  if (writer->buf_out)
+
+  start = (index > 0) ? chunk->ends[index - 1] : 0;
+  ret = rec_writer_write (job->writer, chunk->text + start,
+                          chunk->ends[index] - start);
+
+  if ((index == (REC_WRITER_CHUNK - 1))
+      || (position == (job->num_elems - 1)))
     {
-      ret = (rec_buf_putc (c, writer->buf_out) != EOF);
+      /* The chunk is completely written.  */
+
+      free (chunk->text);
+      free (chunk->ends);
+      chunk->text = NULL;
+      chunk->ends = NULL;
+      rec_pool_release (job->pool);
     }
 
   return ret;
 }
 
+static void
+rec_writer_job_destroy (struct rec_writer_job_s *job)
+{
+  size_t i;
+
+  if (!job)
+    {
+      return;
+    }
+
+  /* This stops the threads, in case not every element was
+     written.  */
+
+  rec_pool_destroy (job->pool);
+
+  for (i = 0; i < job->num_chunks; i++)
+    {
+      free (job->chunks[i].text);
+      free (job->chunks[i].ends);
+    }
+
+  free (job->elems);
+  free (job->types);
+  free (job->chunks);
+  free (job);
+}
+
+static bool
+rec_writer_job_worker (void *arg,
+                       size_t first,
+                       size_t last)
+{
+  struct rec_writer_job_s *job = (struct rec_writer_job_s *) arg;
+  rec_writer_t writer = job->writer;
+  struct rec_writer_chunk_s *chunk;
+  rec_writer_t chunk_writer;
+  char *text = NULL;
+  size_t text_size;
+  size_t *ends;
+  size_t i;
+  bool ret;
+
+  chunk = job->chunks + (first / REC_WRITER_CHUNK);
+
+  /* Format the elements of the chunk using a writer with the same
+     settings, remembering where every element ends.  */
+
+  ends = malloc (sizeof (size_t) * (last - first));
+  chunk_writer = rec_writer_new_str (&text, &text_size);
+  ret = (ends && chunk_writer && chunk_writer->buf_out);
+
+  if (ret)
+    {
+      chunk_writer->mode = writer->mode;
+      chunk_writer->skip_comments_p = writer->skip_comments_p;
+      chunk_writer->source = writer->source;
+      chunk_writer->source_text = writer->source_text;
+      chunk_writer->source_size = writer->source_size;
+    }
+
+  for (i = first; ret && (i < last); i++)
+    {
+      if (job->types[i] == MSET_RECORD)
+        {
+          ret = rec_writer_write_record (chunk_writer,
+                                         (rec_record_t) job->elems[i]);
+        }
+      else if (!writer->skip_comments_p)
+        {
+          ret = rec_writer_write_comment (chunk_writer,
+                                          (rec_comment_t) job->elems[i]);
+        }
+
+      ends[i - first] = rec_buf_size (chunk_writer->buf_out);
+    }
+
+  rec_writer_destroy (chunk_writer);
+  if (!ret)
+    {
+      /* Out of memory.  */
+      free (text);
+      free (ends);
+      return false;
+    }
+
+  chunk->text = text;
+  chunk->ends = ends;
+  return true;
+}
+
+static size_t
+rec_writer_char_offset (size_t char_location)
+{
+  /* Character locations are 1-based, except for the very first
+     character in the source.  */
+
+  return (char_location > 0) ? char_location - 1 : 0;
+}
+
+static const char *
+rec_writer_source_text (rec_writer_t writer,
+                        rec_record_t record,
+                        size_t *size)
+{
+  rec_mset_iterator_t iter;
+  rec_field_t field;
+  const char *source;
+  size_t start, end, next;
+  bool unmodified_p;
+
+  if (!writer->source
+      || (writer->mode != REC_WRITER_NORMAL)
+      || writer->skip_comments_p
+      || rec_record_modified_p (record))
+    return NULL;
+
+  source = rec_record_source (record);
+  if (!source || (strcmp (source, writer->source) != 0))
+    return NULL;
+
+  start = rec_writer_char_offset (rec_record_char_location (record));
+  end = start + rec_record_char_size (record);
+  if ((end == start) || (end > writer->source_size))
+    return NULL;
+
+  /* The fields must be unmodified and still be in the places where
+     they were read.  Added or removed elements make the size of the
+     record unknown.  */
+
+  unmodified_p = true;
+  next = start;
+  iter = rec_mset_iterator (rec_record_mset (record));
+  while (unmodified_p
+         && rec_mset_iterator_next (&iter, MSET_FIELD, (const void **) &field, NULL))
+    {
+      size_t offset = rec_writer_char_offset (rec_field_char_location (field));
+
+      source = rec_field_source (field);
+      unmodified_p = (!rec_field_modified_p (field)
+                      && source && (strcmp (source, writer->source) == 0)
+                      && (offset >= next) && (offset < end));
+      next = offset + 1;
+    }
+  rec_mset_iterator_free (&iter);
+
+  if (!unmodified_p)
+    return NULL;
+
+  /* The newline terminating the last element separates records, and
+     is written by the caller.  */
+
+  if (writer->source_text[end - 1] == '\n')
+    end--;
+
+  *size = end - start;
+  return writer->source_text + start;
+}
+
+static void
+rec_writer_check_start (rec_writer_t writer, const void *data)
+{
+  if (writer->start_record && (writer->start_record == data))
+    {
+      writer->start_record = NULL;
+    }
+}
+
+static bool
+rec_writer_putc (rec_writer_t writer, char c)
+{
+  return rec_writer_write (writer, &c, 1);
+}
+
 static bool
 rec_writer_puts (rec_writer_t writer, const char *s)
+{
+  return rec_writer_write (writer, s, strlen (s));
+}
+
+static bool
+rec_writer_write (rec_writer_t writer, const char *data, size_t size)
 {
   bool ret;
 
+  if (writer->start_record)
+    {
+      /* Discard the output.  */
+      return true;
+    }
+
   ret = false;
   if (writer->file_out)
     {
-      ret = (fputs (s, writer->file_out) != EOF);
+      if ((writer->out_used + size) > REC_WRITER_BUF_SIZE)
+        {
+          if (!rec_writer_flush (writer))
+            {
+              return false;
+            }
+        }
+
+      if (size > REC_WRITER_BUF_SIZE)
+        {
+          /* Too big to be buffered.  */
+          ret = (fwrite (data, 1, size, writer->file_out) == size);
+        }
+      else
+        {
+          memcpy (writer->out + writer->out_used, data, size);
+          writer->out_used = writer->out_used + size;
+          ret = true;
+        }
     }
   if (writer->buf_out)
     {
-      ret = (rec_buf_puts (s, writer->buf_out) != EOF);
+      ret = (rec_buf_write (data, size, writer->buf_out) != -1);
+    }
+
+  return ret;
+}
+
+static bool
+rec_writer_flush (rec_writer_t writer)
+{
+  bool ret = true;
+
+  if (writer->file_out && (writer->out_used > 0))
+    {
+      ret = (fwrite (writer->out, 1, writer->out_used, writer->file_out)
+             == writer->out_used);
+      writer->out_used = 0;
     }
 
   return ret;
@@ -327,9 +327,16 @@ int rec_buf_putc (int c, rec_buf_t buffer);
 /* rec_buf_puts returns a non-negative number on success (number of
    characters written), or EOF on error.  */
 int rec_buf_puts (const char *s, rec_buf_t buffer);
+/* rec_buf_write appends SIZE characters starting at DATA, which may
+   contain null characters.  It returns the number of characters
+   written, or -1 on error.  */
+int rec_buf_write (const char *data, size_t size, rec_buf_t buffer);
 
 void rec_buf_rewind (rec_buf_t buf, int n);
 
+/* rec_buf_size returns the number of characters written so far.  */
+size_t rec_buf_size (rec_buf_t buf);
+
 /*
  * COMMENTS
  *
@@ -766,6 +773,12 @@ const char *rec_field_value (rec_field_t field);
 
 bool rec_field_set_value (rec_field_t field, const char *value);
 
+/* Determine whether the name or the value of a field were changed
+   with rec_field_set_name or rec_field_set_value after the field was
+   created.  Copies made with rec_field_dup inherit this property.  */
+
+bool rec_field_modified_p (rec_field_t field);
+
 /* Return a string describing the source of the field.  The specific
    meaning of the source depends on the user: it may be a file name,
    or something else.  This function returns NULL for a field for
@@ -959,6 +972,28 @@ char *rec_record_char_location_str (rec_record_t record);
 
 void rec_record_set_char_location (rec_record_t record, size_t char_location);
 
+/* Return the size, in characters, of the text the record was read
+   from, starting at its char location.  0 is returned if the size is
+   unknown, or if elements were added to or removed from the record
+   after the size was set.  */
+
+size_t rec_record_char_size (rec_record_t record);
+
+/* Set the size, in characters, of the text the record was read
+   from.  */
+
+void rec_record_set_char_size (rec_record_t record, size_t char_size);
+
+/* Determine whether a record was inserted by rec_db_insert or
+   modified by rec_db_set since it was read.  Records are not marked
+   when created or copied.  */
+
+bool rec_record_modified_p (rec_record_t record);
+
+/* Mark or unmark a record as modified.  */
+
+void rec_record_set_modified (rec_record_t record, bool modified_p);
+
 
 /* Return the position occupied by the specified field in the
    specified records, not considering comments.  */
@@ -1137,6 +1172,17 @@ rec_record_t rec_rset_descriptor (rec_rset_t rset);
 
 void rec_rset_set_descriptor (rec_rset_t rset, rec_record_t record);
 
+/* Determine whether records were inserted into, deleted from or
+   modified in a record set by rec_db_insert, rec_db_delete or
+   rec_db_set since it was read.  The modified records are marked,
+   see rec_record_modified_p.  */
+
+bool rec_rset_modified_p (rec_rset_t rset);
+
+/* Mark or unmark a record set as modified.  */
+
+void rec_rset_set_modified (rec_rset_t rset, bool modified_p);
+
 /* Return the relative position of the descriptor with respect the
    first element in the record set.  For example, if there are two
    comments before the record descriptor in the record set then this
@@ -1228,6 +1274,15 @@ void rec_rset_rename_field (rec_rset_t rset,
 
 rec_fex_t rec_rset_auto (rec_rset_t rset);
 
+/* Return a fex with the names of the fields declared in the record
+   descriptor of a record set by the %key, %mandatory, %allowed and
+   %type special fields, in the order they first appear in the
+   descriptor.  If the record set does not have a descriptor then an
+   empty fex is returned.  Return NULL if there is not enough memory
+   to perform the operation.  */
+
+rec_fex_t rec_rset_declared_fields (rec_rset_t rset);
+
 /* Return the name of the key field of the record set.  If the record
    set does not have a key defined then return NULL.  */
 
@@ -1293,6 +1348,14 @@ rec_rset_t rec_rset_group (rec_rset_t rset, rec_fex_t group_by);
 
 rec_rset_t rec_rset_add_auto_fields (rec_rset_t rset, rec_record_t record);
 
+/* Forget the next values of the auto fields of a record set, which
+   are cached by 'rec_rset_add_auto_fields'.  This function must be
+   called after modifying or removing the fields of records stored in
+   RSET, since the cached values are only revalidated by counting the
+   records.  */
+
+void rec_rset_reset_auto_fields (rec_rset_t rset);
+
 /*
  * DATABASES
  *
@@ -1371,6 +1434,26 @@ rec_rset_t rec_db_get_rset_by_type (rec_db_t db, const char *type);
 
 rec_aggregate_reg_t rec_db_aggregates (rec_db_t db);
 
+/* Get and set the number of threads that can be used to process the
+   records of a database in the operations supporting it, such as
+   rec_db_query with the REC_F_PARALLEL flag.  A value of 0 means to
+   use as many threads as processors are available.  The number of
+   jobs of a newly created database is 1.  */
+
+size_t rec_db_jobs (rec_db_t db);
+void rec_db_set_jobs (rec_db_t db, size_t jobs);
+
+/* Determine whether the given database has been modified by
+   rec_db_insert, rec_db_delete or rec_db_set.  If so, and
+   CHAR_LOCATION is not NULL, store in it the smallest character
+   location (see rec_record_char_location) of the records that were
+   changed, removed or that precede inserted records.  The rec data
+   the database was read from is unaffected by these modifications up
+   to that location.  A location of 0 means that anything may have
+   changed.  Other changes to the database are not tracked.  */
+
+bool rec_db_modified_p (rec_db_t db, size_t *char_location);
+
 /******************** Database High-Level functions *******************/
 
 /* Query for some data in a database.  The resulting data is returned
@@ -1474,12 +1557,25 @@ rec_aggregate_reg_t rec_db_aggregates (rec_db_t db);
       case-insensitive.  If FALSE any string operation will be
       case-sensitive.
 
+      REC_F_UNIQ
+
+      If set duplicated fields are removed from the records in the
+      returned record set.
+
+      REC_F_PARALLEL
+
+      If set the records of the referred record set are selected and
+      processed by several threads, as many as specified by
+      rec_db_jobs.  The order of the records in the returned record
+      set is the same than in a sequential query.
+
   This function returns NULL if there is not enough memory to
   perform the operation.  */
 
 #define REC_F_DESCRIPTOR 1
 #define REC_F_ICASE      2
 #define REC_F_UNIQ       4
+#define REC_F_PARALLEL   32
 
 #define REC_Q_NOINDEX ((size_t)-1)
 
@@ -1808,6 +1904,19 @@ int rec_int_check_db (rec_db_t db,
                       bool remote_descriptors_p,
                       rec_buf_t errors);
 
+/* Check the integrity of a database after it was modified with
+   rec_db_insert, rec_db_delete or rec_db_set, assuming it was valid
+   before.  Only the modified record sets are checked, and only the
+   modified records in them, including the uniqueness of their keys.
+   The whole database is checked if some record descriptor was
+   modified.  This function returns the number of errors found.
+   Descriptive messages about the errors are appended to ERRORS.  */
+
+int rec_int_check_db_incremental (rec_db_t db,
+                                  bool check_descriptors_p,
+                                  bool remote_descriptors_p,
+                                  rec_buf_t errors);
+
 /* Check the integrity of a given record set.  This function returns
    the number of errors found.  Descriptive messages about the errors
    are appended to ERRORS.  */
@@ -1818,6 +1927,20 @@ int rec_int_check_rset (rec_db_t db,
                         bool remote_descriptor_p,
                         rec_buf_t errors);
 
+/* Check the integrity of a given record set after RECORD was
+   appended to it, without checking again the rest of its records.
+   The record descriptor, the size restrictions of the record set and
+   RECORD, including the uniqueness of its key, are checked.  This
+   function returns the number of errors found.  Descriptive messages
+   about the errors are appended to ERRORS.  */
+
+int rec_int_check_rset_append (rec_db_t db,
+                               rec_rset_t rset,
+                               rec_record_t record,
+                               bool check_descriptor_p,
+                               bool remote_descriptor_p,
+                               rec_buf_t errors);
+
 /* Check the integrity of a database provided ORIG_REC is replaced by
    REC.  This function returns the number of errors found.
    Descriptive messages about the errors are appended to ERRORS.  */
@@ -1955,6 +2078,28 @@ bool rec_parser_seek (rec_parser_t parser, size_t line_number, size_t position);
 /* Return the current position in the file of the parser or -1 on error. */
 long rec_parser_tell (rec_parser_t parser);
 
+/* Install a prefilter in a parser.  While parsing record sets, the
+   records whose text does not contain the string STR are skipped
+   without building them.  The search is case-insensitive if
+   CASE_INSENSITIVE is 'true'.  Records that can be record
+   descriptors are never skipped.  If STR is NULL, empty or contains
+   newline characters then no prefilter is used.  Return 'false' if
+   there is not enough memory to perform the operation.  */
+bool rec_parser_set_prefilter (rec_parser_t parser, const char *str, bool case_insensitive);
+
+/* Install a record callback in a parser.  While parsing record sets,
+   FN is called with every record that is not a record descriptor,
+   the record set being parsed and DATA.  If FN returns 'true' then it
+   takes ownership of the record, which is not added to the record
+   set.  Otherwise the record is added to the record set as usual.
+   This allows to process the records of big record sets without
+   keeping all of them in memory.  If FN is NULL then no callback is
+   used.  */
+
+typedef bool (*rec_parser_record_fn_t) (rec_record_t record, rec_rset_t rset, void *data);
+
+void rec_parser_set_record_callback (rec_parser_t parser, rec_parser_record_fn_t fn, void *data);
+
 /*
  * WRITER
  *
@@ -2016,6 +2161,35 @@ void rec_writer_set_skip_comments (rec_writer_t writer, bool value);
 
 void rec_writer_set_mode (rec_writer_t writer, enum rec_writer_mode_e mode);
 
+/* Set a record, either a regular record or a record descriptor, from
+   which the writer starts generating output when writing record sets
+   or databases.  Everything that would be written before that record
+   is discarded.  This allows regenerating just the tail of some rec
+   data, starting at a given record.  If RECORD is NULL then all the
+   output is generated, which is the default.  */
+
+void rec_writer_set_start_record (rec_writer_t writer, rec_record_t record);
+
+/* Set the text of the rec data a database was read from, along with
+   its source (see rec_record_source).  In REC_WRITER_NORMAL mode, if
+   comments are not skipped, records read from SOURCE are then written
+   by copying their original text from TEXT, rather than formatting
+   their fields, provided that neither the records nor their fields
+   were modified since (see rec_record_modified_p and
+   rec_field_modified_p).  TEXT must be SIZE characters long and stay
+   available while the writer is in use.  If SOURCE is NULL all the
+   records are formatted, which is the default.  */
+
+void rec_writer_set_source (rec_writer_t writer, const char *source,
+                            const char *text, size_t size);
+
+/* Set the number of threads used to format the records when writing
+   record sets.  The records are still written in order, by the
+   calling thread.  0 means to use one thread per processor.  The
+   number of jobs of a newly created writer is 1.  */
+
+void rec_writer_set_jobs (rec_writer_t writer, size_t jobs);
+
 /************** Getting the properties of a writer ****************/
 
 /* Determine whether a given writer is in an EOF (end-of-file)
@@ -2104,6 +2278,14 @@ rec_sex_t rec_sex_new (bool case_insensitive);
 
 void rec_sex_destroy (rec_sex_t sex);
 
+/* Create a copy of a compiled sex and return it.  The copy does not
+   share any state with SEX, so both sexes can be evaluated
+   concurrently in different threads.  NULL is returned if SEX is not
+   compiled or if there is not enough memory to perform the
+   operation.  */
+
+rec_sex_t rec_sex_dup (rec_sex_t sex);
+
 /**************** Compiling and applying sexes ******************/
 
 /* Compile a sex.  Sexes must be compiled before being used.  If there
@@ -2122,6 +2304,15 @@ bool rec_sex_eval (rec_sex_t sex, rec_record_t record, bool *status);
 
 char *rec_sex_eval_str (rec_sex_t sex, rec_record_t record);
 
+/* Return a non-empty string that is contained in the value of some
+   field of every record matched by SEX, or NULL if no such string can
+   be determined.  This is the case of expressions comparing a field
+   with a string literal for equality, like "Name = 'foo'", possibly
+   combined with other expressions using the && operator.  The
+   returned string belongs to SEX.  */
+
+const char *rec_sex_literal (rec_sex_t sex);
+
 /**************** Miscellaneous sexes functions ******************/
 
 /* Print the abstract syntax tree of a compiled sex.  This function is
@@ -2144,6 +2335,48 @@ void rec_sex_print_ast (rec_sex_t sex);
 
 #define REC_ENCRYPTED_PREFIX "encrypted-"
 
+/**************** Encryption contexts *******************************/
+
+/* Opaque data type representing an encryption context.  A context
+   keeps the cipher handle and the key derived from a password, so
+   they are not set up again for every encrypted or decrypted value.
+   A context must not be used by several threads at the same time.  */
+
+typedef struct rec_crypt_ctx_s *rec_crypt_ctx_t;
+
+/* Create a new encryption context for the given password.  This
+   function returns NULL if there is not enough memory to perform the
+   operation, if the password is empty or if the cipher can't be
+   initialized.  */
+
+rec_crypt_ctx_t rec_crypt_ctx_new (const char *password);
+
+/* Destroy an encryption context, freeing all used resources.  */
+
+void rec_crypt_ctx_destroy (rec_crypt_ctx_t ctx);
+
+/* Like rec_encrypt_field, rec_encrypt_record, rec_decrypt_field and
+   rec_decrypt_record below, but using the password of an encryption
+   context.  */
+
+bool rec_crypt_ctx_encrypt_field (rec_crypt_ctx_t ctx, rec_field_t field);
+bool rec_crypt_ctx_encrypt_record (rec_crypt_ctx_t ctx, rec_rset_t rset,
+                                   rec_record_t record);
+bool rec_crypt_ctx_decrypt_field (rec_crypt_ctx_t ctx, rec_field_t field);
+bool rec_crypt_ctx_decrypt_record (rec_crypt_ctx_t ctx, rec_rset_t rset,
+                                   rec_record_t record);
+
+/* Encrypt or decrypt the fields marked as "confidential" in all the
+   records of a record set, using the provided password.  The records
+   are processed by up to JOBS threads, each one using its own
+   encryption context.  A value of 0 means to use as many threads as
+   processors are available.  A failure in some record doesn't prevent
+   processing the rest of them, but these functions return 'false'
+   afterwards.  */
+
+bool rec_encrypt_rset (rec_rset_t rset, const char *password, size_t jobs);
+bool rec_decrypt_rset (rec_rset_t rset, const char *password, size_t jobs);
+
 /**************** Encryption routines *******************************/
 
 /* Encrypt a given buffer and place the encrypted data in an allocated
@@ -2219,6 +2452,72 @@ typedef char *(*rec_aggregate_t) (rec_rset_t    rset,
                                   rec_record_t  record,
                                   const char   *field_name);
 
+/*
+ * INCREMENTAL AGGREGATES
+ *
+ * An incremental aggregate is an alternative way to implement an
+ * aggregate function.  Instead of getting the whole record set at
+ * once it is defined by four callbacks that operate on an
+ * accumulator state:
+ *
+ * - INIT initializes an empty state.
+ * - ACCUMULATE folds the fields named FIELD_NAME stored in a record
+ *   into the state.
+ * - MERGE folds the contents of a second state, which was built by
+ *   accumulating some other records, into the first state.  The
+ *   second state must still be finalized.
+ * - FINALIZE computes the value of the aggregate from the state and
+ *   returns it as an allocated string.  It must also free any
+ *   resource held by the state.
+ *
+ * This allows to compute aggregates while streaming records, for
+ * every group of a grouped record set, or on partitions of a record
+ * set which are later merged.
+ */
+
+/* Accumulator state of an incremental aggregate.  COUNT and NUM are
+   available to the aggregate to count things and to accumulate
+   numerical values.  DATA can be used by aggregates needing a more
+   complex state, and must be freed by the finalize callback.  */
+
+typedef struct
+{
+  size_t count;
+  double num;
+  void *data;
+} rec_aggregate_state_t;
+
+/* Callbacks implementing an incremental aggregate.  All of them
+   return 'false' (or NULL) if there is not enough memory to perform
+   the operation.  */
+
+typedef bool  (*rec_aggregate_init_fn_t)       (rec_aggregate_state_t *state);
+typedef bool  (*rec_aggregate_accumulate_fn_t) (rec_aggregate_state_t *state,
+                                                rec_record_t record,
+                                                const char *field_name);
+typedef bool  (*rec_aggregate_merge_fn_t)      (rec_aggregate_state_t *state,
+                                                rec_aggregate_state_t *other);
+typedef char *(*rec_aggregate_finalize_fn_t)   (rec_aggregate_state_t *state);
+
+typedef struct
+{
+  rec_aggregate_init_fn_t init;
+  rec_aggregate_accumulate_fn_t accumulate;
+  rec_aggregate_merge_fn_t merge;
+  rec_aggregate_finalize_fn_t finalize;
+} rec_aggregate_incr_t;
+
+/* Evaluate an incremental aggregate.  If RECORD is not NULL then the
+   aggregate is applied to the fields of that record.  Otherwise it is
+   applied to all the records stored in RSET.  This function has the
+   same semantics than a rec_aggregate_t function, and returns NULL if
+   there is not enough memory to perform the operation.  */
+
+char *rec_aggregate_incr_apply (const rec_aggregate_incr_t *incr,
+                                rec_rset_t rset,
+                                rec_record_t record,
+                                const char *field_name);
+
 /*
  * AGGREGATES REGISTRIES
  *
@@ -2258,8 +2557,28 @@ bool rec_aggregate_reg_add (rec_aggregate_reg_t func_reg, const char *name, rec_
 
 rec_aggregate_t rec_aggregate_reg_get (rec_aggregate_reg_t func_get, const char *name);
 
+/* Register an incremental aggregate into a functions register,
+   associating it with a given constant string.  The contents of INCR
+   are copied into the registry.  If an aggregate associated with the
+   given string already exists in the registry then it is substituted
+   by the provided one.  The function returns true if the operation
+   was successful, and false if there was not enough memory to perform
+   the operation.  */
+
+bool rec_aggregate_reg_add_incr (rec_aggregate_reg_t func_reg, const char *name,
+                                 const rec_aggregate_incr_t *incr);
+
+/* Fetch an incremental aggregate from a functions registry.  If no
+   incremental aggregate associated with NAME is found in the registry
+   then NULL is returned.  Note that aggregates registered with
+   rec_aggregate_reg_add are not incremental.  */
+
+const rec_aggregate_incr_t *rec_aggregate_reg_get_incr (rec_aggregate_reg_t func_reg,
+                                                        const char *name);
+
 /* Register the standard built-in functions shipped with librec in the
-   given aggregate register.  */
+   given aggregate register.  The standard aggregates are registered
+   both as regular and incremental aggregates.  */
 
 void rec_aggregate_reg_add_standard (rec_aggregate_reg_t func_reg);
 
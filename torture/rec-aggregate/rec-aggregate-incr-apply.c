@@ -0,0 +1,240 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-aggregate-incr-apply.c
+ *       Date:         Sun Oct 18 22:41:07 2026
+ *
+ *       GNU recutils - rec_aggregate_incr_apply unit tests
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include <rec.h>
+#include <rec-torture.h>
+
+/* Concat(Field) concatenates the values of the fields in DATA.  It
+   fails when it finds a field whose value is "fail", and counts in
+   FINALIZED how many states it finalized.  */
+
+static size_t finalized = 0;
+
+static bool
+concat_init (rec_aggregate_state_t *state)
+{
+  state->count = 0;
+  state->num = 0;
+  state->data = strdup ("");
+  return (state->data != NULL);
+}
+
+static bool
+concat_accumulate (rec_aggregate_state_t *state,
+                   rec_record_t record,
+                   const char *field_name)
+{
+  size_t i;
+  size_t num_fields = rec_record_get_num_fields_by_name (record, field_name);
+
+  for (i = 0; i < num_fields; i++)
+    {
+      rec_field_t field = rec_record_get_field_by_name (record, field_name, i);
+      const char *value = rec_field_value (field);
+      char *data;
+
+      if (strcmp (value, "fail") == 0)
+        return false;
+
+      data = realloc (state->data, strlen (state->data) + strlen (value) + 1);
+      if (!data)
+        return false;
+      strcat (data, value);
+      state->data = data;
+      state->count++;
+    }
+
+  return true;
+}
+
+static bool
+concat_merge (rec_aggregate_state_t *state,
+              rec_aggregate_state_t *other)
+{
+  char *data;
+
+  data = realloc (state->data, strlen (state->data) + strlen (other->data) + 1);
+  if (!data)
+    return false;
+  strcat (data, other->data);
+  state->data = data;
+  state->count = state->count + other->count;
+
+  return true;
+}
+
+static char *
+concat_finalize (rec_aggregate_state_t *state)
+{
+  finalized++;
+  return state->data;
+}
+
+static const rec_aggregate_incr_t concat_aggregate =
+  { concat_init, concat_accumulate, concat_merge, concat_finalize };
+
+/*-
+ * Test: rec_aggregate_incr_apply_nominal
+ * Unit: rec_aggregate_incr_apply
+ * Description:
+ * + Apply an incremental aggregate to a record
+ * + and to all the records of a record set.
+ */
+START_TEST(rec_aggregate_incr_apply_nominal)
+{
+  rec_rset_t rset;
+  rec_record_t record;
+  char *res;
+
+  rset = torture_parse_rset ("%rec: Item\n\nV: a\nV: b\nW: x\n\nV: c\n\nW: y\n");
+  fail_if (rset == NULL);
+
+  record = rec_mset_get_at (rec_rset_mset (rset), MSET_RECORD, 0);
+  fail_if (record == NULL);
+
+  finalized = 0;
+  res = rec_aggregate_incr_apply (&concat_aggregate, rset, record, "V");
+  fail_if (res == NULL);
+  fail_if (strcmp (res, "ab") != 0);
+  free (res);
+
+  res = rec_aggregate_incr_apply (&concat_aggregate, rset, NULL, "V");
+  fail_if (res == NULL);
+  fail_if (strcmp (res, "abc") != 0);
+  free (res);
+
+  res = rec_aggregate_incr_apply (&concat_aggregate, NULL, NULL, "V");
+  fail_if (res == NULL);
+  fail_if (strcmp (res, "") != 0);
+  free (res);
+
+  fail_if (finalized != 3);
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+/*-
+ * Test: rec_aggregate_incr_apply_error
+ * Unit: rec_aggregate_incr_apply
+ * Description:
+ * + Apply an incremental aggregate that fails
+ * + while accumulating.  The state shall be
+ * + finalized anyway and NULL returned.
+ */
+START_TEST(rec_aggregate_incr_apply_error)
+{
+  rec_rset_t rset;
+
+  rset = torture_parse_rset ("%rec: Item\n\nV: a\n\nV: fail\n\nV: c\n");
+  fail_if (rset == NULL);
+
+  finalized = 0;
+  fail_if (rec_aggregate_incr_apply (&concat_aggregate, rset, NULL, "V") != NULL);
+  fail_if (finalized != 1);
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+/*-
+ * Test: rec_aggregate_incr_apply_merge
+ * Unit: rec_aggregate_incr_apply
+ * Description:
+ * + Accumulate two halves of a record set in
+ * + separated states and merge them.  The
+ * + result shall be the same than applying the
+ * + aggregate to the whole record set.
+ */
+START_TEST(rec_aggregate_incr_apply_merge)
+{
+  rec_aggregate_reg_t reg;
+  const rec_aggregate_incr_t *incr;
+  rec_aggregate_state_t state, other;
+  rec_rset_t rset;
+  rec_record_t record;
+  const char *names[] = { "Count", "Avg", "Sum", "Min", "Max", "Concat" };
+  char *res, *expected;
+  size_t num_records, i, j;
+
+  rset = torture_parse_rset ("%rec: Item\n\nV: 3\n\nV: 10\nV: 2.5\n\nW: 1\n\n"
+                     "V: -4\n\nV: 7\n\nV: 1\nV: 6\n");
+  fail_if (rset == NULL);
+  num_records = rec_rset_num_records (rset);
+
+  reg = rec_aggregate_reg_new ();
+  fail_if (reg == NULL);
+  rec_aggregate_reg_add_standard (reg);
+  fail_if (!rec_aggregate_reg_add_incr (reg, "Concat", &concat_aggregate));
+
+  for (i = 0; i < sizeof (names) / sizeof (names[0]); i++)
+    {
+      incr = rec_aggregate_reg_get_incr (reg, names[i]);
+      fail_if (incr == NULL);
+
+      fail_if (!incr->init (&state));
+      fail_if (!incr->init (&other));
+      for (j = 0; j < num_records; j++)
+        {
+          record = rec_mset_get_at (rec_rset_mset (rset), MSET_RECORD, j);
+          fail_if (!incr->accumulate ((j < num_records / 2) ? &state : &other,
+                                      record, "V"));
+        }
+      fail_if (!incr->merge (&state, &other));
+      free (incr->finalize (&other));
+      res = incr->finalize (&state);
+      fail_if (res == NULL);
+
+      expected = rec_aggregate_incr_apply (incr, rset, NULL, "V");
+      fail_if (expected == NULL);
+      fail_if (strcmp (res, expected) != 0);
+
+      free (expected);
+      free (res);
+    }
+
+  rec_aggregate_reg_destroy (reg);
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+/*
+ * Test creation function
+ */
+TCase *
+test_rec_aggregate_incr_apply (void)
+{
+  TCase *tc = tcase_create ("rec_aggregate_incr_apply");
+  tcase_add_test (tc, rec_aggregate_incr_apply_nominal);
+  tcase_add_test (tc, rec_aggregate_incr_apply_error);
+  tcase_add_test (tc, rec_aggregate_incr_apply_merge);
+
+  return tc;
+}
+
+/* End of rec-aggregate-incr-apply.c */
@@ -0,0 +1,214 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-aggregate-reg-add-incr.c
+ *       Date:         Sun Oct 18 22:41:07 2026
+ *
+ *       GNU recutils - rec_aggregate_reg_add_incr unit tests
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include <rec.h>
+
+/* Prod(Field) multiplies the values of the fields.  */
+
+static bool
+prod_init (rec_aggregate_state_t *state)
+{
+  state->count = 0;
+  state->num = 1;
+  state->data = NULL;
+  return true;
+}
+
+static bool
+prod_accumulate (rec_aggregate_state_t *state,
+                 rec_record_t record,
+                 const char *field_name)
+{
+  size_t i;
+  size_t num_fields = rec_record_get_num_fields_by_name (record, field_name);
+
+  for (i = 0; i < num_fields; i++)
+    {
+      rec_field_t field = rec_record_get_field_by_name (record, field_name, i);
+      state->num = state->num * atof (rec_field_value (field));
+    }
+
+  return true;
+}
+
+static bool
+prod_merge (rec_aggregate_state_t *state,
+            rec_aggregate_state_t *other)
+{
+  state->num = state->num * other->num;
+  return true;
+}
+
+static char *
+prod_finalize (rec_aggregate_state_t *state)
+{
+  char buf[32];
+
+  sprintf (buf, "%d", (int) state->num);
+  return strdup (buf);
+}
+
+static const rec_aggregate_incr_t prod_aggregate =
+  { prod_init, prod_accumulate, prod_merge, prod_finalize };
+
+static char *
+nothing_aggregate (rec_rset_t rset,
+                   rec_record_t record,
+                   const char *field_name)
+{
+  return strdup ("nothing");
+}
+
+static const char *
+query_value (rec_db_t db,
+             const char *fex_str,
+             const char *group_by_str,
+             size_t num_record,
+             const char *field_name)
+{
+  /* Run a query on the record set Item of DB and return the value of
+     the field FIELD_NAME in the record NUM_RECORD of the result.  The
+     result is leaked, which doesn't matter in a test.  */
+
+  rec_rset_t res;
+  rec_record_t record;
+  rec_field_t field;
+  rec_fex_t fex = rec_fex_new (fex_str, REC_FEX_SUBSCRIPTS);
+  rec_fex_t group_by = NULL;
+
+  if (group_by_str)
+    group_by = rec_fex_new (group_by_str, REC_FEX_SIMPLE);
+
+  res = rec_db_query (db, "Item", NULL, NULL, NULL, NULL, 0,
+                      fex, NULL, group_by, NULL, 0);
+  if (!res)
+    return NULL;
+
+  record = rec_mset_get_at (rec_rset_mset (res), MSET_RECORD, num_record);
+  if (!record)
+    return NULL;
+
+  field = rec_record_get_field_by_name (record, field_name, 0);
+  return field ? rec_field_value (field) : NULL;
+}
+
+/*-
+ * Test: rec_aggregate_reg_add_incr_query
+ * Unit: rec_aggregate_reg_add_incr
+ * Description:
+ * + Register a custom incremental aggregate in
+ * + the registry of a database and use it in
+ * + queries, on the whole record set, on every
+ * + record and on every group.
+ */
+START_TEST(rec_aggregate_reg_add_incr_query)
+{
+  rec_parser_t parser;
+  rec_db_t db;
+  const char *value;
+  char *str;
+
+  str = "%rec: Item\n\n"
+    "Kind: a\nValue: 2\n\n"
+    "Kind: a\nValue: 3\n\n"
+    "Kind: b\nValue: 5\nValue: 7\n";
+  parser = rec_parser_new_str (str, "dummy");
+  fail_if (!rec_parse_db (parser, &db));
+  rec_parser_destroy (parser);
+
+  fail_if (!rec_aggregate_reg_add_incr (rec_db_aggregates (db), "Prod",
+                                        &prod_aggregate));
+  fail_if (rec_aggregate_reg_get_incr (rec_db_aggregates (db), "prod") == NULL);
+
+  value = query_value (db, "Prod(Value)", NULL, 0, "Prod_Value");
+  fail_if (value == NULL);
+  fail_if (strcmp (value, "210") != 0);
+
+  value = query_value (db, "Kind,Prod(Value)", NULL, 2, "Prod_Value");
+  fail_if (value == NULL);
+  fail_if (strcmp (value, "35") != 0);
+
+  value = query_value (db, "Kind,Prod(Value)", "Kind", 0, "Prod_Value");
+  fail_if (value == NULL);
+  fail_if (strcmp (value, "6") != 0);
+  value = query_value (db, "Kind,Prod(Value)", "Kind", 1, "Prod_Value");
+  fail_if (value == NULL);
+  fail_if (strcmp (value, "35") != 0);
+
+  rec_db_destroy (db);
+}
+END_TEST
+
+/*-
+ * Test: rec_aggregate_reg_add_incr_replace
+ * Unit: rec_aggregate_reg_add_incr
+ * Description:
+ * + Replace a regular aggregate with an
+ * + incremental one and the other way around.
+ */
+START_TEST(rec_aggregate_reg_add_incr_replace)
+{
+  rec_aggregate_reg_t reg;
+
+  reg = rec_aggregate_reg_new ();
+  fail_if (reg == NULL);
+
+  fail_if (!rec_aggregate_reg_add (reg, "Prod", nothing_aggregate));
+  fail_if (rec_aggregate_reg_get_incr (reg, "Prod") != NULL);
+
+  fail_if (!rec_aggregate_reg_add_incr (reg, "Prod", &prod_aggregate));
+  fail_if (rec_aggregate_reg_get_incr (reg, "Prod") == NULL);
+  fail_if (rec_aggregate_reg_get_incr (reg, "Prod")->accumulate
+           != prod_accumulate);
+  fail_if (rec_aggregate_reg_get (reg, "Prod") != NULL);
+
+  fail_if (!rec_aggregate_reg_add (reg, "Prod", nothing_aggregate));
+  fail_if (rec_aggregate_reg_get_incr (reg, "Prod") != NULL);
+  fail_if (rec_aggregate_reg_get (reg, "Prod") != nothing_aggregate);
+
+  rec_aggregate_reg_destroy (reg);
+}
+END_TEST
+
+/*
+ * Test creation function
+ */
+TCase *
+test_rec_aggregate_reg_add_incr (void)
+{
+  TCase *tc = tcase_create ("rec_aggregate_reg_add_incr");
+  tcase_add_test (tc, rec_aggregate_reg_add_incr_query);
+  tcase_add_test (tc, rec_aggregate_reg_add_incr_replace);
+
+  return tc;
+}
+
+/* End of rec-aggregate-reg-add-incr.c */
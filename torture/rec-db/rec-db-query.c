@@ -0,0 +1,246 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-db-query.c
+ *       Date:         Sun Oct 18 23:05:12 2026
+ *
+ *       GNU recutils - rec_db_query unit tests
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include <rec.h>
+
+/* Build a database with a record set Item containing NUM_RECORDS
+   records, whose Id fields go from 0 to NUM_RECORDS - 1.  */
+
+static rec_db_t
+new_db (size_t num_records)
+{
+  rec_db_t db;
+  rec_rset_t rset;
+  rec_record_t record;
+  rec_field_t field;
+  char value[32];
+  size_t i;
+
+  db = rec_db_new ();
+  rset = rec_rset_new ();
+  if (!db || !rset)
+    return NULL;
+
+  rec_rset_set_type (rset, "Item");
+  for (i = 0; i < num_records; i++)
+    {
+      sprintf (value, "%zu", i);
+      record = rec_record_new ();
+      field = rec_field_new ("Id", value);
+      if (!record || !field
+          || !rec_mset_append (rec_record_mset (record), MSET_FIELD,
+                               (void *) field, MSET_ANY)
+          || !rec_mset_append (rec_rset_mset (rset), MSET_RECORD,
+                               (void *) record, MSET_ANY))
+        return NULL;
+    }
+
+  if (!rec_db_insert_rset (db, rset, rec_db_size (db)))
+    return NULL;
+
+  return db;
+}
+
+/* Store in IDS the Id fields of the records in RSET, and return the
+   number of records.  */
+
+static size_t
+get_ids (rec_rset_t rset, long *ids)
+{
+  rec_record_t record;
+  rec_mset_iterator_t iter;
+  size_t num_records = 0;
+
+  iter = rec_mset_iterator (rec_rset_mset (rset));
+  while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+    {
+      rec_field_t field = rec_record_get_field_by_name (record, "Id", 0);
+      ids[num_records++] = field ? atol (rec_field_value (field)) : -1;
+    }
+  rec_mset_iterator_free (&iter);
+
+  return num_records;
+}
+
+/*-
+ * Test: rec_db_query_random
+ * Unit: rec_db_query
+ * Description:
+ * + Select random records.  The requested number
+ * + of records shall be returned, in the order
+ * + they have in the record set.
+ */
+START_TEST(rec_db_query_random)
+{
+  rec_db_t db;
+  rec_rset_t res;
+  long ids[300];
+  size_t sizes[] = { 1, 5, 128, 299 };
+  size_t i, j, k;
+
+  db = new_db (300);
+  fail_if (db == NULL);
+
+  for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    for (j = 0; j < 20; j++)
+      {
+        res = rec_db_query (db, "Item", NULL, NULL, NULL, NULL, sizes[i],
+                            NULL, NULL, NULL, NULL, 0);
+        fail_if (res == NULL);
+        fail_if (get_ids (res, ids) != sizes[i]);
+        for (k = 0; k < sizes[i]; k++)
+          {
+            fail_if ((ids[k] < 0) || (ids[k] >= 300));
+            fail_if ((k > 0) && (ids[k - 1] >= ids[k]));
+          }
+        rec_rset_destroy (res);
+      }
+
+  rec_db_destroy (db);
+}
+END_TEST
+
+/*-
+ * Test: rec_db_query_random_all
+ * Unit: rec_db_query
+ * Description:
+ * + Select at least as many random records as
+ * + there are in the record set.  All of them
+ * + shall be returned.
+ */
+START_TEST(rec_db_query_random_all)
+{
+  rec_db_t db;
+  rec_rset_t res;
+  long ids[300];
+  size_t sizes[] = { 300, 1000 };
+  size_t i, k;
+
+  db = new_db (300);
+  fail_if (db == NULL);
+
+  for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+      res = rec_db_query (db, "Item", NULL, NULL, NULL, NULL, sizes[i],
+                          NULL, NULL, NULL, NULL, 0);
+      fail_if (res == NULL);
+      fail_if (get_ids (res, ids) != 300);
+      for (k = 0; k < 300; k++)
+        fail_if (ids[k] != k);
+      rec_rset_destroy (res);
+    }
+
+  rec_db_destroy (db);
+}
+END_TEST
+
+/*-
+ * Test: rec_db_query_random_empty
+ * Unit: rec_db_query
+ * Description:
+ * + Select random records from an empty record
+ * + set.
+ */
+START_TEST(rec_db_query_random_empty)
+{
+  rec_db_t db;
+  rec_rset_t res;
+
+  db = new_db (0);
+  fail_if (db == NULL);
+
+  res = rec_db_query (db, "Item", NULL, NULL, NULL, NULL, 3,
+                      NULL, NULL, NULL, NULL, 0);
+  fail_if (res == NULL);
+  fail_if (rec_rset_num_records (res) != 0);
+  rec_rset_destroy (res);
+
+  rec_db_destroy (db);
+}
+END_TEST
+
+/*-
+ * Test: rec_db_query_index
+ * Unit: rec_db_query
+ * Description:
+ * + Select records by position, using unsorted
+ * + and overlapping intervals, some of them past
+ * + the end of the record set.
+ */
+START_TEST(rec_db_query_index)
+{
+  rec_db_t db;
+  rec_rset_t res;
+  long ids[300];
+  long expected[] = { 1, 2, 3, 4, 5,
+                      250, 251, 252, 253, 254, 255, 256, 257, 258, 259, 260,
+                      299 };
+  size_t index[] = { 250, 260,
+                     5, REC_Q_NOINDEX,
+                     1, 3,
+                     2, 4,
+                     299, 400,
+                     255, 256,
+                     REC_Q_NOINDEX, REC_Q_NOINDEX };
+  size_t num_expected = sizeof (expected) / sizeof (expected[0]);
+  size_t k;
+
+  db = new_db (300);
+  fail_if (db == NULL);
+
+  res = rec_db_query (db, "Item", NULL, index, NULL, NULL, 0,
+                      NULL, NULL, NULL, NULL, 0);
+  fail_if (res == NULL);
+  fail_if (get_ids (res, ids) != num_expected);
+  for (k = 0; k < num_expected; k++)
+    fail_if (ids[k] != expected[k]);
+  rec_rset_destroy (res);
+
+  rec_db_destroy (db);
+}
+END_TEST
+
+/*
+ * Test creation function
+ */
+TCase *
+test_rec_db_query (void)
+{
+  TCase *tc = tcase_create ("rec_db_query");
+  tcase_add_test (tc, rec_db_query_random);
+  tcase_add_test (tc, rec_db_query_random_all);
+  tcase_add_test (tc, rec_db_query_random_empty);
+  tcase_add_test (tc, rec_db_query_index);
+
+  return tc;
+}
+
+/* End of rec-db-query.c */
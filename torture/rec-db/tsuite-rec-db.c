@@ -0,0 +1,42 @@
+/* -*- mode: C -*-
+ *
+ *       File:         tsuite-rec-db.c
+ *       Date:         Sun Oct 18 23:05:12 2026
+ *
+ *       GNU recutils - rec_db test suite
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <check.h>
+
+extern TCase *test_rec_db_query (void);
+
+Suite *
+tsuite_rec_db ()
+{
+  Suite *s;
+
+  s = suite_create ("rec-db");
+  suite_add_tcase (s, test_rec_db_query ());
+
+  return s;
+}
+
+/* End of tsuite-rec-db.c */
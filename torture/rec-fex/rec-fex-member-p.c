@@ -0,0 +1,146 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-fex-member-p.c
+ *       Date:         Sun Oct 18 12:10:31 2026
+ *
+ *       GNU recutils - rec_fex_member_p unit tests.
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <check.h>
+
+#include <rec.h>
+
+/*-
+ * Test: rec_fex_member_p_nominal
+ * Unit: rec_fex_member_p
+ * Description:
+ * + Check for the presence of field names
+ * + in a small field expression.
+ */
+START_TEST(rec_fex_member_p_nominal)
+{
+  rec_fex_t fex;
+
+  fex = rec_fex_new ("foo,bar[1],baz[2-3]", REC_FEX_SUBSCRIPTS);
+  fail_if (fex == NULL);
+  fail_if (!rec_fex_member_p (fex, "foo", -1, -1));
+  fail_if (!rec_fex_member_p (fex, "bar", -1, -1));
+  fail_if (!rec_fex_member_p (fex, "bar", 1, -1));
+  fail_if (rec_fex_member_p (fex, "bar", 0, -1));
+  fail_if (!rec_fex_member_p (fex, "baz", 2, 3));
+  fail_if (rec_fex_member_p (fex, "baz", 2, 4));
+  fail_if (rec_fex_member_p (fex, "xxx", -1, -1));
+  rec_fex_destroy (fex);
+}
+END_TEST
+
+/*-
+ * Test: rec_fex_member_p_wide
+ * Unit: rec_fex_member_p
+ * Description:
+ * + Check for the presence of field names
+ * + in a field expression with many elements,
+ * + also after appending and renaming
+ * + elements.
+ */
+START_TEST(rec_fex_member_p_wide)
+{
+  rec_fex_t fex;
+  rec_fex_t copy;
+  char name[32];
+  size_t i;
+
+  fex = rec_fex_new (NULL, REC_FEX_SIMPLE);
+  fail_if (fex == NULL);
+  for (i = 0; i < 1000; i++)
+    {
+      sprintf (name, "field%zu", i);
+      fail_if (rec_fex_append (fex, name, -1, -1) == NULL);
+    }
+  fail_if (rec_fex_size (fex) != 1000);
+
+  fail_if (!rec_fex_member_p (fex, "field0", -1, -1));
+  fail_if (!rec_fex_member_p (fex, "field999", -1, -1));
+  fail_if (rec_fex_member_p (fex, "field1000", -1, -1));
+
+  fail_if (rec_fex_append (fex, "field1000", -1, -1) == NULL);
+  fail_if (!rec_fex_member_p (fex, "field1000", -1, -1));
+
+  fail_if (!rec_fex_elem_set_field_name (rec_fex_get (fex, 0), "other"));
+  fail_if (rec_fex_member_p (fex, "field0", -1, -1));
+  fail_if (!rec_fex_member_p (fex, "other", -1, -1));
+
+  copy = rec_fex_dup (fex);
+  fail_if (copy == NULL);
+  rec_fex_destroy (fex);
+  fail_if (rec_fex_size (copy) != 1001);
+  fail_if (!rec_fex_member_p (copy, "other", -1, -1));
+  fail_if (!rec_fex_member_p (copy, "field500", -1, -1));
+  rec_fex_destroy (copy);
+}
+END_TEST
+
+/*-
+ * Test: rec_fex_member_p_parsed
+ * Unit: rec_fex_member_p
+ * Description:
+ * + Check for the presence of field names
+ * + in a parsed field expression with many
+ * + elements and a repeated name, also after
+ * + renaming one of the repeated elements.
+ */
+START_TEST(rec_fex_member_p_parsed)
+{
+  rec_fex_t fex;
+
+  fex = rec_fex_new ("a b c d e f g h i a", REC_FEX_SIMPLE);
+  fail_if (fex == NULL);
+  fail_if (!rec_fex_member_p (fex, "a", -1, -1));
+  fail_if (!rec_fex_member_p (fex, "i", -1, -1));
+  fail_if (rec_fex_member_p (fex, "j", -1, -1));
+
+  fail_if (!rec_fex_elem_set_field_name (rec_fex_get (fex, 0), "z"));
+  fail_if (!rec_fex_member_p (fex, "a", -1, -1));
+  fail_if (!rec_fex_member_p (fex, "z", -1, -1));
+
+  fail_if (!rec_fex_elem_set_field_name (rec_fex_get (fex, 9), "y"));
+  fail_if (rec_fex_member_p (fex, "a", -1, -1));
+  fail_if (!rec_fex_member_p (fex, "y", -1, -1));
+  rec_fex_destroy (fex);
+}
+END_TEST
+
+/*
+ * Test case creation function
+ */
+TCase *
+test_rec_fex_member_p (void)
+{
+  TCase *tc = tcase_create ("rec_fex_member_p");
+  tcase_add_test (tc, rec_fex_member_p_nominal);
+  tcase_add_test (tc, rec_fex_member_p_wide);
+  tcase_add_test (tc, rec_fex_member_p_parsed);
+
+  return tc;
+}
+
+/* End of rec-fex-member-p.c */
@@ -37,6 +37,7 @@ extern TCase *test_rec_fex_elem_rewrite_to (void);
 extern TCase *test_rec_fex_elem_min (void);
 extern TCase *test_rec_fex_elem_max (void);
 extern TCase *test_rec_fex_str (void);
+extern TCase *test_rec_fex_member_p (void);
 
 Suite *
 tsuite_rec_fex ()
@@ -55,6 +56,7 @@ tsuite_rec_fex ()
   suite_add_tcase (s, test_rec_fex_elem_min ());
   suite_add_tcase (s, test_rec_fex_elem_max ());
   suite_add_tcase (s, test_rec_fex_str ());
+  suite_add_tcase (s, test_rec_fex_member_p ());
 
   return s;
 }
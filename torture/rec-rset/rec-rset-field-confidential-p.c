@@ -0,0 +1,137 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-rset-field-confidential-p.c
+ *       Date:         Sun Oct 18 23:52:40 2026
+ *
+ *       GNU recutils - rec_rset_field_confidential_p unit tests
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include <rec.h>
+#include <rec-torture.h>
+
+#if defined REC_CRYPT_SUPPORT
+
+/*-
+ * Test: rec_rset_field_confidential_p_nominal
+ * Unit: rec_rset_field_confidential_p
+ * Description:
+ * + Check which fields are confidential in a
+ * + record set declaring several confidential
+ * + fields in several %confidential entries,
+ * + among other field properties.
+ */
+START_TEST(rec_rset_field_confidential_p_nominal)
+{
+  rec_rset_t rset;
+
+  rset = torture_parse_rset ("%rec: Account\n"
+                     "%type: Id int\n"
+                     "%confidential: Password Pin\n"
+                     "%key: Id\n"
+                     "%type: Pin int\n"
+                     "%confidential: Answer\n"
+                     "\nId: 1\n");
+  fail_if (rset == NULL);
+
+  fail_if (!rec_rset_field_confidential_p (rset, "Password"));
+  fail_if (!rec_rset_field_confidential_p (rset, "Pin"));
+  fail_if (!rec_rset_field_confidential_p (rset, "Answer"));
+  fail_if (rec_rset_field_confidential_p (rset, "Id"));
+  fail_if (rec_rset_field_confidential_p (rset, "Name"));
+  fail_if (rec_rset_field_confidential_p (rset, "password"));
+  fail_if (rec_rset_get_field_type (rset, "Pin") == NULL);
+
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+/*-
+ * Test: rec_rset_field_confidential_p_dup
+ * Unit: rec_rset_field_confidential_p
+ * Description:
+ * + Check the confidential fields of a copy of
+ * + a record set, which doesn't have field
+ * + properties.
+ */
+START_TEST(rec_rset_field_confidential_p_dup)
+{
+  rec_rset_t rset;
+  rec_rset_t dup;
+
+  rset = torture_parse_rset ("%rec: Account\n%confidential: Password\n\nId: 1\n");
+  fail_if (rset == NULL);
+  dup = rec_rset_dup (rset);
+  fail_if (dup == NULL);
+
+  fail_if (rec_rset_field_confidential_p (dup, "Password"));
+  fail_if (!rec_rset_field_confidential_p (rset, "Password"));
+
+  rec_rset_destroy (dup);
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+#endif /* REC_CRYPT_SUPPORT */
+
+/*-
+ * Test: rec_rset_field_confidential_p_none
+ * Unit: rec_rset_field_confidential_p
+ * Description:
+ * + Check the fields of a record set without
+ * + confidential fields.
+ */
+START_TEST(rec_rset_field_confidential_p_none)
+{
+  rec_rset_t rset;
+
+  rset = torture_parse_rset ("%rec: Account\n%type: Id int\n\nId: 1\n");
+  fail_if (rset == NULL);
+
+  fail_if (rec_rset_field_confidential_p (rset, "Id"));
+  fail_if (rec_rset_field_confidential_p (rset, "Password"));
+  fail_if (rec_rset_field_confidential_p (rset, NULL));
+
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+/*
+ * Test creation function
+ */
+TCase *
+test_rec_rset_field_confidential_p (void)
+{
+  TCase *tc = tcase_create ("rec_rset_field_confidential_p");
+#if defined REC_CRYPT_SUPPORT
+  tcase_add_test (tc, rec_rset_field_confidential_p_nominal);
+  tcase_add_test (tc, rec_rset_field_confidential_p_dup);
+#endif
+  tcase_add_test (tc, rec_rset_field_confidential_p_none);
+
+  return tc;
+}
+
+/* End of rec-rset-field-confidential-p.c */
@@ -0,0 +1,190 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-rset-get-field-type.c
+ *       Date:         Sun Oct 18 23:52:40 2026
+ *
+ *       GNU recutils - rec_rset_get_field_type unit tests
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include <rec.h>
+#include <rec-torture.h>
+
+/* Build a record set whose descriptor declares the types of
+   NUM_FIELDS fields F0, F1, ...  The field Fi has type int if i is
+   even and type line if i is odd.  The descriptor also declares a
+   named type used by the field Named, the field Over, whose type is
+   declared twice, and the auto field Counter, which is implicitly
+   typed as an integer.  */
+
+static rec_rset_t
+new_rset (size_t num_fields)
+{
+  rec_rset_t rset;
+  char *str;
+  char *p;
+  size_t i;
+
+  str = malloc (256 + 32 * num_fields);
+  if (!str)
+    return NULL;
+
+  p = str + sprintf (str, "%%rec: Item\n%%typedef: Id_t int\n");
+  for (i = 0; i < num_fields; i++)
+    p += sprintf (p, "%%type: F%zu %s\n", i, (i % 2) ? "line" : "int");
+  sprintf (p,
+           "%%type: Named Id_t\n"
+           "%%type: Over int\n"
+           "%%type: Over bool\n"
+           "%%auto: Counter\n"
+           "\nF0: 1\n");
+
+  rset = torture_parse_rset (str);
+  free (str);
+  return rset;
+}
+
+/*-
+ * Test: rec_rset_get_field_type_many
+ * Unit: rec_rset_get_field_type
+ * Description:
+ * + Get the types of the fields of a record
+ * + set declaring many typed fields.
+ */
+START_TEST(rec_rset_get_field_type_many)
+{
+  rec_rset_t rset;
+  rec_type_t type;
+  char fname[32];
+  size_t i;
+
+  rset = new_rset (300);
+  fail_if (rset == NULL);
+
+  for (i = 0; i < 300; i++)
+    {
+      sprintf (fname, "F%zu", i);
+      type = rec_rset_get_field_type (rset, fname);
+      fail_if (type == NULL);
+      fail_if (rec_type_kind (type) != ((i % 2) ? REC_TYPE_LINE : REC_TYPE_INT));
+    }
+
+  type = rec_rset_get_field_type (rset, "Named");
+  fail_if (type == NULL);
+  fail_if (rec_type_kind (type) != REC_TYPE_INT);
+
+  type = rec_rset_get_field_type (rset, "Over");
+  fail_if (type == NULL);
+  fail_if (rec_type_kind (type) != REC_TYPE_BOOL);
+
+  type = rec_rset_get_field_type (rset, "Counter");
+  fail_if (type == NULL);
+  fail_if (rec_type_kind (type) != REC_TYPE_INT);
+
+  fail_if (rec_rset_get_field_type (rset, "F300") != NULL);
+  fail_if (rec_rset_get_field_type (rset, "f0") != NULL);
+  fail_if (rec_rset_get_field_type (rset, "Unknown") != NULL);
+
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+/*-
+ * Test: rec_rset_get_field_type_dup
+ * Unit: rec_rset_get_field_type
+ * Description:
+ * + Get the types of the fields of a copy of
+ * + a record set.  Copies don't have field
+ * + properties.
+ */
+START_TEST(rec_rset_get_field_type_dup)
+{
+  rec_rset_t rset;
+  rec_rset_t dup;
+
+  rset = new_rset (10);
+  fail_if (rset == NULL);
+
+  dup = rec_rset_dup (rset);
+  fail_if (dup == NULL);
+  fail_if (rec_rset_num_records (dup) != 1);
+  fail_if (rec_rset_get_field_type (dup, "F0") != NULL);
+  fail_if (rec_rset_get_field_type (dup, "Over") != NULL);
+  fail_if (rec_rset_get_field_type (dup, NULL) != NULL);
+  rec_rset_destroy (dup);
+
+  fail_if (rec_rset_get_field_type (rset, "F0") == NULL);
+  rec_rset_destroy (rset);
+}
+END_TEST
+
+/*-
+ * Test: rec_rset_get_field_type_null
+ * Unit: rec_rset_get_field_type
+ * Description:
+ * + Get the type of a NULL field name, which is
+ * + what rec_rset_key returns for record sets
+ * + without a valid key.
+ */
+START_TEST(rec_rset_get_field_type_null)
+{
+  rec_parser_t parser;
+  rec_rset_t rset;
+  const char *strs[] = { "%rec: Item\n%type: Id int\n\nId: 1\n",
+                         "%rec: Item\n%type: Id int\n%key:\n\nId: 1\n",
+                         "%rec: Item\n%key: 9bad\n%type: Id int\n\nId: 1\n" };
+  size_t i;
+
+  for (i = 0; i < sizeof (strs) / sizeof (strs[0]); i++)
+    {
+      rset = NULL;
+      parser = rec_parser_new_str (strs[i], "dummy");
+      fail_if (parser == NULL);
+      fail_if (!rec_parse_rset (parser, &rset));
+      rec_parser_destroy (parser);
+
+      fail_if (rec_rset_key (rset) != NULL);
+      fail_if (rec_rset_get_field_type (rset, rec_rset_key (rset)) != NULL);
+      fail_if (rec_rset_get_field_type (rset, "Id") == NULL);
+      rec_rset_destroy (rset);
+    }
+}
+END_TEST
+
+/*
+ * Test creation function
+ */
+TCase *
+test_rec_rset_get_field_type (void)
+{
+  TCase *tc = tcase_create ("rec_rset_get_field_type");
+  tcase_add_test (tc, rec_rset_get_field_type_many);
+  tcase_add_test (tc, rec_rset_get_field_type_dup);
+  tcase_add_test (tc, rec_rset_get_field_type_null);
+
+  return tc;
+}
+
+/* End of rec-rset-get-field-type.c */
@@ -0,0 +1,65 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-torture.c
+ *       Date:         Sun Oct 18 12:10:31 2026
+ *
+ *       GNU recutils - Utilities shared by the unit tests
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <rec.h>
+#include <rec-torture.h>
+
+rec_rset_t
+torture_parse_rset (const char *str)
+{
+  rec_parser_t parser;
+  rec_rset_t rset = NULL;
+
+  parser = rec_parser_new_str (str, "dummy");
+  if (parser)
+    {
+      if (!rec_parse_rset (parser, &rset))
+        rset = NULL;
+      rec_parser_destroy (parser);
+    }
+
+  return rset;
+}
+
+rec_db_t
+torture_parse_db (const char *str)
+{
+  rec_parser_t parser;
+  rec_db_t db = NULL;
+
+  parser = rec_parser_new_str (str, "dummy");
+  if (parser)
+    {
+      if (!rec_parse_db (parser, &db))
+        db = NULL;
+      rec_parser_destroy (parser);
+    }
+
+  return db;
+}
+
+/* End of rec-torture.c */
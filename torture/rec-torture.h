@@ -0,0 +1,43 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-torture.h
+ *       Date:         Sun Oct 18 12:10:31 2026
+ *
+ *       GNU recutils - Utilities shared by the unit tests
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REC_TORTURE_H
+#define REC_TORTURE_H
+
+#include <rec.h>
+
+/* Parse a record set from STR.  Return NULL if STR can't be parsed
+   or if there is not enough memory.  */
+
+rec_rset_t torture_parse_rset (const char *str);
+
+/* Parse a database from STR.  Return NULL if STR can't be parsed or
+   if there is not enough memory.  */
+
+rec_db_t torture_parse_db (const char *str);
+
+#endif /* !REC_TORTURE_H */
+
+/* End of rec-torture.h */
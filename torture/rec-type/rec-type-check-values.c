@@ -0,0 +1,223 @@
+/* -*- mode: C -*-
+ *
+ *       File:         rec-type-check-values.c
+ *       Date:         Sun Oct 18 12:10:31 2026
+ *
+ *       GNU recutils - rec_type_check unit tests comparing the
+ *                      built-in type checkers with their regexps
+ *
+ */
+
+/* Copyright (C) 2010-2015 Jose E. Marchesi */
+
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+#include <check.h>
+
+#include <rec.h>
+
+/* The values of some built-in types are checked by scanners instead
+   of regular expressions.  The following tests check every
+   combination of up to MAX_TOKENS tokens against both the type and
+   the regular expression the scanner replaces, which are copied
+   here.  */
+
+#define MAX_TOKENS 4
+
+#define INT_VALUE_RE                                            \
+  "^[ \t\n]*-?((0x[0-9a-fA-F]+)|[0-9]+)[ \t\n]*$"
+#define BOOL_VALUE_RE                                           \
+  "^[ \t\n]*(1|yes|true|0|no|false)[ \t\n]*$"
+#define REAL_VALUE_RE                                           \
+  "^[ \t\n]*-?([0-9]+)?(\\.[0-9]+)?[ \t\n]*$"
+#define LINE_VALUE_RE                                           \
+  "^[^\n]*$"
+#define EMAIL_VALUE_RE                                          \
+  "^[ \n\t]*[a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\\.[a-zA-Z]{2,4}[ \n\t]*$"
+
+static bool
+check_values (const char *type_descr,
+              const char *re,
+              const char **tokens,
+              size_t num_tokens)
+{
+  /* Iterate on all the strings made of up to MAX_TOKENS tokens,
+     using a counter in base NUM_TOKENS + 1 where the digit 0 means
+     no token.  */
+
+  rec_type_t type;
+  regex_t regexp;
+  size_t counter[MAX_TOKENS] = { 0 };
+  char str[256];
+  size_t i;
+  bool ret = true;
+
+  type = rec_type_new (type_descr);
+  if (!type)
+    {
+      return false;
+    }
+
+  if (regcomp (&regexp, re, REG_EXTENDED) != 0)
+    {
+      rec_type_destroy (type);
+      return false;
+    }
+
+  while (ret)
+    {
+      str[0] = '\0';
+      for (i = 0; i < MAX_TOKENS; i++)
+        {
+          if (counter[i] > 0)
+            {
+              strcat (str, tokens[counter[i] - 1]);
+            }
+        }
+
+      if (rec_type_check (type, str, NULL)
+          != (regexec (&regexp, str, 0, NULL, 0) == 0))
+        {
+          ret = false;
+        }
+
+      /* Next combination.  */
+      for (i = 0; i < MAX_TOKENS; i++)
+        {
+          if (++counter[i] <= num_tokens)
+            {
+              break;
+            }
+          counter[i] = 0;
+        }
+
+      if (i == MAX_TOKENS)
+        {
+          break;
+        }
+    }
+
+  regfree (&regexp);
+  rec_type_destroy (type);
+
+  return ret;
+}
+
+/*-
+ * Test: rec_type_check_values_int
+ * Unit: rec_type_check
+ * Description:
+ * + Check that the int type accepts the same strings than
+ * + its regexp.
+ */
+START_TEST(rec_type_check_values_int)
+{
+  const char *tokens[] = { " ", "\n", "-", "0", "7", "x", "0x", "a", "F",
+                           "g", "X", "+", "." };
+
+  fail_if (!check_values ("int", INT_VALUE_RE,
+                          tokens, sizeof (tokens) / sizeof (tokens[0])));
+}
+END_TEST
+
+/*-
+ * Test: rec_type_check_values_bool
+ * Unit: rec_type_check
+ * Description:
+ * + Check that the bool type accepts the same strings than
+ * + its regexp.
+ */
+START_TEST(rec_type_check_values_bool)
+{
+  const char *tokens[] = { " ", "\t", "1", "0", "yes", "no", "true", "false",
+                           "tru", "y", "e", "s", "True" };
+
+  fail_if (!check_values ("bool", BOOL_VALUE_RE,
+                          tokens, sizeof (tokens) / sizeof (tokens[0])));
+}
+END_TEST
+
+/*-
+ * Test: rec_type_check_values_real
+ * Unit: rec_type_check
+ * Description:
+ * + Check that the real type accepts the same strings than
+ * + its regexp.
+ */
+START_TEST(rec_type_check_values_real)
+{
+  const char *tokens[] = { " ", "\n", "-", "0", "5", "12", ".", ".5", "a",
+                           "e", "+" };
+
+  fail_if (!check_values ("real", REAL_VALUE_RE,
+                          tokens, sizeof (tokens) / sizeof (tokens[0])));
+}
+END_TEST
+
+/*-
+ * Test: rec_type_check_values_line
+ * Unit: rec_type_check
+ * Description:
+ * + Check that the line type accepts the same strings than
+ * + its regexp.
+ */
+START_TEST(rec_type_check_values_line)
+{
+  const char *tokens[] = { " ", "\n", "\t", "a", "line" };
+
+  fail_if (!check_values ("line", LINE_VALUE_RE,
+                          tokens, sizeof (tokens) / sizeof (tokens[0])));
+}
+END_TEST
+
+/*-
+ * Test: rec_type_check_values_email
+ * Unit: rec_type_check
+ * Description:
+ * + Check that the email type accepts the same strings than
+ * + its regexp.
+ */
+START_TEST(rec_type_check_values_email)
+{
+  const char *tokens[] = { " ", "\n", "a", "Z9", ".", "-", "_%+", "@", "com",
+                           "c", "info", "museum", ".org", "x.y", "@gnu",
+                           "!" };
+
+  fail_if (!check_values ("email", EMAIL_VALUE_RE,
+                          tokens, sizeof (tokens) / sizeof (tokens[0])));
+}
+END_TEST
+
+/*
+ * Test case creation function.
+ */
+TCase *
+test_rec_type_check_values (void)
+{
+  TCase *tc = tcase_create ("rec_type_check_values");
+  tcase_add_test (tc, rec_type_check_values_int);
+  tcase_add_test (tc, rec_type_check_values_bool);
+  tcase_add_test (tc, rec_type_check_values_real);
+  tcase_add_test (tc, rec_type_check_values_line);
+  tcase_add_test (tc, rec_type_check_values_email);
+
+  return tc;
+}
+
+/* End of rec-type-check-values.c */
@@ -33,6 +33,7 @@ extern TCase *test_rec_type_kind (void);
 extern TCase *test_rec_type_kind_str (void);
 extern TCase *test_rec_type_equal_p (void);
 extern TCase *test_rec_type_check (void);
+extern TCase *test_rec_type_check_values (void);
 extern TCase *test_rec_type_name (void);
 extern TCase *test_rec_type_set_name (void);
 
@@ -49,6 +50,7 @@ tsuite_rec_type ()
   suite_add_tcase (s, test_rec_type_kind_str ());
   suite_add_tcase (s, test_rec_type_equal_p ());
   suite_add_tcase (s, test_rec_type_check ());
+  suite_add_tcase (s, test_rec_type_check_values ());
   suite_add_tcase (s, test_rec_type_name ());
   suite_add_tcase (s, test_rec_type_set_name ());
 
@@ -84,6 +84,101 @@ START_TEST(rec_write_db_nominal)
 }
 END_TEST
 
+/*-
+ * Test: rec_write_db_start_record
+ * Unit: rec_write_db
+ * Description:
+ * + Write a database starting at a given record.
+ */
+START_TEST(rec_write_db_start_record)
+{
+  rec_writer_t writer;
+  rec_parser_t parser;
+  rec_db_t db;
+  rec_rset_t rset;
+  rec_record_t record;
+  char *str;
+  size_t str_size;
+
+  parser = rec_parser_new_str ("a: 1\n\na: 2\n# comment\n\n%rec: foo\n\nb: 1\n",
+                               "dummy");
+  fail_if (parser == NULL);
+  fail_if (!rec_parse_db (parser, &db));
+  rec_parser_destroy (parser);
+
+  rset = rec_db_get_rset (db, 0);
+  record = (rec_record_t) rec_mset_get_at (rec_rset_mset (rset), MSET_RECORD, 1);
+  fail_if (record == NULL);
+
+  writer = rec_writer_new_str (&str, &str_size);
+  rec_writer_set_start_record (writer, record);
+  fail_if (!rec_write_db (writer, db));
+  rec_writer_destroy (writer);
+  fail_if (strcmp (str, "a: 2\n# comment\n\n%rec: foo\n\nb: 1\n") != 0);
+  free (str);
+
+  rset = rec_db_get_rset (db, 1);
+  writer = rec_writer_new_str (&str, &str_size);
+  rec_writer_set_start_record (writer, rec_rset_descriptor (rset));
+  fail_if (!rec_write_db (writer, db));
+  rec_writer_destroy (writer);
+  fail_if (strcmp (str, "%rec: foo\n\nb: 1\n") != 0);
+  free (str);
+
+  rec_db_destroy (db);
+}
+END_TEST
+
+/*-
+ * Test: rec_write_db_source
+ * Unit: rec_write_db
+ * Description:
+ * + Write a database copying the text of the unmodified records.
+ */
+START_TEST(rec_write_db_source)
+{
+  rec_writer_t writer;
+  rec_parser_t parser;
+  rec_db_t db;
+  rec_rset_t rset;
+  rec_record_t record;
+  rec_field_t field;
+  char *str;
+  size_t str_size;
+  const char *text =
+    "%rec:foo\n\na:1\nb:  x\n+y\n\na:2\n# comment\n\na:3\n\na:4";
+
+  parser = rec_parser_new_str (text, "dummy");
+  fail_if (parser == NULL);
+  fail_if (!rec_parse_db (parser, &db));
+  rec_parser_destroy (parser);
+
+  rset = rec_db_get_rset (db, 0);
+  record = (rec_record_t) rec_mset_get_at (rec_rset_mset (rset), MSET_RECORD, 1);
+  field = rec_record_get_field_by_name (record, "a", 0);
+  fail_if (!rec_field_set_value (field, "5"));
+  record = (rec_record_t) rec_mset_get_at (rec_rset_mset (rset), MSET_RECORD, 2);
+  rec_mset_append (rec_record_mset (record), MSET_FIELD,
+                   (void *) rec_field_new ("c", "3"), MSET_ANY);
+
+  writer = rec_writer_new_str (&str, &str_size);
+  rec_writer_set_source (writer, "dummy", text, strlen (text));
+  fail_if (!rec_write_db (writer, db));
+  rec_writer_destroy (writer);
+  fail_if (strcmp (str, "%rec:foo\n\na:1\nb:  x\n+y\n\na: 5\n# comment\n\na: 3\nc: 3\n\na:4\n") != 0);
+  free (str);
+
+  writer = rec_writer_new_str (&str, &str_size);
+  rec_writer_set_source (writer, "other", text, strlen (text));
+  fail_if (!rec_write_db (writer, db));
+  rec_writer_destroy (writer);
+  fail_if (strcmp (str, "%rec: foo\n\na: 1\nb:  x\n+ y\n\na: 5\n# comment\n\na: 3\nc: 3\n\na: 4\n") != 0);
+  free (str);
+
+  rec_db_destroy (db);
+}
+END_TEST
+
 /*
  * Test creation function
  */
@@ -92,6 +187,8 @@ test_rec_write_db (void)
 {
   TCase *tc = tcase_create ("rec_write_db");
   tcase_add_test (tc, rec_write_db_nominal);
+  tcase_add_test (tc, rec_write_db_start_record);
+  tcase_add_test (tc, rec_write_db_source);
 
   return tc;
 }
@@ -31,6 +31,54 @@
 
 #include <rec.h>
 
+/* Build a record with fields whose values are big enough to fill the
+   output buffer of file writers, which is 64KiB long, several times
+   and to cross its boundary at different positions.  The values
+   contain newlines, quotes and backslashes.  */
+
+static rec_record_t
+new_big_record (void)
+{
+  rec_record_t record;
+  rec_field_t field;
+  size_t sizes[] = { 10, 65530, 65536, 65537, 1, 200000, 131072 };
+  char *value;
+  size_t i, j;
+
+  record = rec_record_new ();
+  if (!record)
+    return NULL;
+
+  for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+      value = malloc (sizes[i] + 1);
+      if (!value)
+        return NULL;
+
+      for (j = 0; j < sizes[i]; j++)
+        {
+          if ((j % 71) == 70)
+            value[j] = '\n';
+          else if ((j % 1000) == 999)
+            value[j] = '"';
+          else if ((j % 1001) == 1000)
+            value[j] = '\\';
+          else
+            value[j] = 'a' + (j % 26);
+        }
+      value[sizes[i]] = '\0';
+
+      field = rec_field_new ("Big", value);
+      free (value);
+      if (!field
+          || !rec_mset_append (rec_record_mset (record), MSET_FIELD,
+                               (void *) field, MSET_ANY))
+        return NULL;
+    }
+
+  return record;
+}
+
 /*-
  * Test: rec_write_record_nominal
  * Unit: rec_write_record
@@ -220,6 +268,73 @@ START_TEST(rec_write_record_values_row)
 }
 END_TEST
 
+/*-
+ * Test: rec_write_record_file
+ * Unit: rec_write_record
+ * Description:
+ * + Write big records to a file, in several
+ * + modes, between text written directly to
+ * + the same stream.  The output shall be the
+ * + same than when writing to a string.
+ */
+START_TEST(rec_write_record_file)
+{
+  rec_writer_t writer;
+  rec_record_t record;
+  rec_writer_mode_t modes[] = { REC_WRITER_NORMAL, REC_WRITER_SEXP,
+                                REC_WRITER_VALUES };
+  FILE *out;
+  char *str;
+  size_t str_size;
+  char *file_str;
+  long file_size;
+  size_t i;
+
+  record = new_big_record ();
+  fail_if (record == NULL);
+
+  for (i = 0; i < sizeof (modes) / sizeof (modes[0]); i++)
+    {
+      writer = rec_writer_new_str (&str, &str_size);
+      fail_if (writer == NULL);
+      rec_writer_set_mode (writer, modes[i]);
+      fail_if (!rec_write_record (writer, record));
+      rec_writer_destroy (writer);
+
+      out = tmpfile ();
+      fail_if (out == NULL);
+      writer = rec_writer_new (out);
+      fail_if (writer == NULL);
+      rec_writer_set_mode (writer, modes[i]);
+      fputs ("<", out);
+      fail_if (!rec_write_record (writer, record));
+      fputs ("|", out);
+      fail_if (!rec_write_record (writer, record));
+      fputs (">", out);
+      rec_writer_destroy (writer);
+
+      file_size = ftell (out);
+      fail_if (file_size != (long) (2 * str_size + 3));
+      file_str = malloc (file_size);
+      fail_if (file_str == NULL);
+      rewind (out);
+      fail_if (fread (file_str, 1, file_size, out) != (size_t) file_size);
+      fclose (out);
+
+      fail_if (file_str[0] != '<');
+      fail_if (memcmp (file_str + 1, str, str_size) != 0);
+      fail_if (file_str[str_size + 1] != '|');
+      fail_if (memcmp (file_str + str_size + 2, str, str_size) != 0);
+      fail_if (file_str[file_size - 1] != '>');
+
+      free (file_str);
+      free (str);
+    }
+
+  rec_record_destroy (record);
+}
+END_TEST
+
 
 /*
  * Test creation function
@@ -233,6 +348,7 @@ test_rec_write_record (void)
   tcase_add_test (tc, rec_write_record_sexp);
   tcase_add_test (tc, rec_write_record_values);
   tcase_add_test (tc, rec_write_record_values_row);
+  tcase_add_test (tc, rec_write_record_file);
 
   return tc;
 }
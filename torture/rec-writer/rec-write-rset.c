@@ -80,6 +80,67 @@ START_TEST(rec_write_rset_nominal)
 }
 END_TEST
 
+/*-
+ * Test: rec_write_rset_jobs
+ * Unit: rec_write_rset
+ * Description:
+ * + Write a big record set formatting the records in several
+ * + threads.
+ */
+START_TEST(rec_write_rset_jobs)
+{
+  rec_writer_t writer;
+  rec_rset_t rset;
+  rec_record_t record;
+  rec_field_t field;
+  char *str, *str_jobs;
+  size_t str_size, i;
+  char value[32];
+  int mode;
+
+  rset = rec_rset_new ();
+  fail_if (rset == NULL);
+
+  for (i = 0; i < 2000; i++)
+    {
+      if (i % 7 == 0)
+        {
+          fail_if (rec_mset_append (rec_rset_mset (rset), MSET_COMMENT,
+                                    (void *) rec_comment_new ("comment"),
+                                    MSET_ANY) == NULL);
+        }
+
+      record = rec_record_new ();
+      fail_if (record == NULL);
+      sprintf (value, "%zu\nline", i);
+      field = rec_field_new ("foo", value);
+      fail_if (field == NULL);
+      fail_if (rec_mset_append (rec_record_mset (record), MSET_FIELD, (void *) field, MSET_ANY) == NULL);
+      fail_if (rec_mset_append (rec_rset_mset (rset), MSET_RECORD, (void *) record, MSET_ANY) == NULL);
+    }
+
+  for (mode = REC_WRITER_NORMAL; mode <= REC_WRITER_SEXP; mode++)
+    {
+      writer = rec_writer_new_str (&str, &str_size);
+      rec_writer_set_mode (writer, mode);
+      fail_if (!rec_write_rset (writer, rset));
+      rec_writer_destroy (writer);
+
+      writer = rec_writer_new_str (&str_jobs, &str_size);
+      rec_writer_set_mode (writer, mode);
+      rec_writer_set_jobs (writer, 4);
+      fail_if (!rec_write_rset (writer, rset));
+      rec_writer_destroy (writer);
+
+      fail_if (strcmp (str, str_jobs) != 0);
+      free (str);
+      free (str_jobs);
+    }
+
+  rec_rset_destroy (rset);
+}
+END_TEST
+
 /*
  * Test creation function
  */
@@ -88,6 +149,7 @@ test_rec_write_rset (void)
 {
   TCase *tc = tcase_create ("rec_write_rset");
   tcase_add_test (tc, rec_write_rset_nominal);
+  tcase_add_test (tc, rec_write_rset_jobs);
 
   return tc;
 }
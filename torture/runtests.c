@@ -39,6 +39,9 @@ extern Suite *tsuite_rec_fex (void);
 extern Suite *tsuite_rec_parser (void);
 extern Suite *tsuite_rec_writer (void);
 extern Suite *tsuite_rec_sex (void);
+extern Suite *tsuite_rec_aggregate (void);
+extern Suite *tsuite_rec_db (void);
+extern Suite *tsuite_rec_rset (void);
 
 int
 main (int argc, char **argv)
@@ -59,6 +62,9 @@ main (int argc, char **argv)
   srunner_add_suite (sr, tsuite_rec_parser ());
   srunner_add_suite (sr, tsuite_rec_writer ());
   srunner_add_suite (sr, tsuite_rec_sex ());
+  srunner_add_suite (sr, tsuite_rec_aggregate ());
+  srunner_add_suite (sr, tsuite_rec_db ());
+  srunner_add_suite (sr, tsuite_rec_rset ());
 
   srunner_set_log (sr, "tests.log");
 
@@ -57,6 +57,49 @@ bar",baz
 x,y
 '
 
+test_declare_input_file typed-table \
+'Id,Name,Price,Available,Email
+1,foo,10,yes,foo@example.com
+2,bar,2.5,no,bar@example.com
+5,baz,,yes,baz@example.com
+'
+
+test_declare_input_file extra-fields \
+'Id,Name
+1,foo
+2,bar,baz
+'
+
+# A table bigger than the chunks in which csv2rec reads its input,
+# with multi-line values crossing the chunk boundaries.
+
+filler='abcdefghi,'
+for i in 1 2 3 4 5 6 7
+do
+    filler="${filler}${filler}"
+done
+
+big_table='Id,Text
+'
+big_records=''
+recno=0
+while test "$recno" -lt 120
+do
+    big_table="${big_table}${recno},\"${filler}
+${recno}\"
+"
+    if test "$recno" -gt 0; then
+        big_records="${big_records}
+"
+    fi
+    big_records="${big_records}Id: ${recno}
+Text: ${filler}
++ ${recno}
+"
+    recno=`expr $recno + 1`
+done
+test_declare_input_file big-table "$big_table"
+
 #
 # Declare tests.
 #
@@ -138,6 +181,112 @@ a: x
 b: y
 '
 
+test_tool csv2rec-infer-types ok \
+          csv2rec \
+          '--infer-types -t Item' \
+          typed-table \
+'%rec: Item
+%key: Id
+%type: Id int
+%type: Available bool
+%type: Email email
+
+Id: 1
+Name: foo
+Price: 10
+Available: yes
+Email: foo@example.com
+
+Id: 2
+Name: bar
+Price: 2.5
+Available: no
+Email: bar@example.com
+
+Id: 5
+Name: baz
+Price:
+Available: yes
+Email: baz@example.com
+'
+
+test_tool csv2rec-infer-types-omit ok \
+          csv2rec \
+          '--infer-types -e -t Item' \
+          typed-table \
+'%rec: Item
+%key: Id
+%type: Id int
+%type: Price real
+%type: Available bool
+%type: Email email
+
+Id: 1
+Name: foo
+Price: 10
+Available: yes
+Email: foo@example.com
+
+Id: 2
+Name: bar
+Price: 2.5
+Available: no
+Email: bar@example.com
+
+Id: 5
+Name: baz
+Available: yes
+Email: baz@example.com
+'
+
+test_tool csv2rec-infer-types-no-type xfail \
+          csv2rec \
+          '--infer-types' \
+          typed-table
+
+test_tool csv2rec-extra-fields xfail \
+          csv2rec \
+          '' \
+          extra-fields
+
+test_tool csv2rec-infer-types-extra-fields xfail \
+          csv2rec \
+          '--infer-types -t Item' \
+          extra-fields
+
+test_tool csv2rec-type ok \
+          csv2rec \
+          '-t Item' \
+          simple-table \
+'%rec: Item
+
+a: a1
+b: b1
+c: c1
+
+a: a2
+b: b2
+c: c2
+
+a: a3
+b: b3
+c: c3
+'
+
+test_tool csv2rec-big-table ok \
+          csv2rec \
+          '' \
+          big-table \
+"$big_records"
+
+test_tool csv2rec-big-table-type ok \
+          csv2rec \
+          '-t Item' \
+          big-table \
+"%rec: Item
+
+$big_records"
+
 #
 # Cleanup
 #
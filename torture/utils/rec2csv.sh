@@ -123,6 +123,22 @@ foo: c
 bar: 0
 '
 
+test_declare_input_file declared-fields \
+'a: a_none
+
+%rec: foo
+%type: c int
+%mandatory: b
+%allowed: a b
+
+a: a1
+b: b1
+c: 1
+
+b: b2
+d: d2
+'
+
 #
 # Declare tests.
 #
@@ -236,6 +252,60 @@ test_tool rec2csv-sort-field ok \
 "b","100"
 '
 
+test_tool rec2csv-print ok \
+          rec2csv \
+          '-p c,a' \
+          sort \
+'"c","a"
+,
+,
+,
+'
+
+test_tool rec2csv-print-subscripts ok \
+          rec2csv \
+          '-p a[1],b,a' \
+          repeated-missing \
+'"a_2","b","a"
+"a12",,"a11"
+,"b2","a21"
+'
+
+test_tool rec2csv-print-with-type ok \
+          rec2csv \
+          '-t bar -p b' \
+          several-types \
+'"b"
+"b_bar"
+'
+
+test_tool rec2csv-print-sort ok \
+          rec2csv \
+          '-S bar -p bar' \
+          sort \
+'"bar"
+"0"
+"50"
+"100"
+'
+
+test_tool rec2csv-descriptor-fields ok \
+          rec2csv \
+          '-t foo --descriptor-fields' \
+          declared-fields \
+'"c","b","a"
+"1","b1","a1"
+,"b2",
+'
+
+test_tool rec2csv-descriptor-fields-none ok \
+          rec2csv \
+          '--descriptor-fields' \
+          declared-fields \
+'"a"
+"a_none"
+'
+
 #
 # Cleanup
 #
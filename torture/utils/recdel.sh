@@ -85,6 +85,18 @@ Id: foo
 Id: bar
 '
 
+test_declare_input_file journal \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+'
+
+test_tmpfiles="$test_tmpfiles recdel-journal.in.journal"
+
 #
 # Declare tests.
 #
@@ -285,6 +297,21 @@ test_tool recdel-random-all-force ok \
           multiple-records \
 ''
 
+test_tool recdel-journal ok \
+          recdel \
+          '--journal -t Item -e "Id = 1" recdel-journal.in && (cat recdel-journal.in; recsel$EXEEXT recdel-journal.in)' \
+          journal \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+Id: 2
+Name: b
+'
+
 #
 # Cleanup
 #
@@ -285,6 +285,26 @@ bar: KEY2
 bar: KEY3
 '
 
+test_declare_input_file enum-many-valid \
+'%rec: foo
+%type: bar enum A B C D E F G H I J K L
+
+bar: A
+
+bar: G
+
+bar: L
+'
+
+test_declare_input_file enum-many-invalid \
+'%rec: foo
+%type: bar enum A B C D E F G H I J K L
+
+bar: A
+
+bar: M
+'
+
 test_declare_input_file type-size-valid \
 '%rec: foo
 %type: bar size 10
@@ -1002,6 +1022,22 @@ joo: encrypted-By/F2HBy1wiim1fUWMVKRg==
 fo: ja
 '
 
+# More records than fit in a chunk of records encrypted or decrypted
+# by a single thread.
+many_secrets='%rec: Account
+%confidential: Secret
+'
+recno=0
+while test "$recno" -lt 200
+do
+    many_secrets="${many_secrets}
+Id: $recno
+Secret: secret`expr $recno % 20`
+"
+    recno=`expr $recno + 1`
+done
+test_declare_input_file many-secrets "$many_secrets"
+
 test_declare_input_file encrypt-already-encrypted \
 '%rec: Account
 %confidential: Secret
@@ -1026,6 +1062,20 @@ Title: baz
 Title: bar
 '
 
+test_declare_input_file several-missing-auto-fields \
+'%rec: Item
+%auto: Id
+
+Title: foo
+
+Id: 10
+Title: baz
+
+Title: bar
+
+Title: qux
+'
+
 test_declare_input_file uuid-fields-ok \
 '%rec: Item
 %type: Id uuid
@@ -1379,6 +1429,18 @@ zzz: 40
 yyy: 30
 '
                         
+test_declare_input_file journal \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+'
+
+test_tmpfiles="$test_tmpfiles recfix-journal.in.journal"
+
 #
 # Declare tests.
 #
@@ -1536,6 +1598,17 @@ test_tool recfix-enum-invalid-2 xfail \
           '' \
           enum-invalid-2
 
+test_tool recfix-enum-many-valid ok \
+          recfix \
+          '' \
+          enum-many-valid \
+          ''
+
+test_tool recfix-enum-many-invalid xfail \
+          recfix \
+          '' \
+          enum-many-invalid
+
 test_tool recfix-type-size-valid ok \
           recfix \
           '' \
@@ -1942,6 +2015,53 @@ joo: encrypted-By/F2HBy1wiim1fUWMVKRg==
 fo: ja
 '
 
+test_tool recfix-decrypt-jobs ok \
+          recfix \
+          '--decrypt -s foo --jobs=2' \
+          decrypt \
+'%rec: Account
+%confidential: Secret
+
+Secret: foo
+
+Secret: bar
+
+%rec: Jorl
+
+Secret: jojo
+
+%rec: jojo
+%confidential: joo
+
+joo: je
+fo: fu
+
+joo: ji
+fo: ja
+'
+
+test_tool recfix-decrypt-jobs-invalid xfail \
+          recfix \
+          '--decrypt -s foo --jobs=x' \
+          decrypt
+
+test_declare_input_file many-secrets-encrypted \
+"`recfix$EXEEXT --encrypt -s foo --jobs=2 < recfix-many-secrets.in`
+"
+
+test_tool recfix-encrypt-jobs ok \
+          recsel \
+          '-c -e "Secret ~ '\''^encrypted-'\''"' \
+          many-secrets-encrypted \
+'200
+'
+
+test_tool recfix-encrypt-decrypt-jobs ok \
+          recfix \
+          '--decrypt -s foo --jobs=2' \
+          many-secrets-encrypted \
+"$many_secrets"
+
 fi # crypt_support
 
 test_tool recfix-sort-several-fields-invalid xfail \
@@ -2251,6 +2371,26 @@ Id: 2
 Title: bar
 '
 
+test_tool recfix-several-missing-auto-fields ok \
+          recfix \
+          "--auto" \
+          several-missing-auto-fields \
+'%rec: Item
+%auto: Id
+
+Id: 11
+Title: foo
+
+Id: 10
+Title: baz
+
+Id: 12
+Title: bar
+
+Id: 13
+Title: qux
+'
+
 if test "$uuid_support" = "yes"; then
 
 test_tool recfix-uuid-ok ok \
@@ -2409,6 +2549,21 @@ test_tool recfix-allowed-xfail-3 xfail \
           '--check' \
           allowed-xfail-3
         
+# --compact applies the journal of the file and removes it.
+
+test_tool recfix-compact ok \
+          recfix \
+          '--check recfix-journal.in && recins$EXEEXT --journal -t Item -f Id -v 3 -f Name -v c recfix-journal.in && recdel$EXEEXT --journal -t Item -n 0 recfix-journal.in && recfix$EXEEXT --compact recfix-journal.in && test ! -f recfix-journal.in.journal && cat recfix-journal.in' \
+          journal \
+'%rec: Item
+
+Id: 2
+Name: b
+
+Id: 3
+Name: c
+'
+
 #
 # Cleanup.
 #
@@ -163,6 +163,110 @@ Name: Bertram
 Class: B
 '
 
+test_declare_input_file locked \
+'%rec: Item
+
+Name: foo
+'
+
+test_declare_input_file append-last \
+'%rec: Item
+
+Id: 1
+
+
+
+Id: 2
+'
+
+test_declare_input_file append-last-no-newline \
+'%rec: Item
+
+Id: 1
+
+
+
+Id: 2'
+
+test_declare_input_file append-last-comment \
+'%rec: Item
+
+Id: 1
+
+
+
+Id: 2
+
+# Trailing comment.
+'
+
+test_declare_input_file append-not-last \
+'%rec: Item
+
+Id: 1
+
+
+
+Id: 2
+
+%rec: Other
+
+Name: foo
+'
+
+test_declare_input_file append-last-key \
+'%rec: Item
+%key: Id
+
+Id: 1
+
+
+
+Id: 2
+'
+
+test_declare_input_file journal \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+'
+
+test_declare_input_file journal-replay \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+'
+
+test_declare_input_file journal-rewrite \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+'
+
+test_declare_input_file journal-stale \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+'
+
+test_tmpfiles="$test_tmpfiles recins-journal.in.journal recins-journal-replay.in.journal recins-journal-rewrite.in.journal recins-journal-stale.in.journal"
+
 #
 # Declare tests.
 #
@@ -529,7 +633,205 @@ Class: A
 Name: Bertram
 Class: B
 '
+
+test_tool recins-lock-timeout-empty xfail \
+          recins \
+          '--lock-timeout= -f Name -v bar' \
+          one-record
+
+test_tool recins-lock-timeout-overflow xfail \
+          recins \
+          '--lock-timeout=4294967296 -f Name -v bar' \
+          one-record
+
+# Records added to the last record set of a file are appended to it
+# without rewriting the rest of the file, which is kept untouched.
+
+test_tool recins-append-last ok \
+          recins \
+          '-t Item -f Id -v 3 recins-append-last.in && cat recins-append-last.in' \
+          append-last \
+'%rec: Item
+
+Id: 1
+
+
+
+Id: 2
+
+Id: 3
+'
+
+test_tool recins-append-last-no-newline ok \
+          recins \
+          '-t Item -f Id -v 3 recins-append-last-no-newline.in && cat recins-append-last-no-newline.in' \
+          append-last-no-newline \
+'%rec: Item
+
+Id: 1
+
+
+
+Id: 2
+
+Id: 3
+'
+
+test_tool recins-append-last-key ok \
+          recins \
+          '-t Item -f Id -v 2 recins-append-last-key.in 2> /dev/null || cat recins-append-last-key.in' \
+          append-last-key \
+'%rec: Item
+%key: Id
+
+Id: 1
+
+
+
+Id: 2
+'
+
+# Otherwise the whole file is written again.
+
+test_tool recins-append-last-comment ok \
+          recins \
+          '-t Item -f Id -v 3 recins-append-last-comment.in && cat recins-append-last-comment.in' \
+          append-last-comment \
+'%rec: Item
+
+Id: 1
+
+Id: 2
+
+Id: 3
+
+# Trailing comment.
+'
+
+test_tool recins-append-not-last ok \
+          recins \
+          '-t Item -f Id -v 3 recins-append-not-last.in && cat recins-append-not-last.in' \
+          append-not-last \
+'%rec: Item
+
+Id: 1
+
+Id: 2
+
+Id: 3
+
+%rec: Other
+
+Name: foo
+'
+
+if flock --version > /dev/null 2>&1; then
+
+    # Hold an exclusive lock on the file from another process until
+    # the test is done.  The holder creates a marker file once it has
+    # the lock, and releases it when the test creates another one.
+    test_tmpfiles="$test_tmpfiles recins-locked.held recins-locked.release"
+    rm -f recins-locked.held recins-locked.release
+    flock -x recins-locked.in \
+          sh -c 'touch recins-locked.held; while test ! -f recins-locked.release; do sleep 1; done' &
+    lock_pid=$!
+    while test ! -f recins-locked.held
+    do
+        sleep 1
+    done
+
+    test_tool recins-lock-timeout-expired xfail \
+              recins \
+              '--lock-timeout=1 -t Item -f Name -v bar recins-locked.in' \
+              locked
+
+    touch recins-locked.release
+    wait $lock_pid
+
+    test_tool recins-lock-timeout ok \
+              recins \
+              '--lock-timeout=1 -t Item -f Name -v bar recins-locked.in' \
+              locked \
+''
+
+fi # flock
  
+# With --journal the file is left untouched and the operation is
+# appended to its journal, which is applied when reading the file.
+
+test_tool recins-journal ok \
+          recins \
+          '--journal -t Item -f Id -v 3 -f Name -v c recins-journal.in && (cat recins-journal.in; recsel$EXEEXT -q insert -P Operation,Type,Record recins-journal.in.journal)' \
+          journal \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+insert
+Item
+Id: 3
+Name: c
+'
+
+test_tool recins-journal-replay ok \
+          recins \
+          '--journal -t Item -f Id -v 3 -f Name -v c recins-journal-replay.in && recins$EXEEXT --journal -t Item -f Id -v 4 -f Name -v d recins-journal-replay.in && recsel$EXEEXT recins-journal-replay.in' \
+          journal-replay \
+'Id: 1
+Name: a
+
+Id: 2
+Name: b
+
+Id: 3
+Name: c
+
+Id: 4
+Name: d
+'
+
+# Writing the file without --journal folds the journal in and removes
+# it.
+
+test_tool recins-journal-rewrite ok \
+          recins \
+          '--journal -t Item -f Id -v 3 -f Name -v c recins-journal-rewrite.in && recins$EXEEXT -t Item -f Id -v 4 -f Name -v d recins-journal-rewrite.in && test ! -f recins-journal-rewrite.in.journal && cat recins-journal-rewrite.in' \
+          journal-rewrite \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+
+Id: 3
+Name: c
+
+Id: 4
+Name: d
+'
+
+# A journal whose stamp doesn't match the file, because the file was
+# modified by other means, is ignored.
+
+test_tool recins-journal-stale ok \
+          recins \
+          '--journal -t Item -f Id -v 3 -f Name -v c recins-journal-stale.in && printf "\\nId: 4\\nName: d\\n" >> recins-journal-stale.in && recsel$EXEEXT recins-journal-stale.in' \
+          journal-stale \
+'Id: 1
+Name: a
+
+Id: 2
+Name: b
+
+Id: 4
+Name: d
+'
+
 #
 # Cleanup.
 #
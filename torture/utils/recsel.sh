@@ -39,6 +39,26 @@ field2: value2
 field3: value3
 '
 
+test_declare_input_file split-values \
+'Id: 1
+Name: foo
+Note: first
++ foo line
+
+Id: 2
+Name: fo\
+o
+
+Id: 3
+Name: bar
+Note: a\
+
+Name: foo
+
+Id: 4
+Name: baz
+'
+
 test_declare_input_file multiple-records \
 'field1: value11
 field2: value12
@@ -171,6 +191,24 @@ User: foo
 Password: encrypted-MHyd3Dqz+iaViL8h1m18sA==
 '
 
+test_declare_input_file confidential-several \
+'%rec: Account
+%confidential: Password Pin
+%confidential: Answer
+
+User: foo
+Password: encrypted-p18OXgfeUo17Sr7W7A747ZfiYvk=
+Pin: encrypted-E20lfOouwS8upyuQrXw4S1XUWoQ=
+Answer: encrypted-9kTqjwT19RrMekLekGmy7In3SQw=
+Note: not secret
+
+User: baz
+Password: encrypted-li+/8+6GaFlsMtUH+sb+wYUg/Xo=
+Pin: encrypted-HPyth8RPI91rF7PVxaJajlXj0Go=
+Pin: encrypted-56llUYywnqbgUVyUjC/Sm2M17S8=
+Note: encrypted-li+/8+6GaFlsMtUH+sb+wYUg/Xo=
+'
+
 test_declare_input_file sort \
 '%rec: Sorted
 %sort: Id
@@ -289,6 +327,20 @@ id: 3
 pos: 5
 '
 
+test_declare_input_file group-duplicated \
+'key: a
+tag: x
+tag: y
+
+key: a
+tag: y
+tag: z
+tag: x
+
+key: b
+tag: x
+'
+
 test_declare_input_file sales \
 'Item: A
 Date: 21 April 2012
@@ -435,6 +487,22 @@ foo: 9
 bar: -9
 '
 
+# More records than fit in two of the chunks processed in parallel
+# by --jobs.
+many_records=''
+recno=0
+while test "$recno" -lt 300
+do
+    tagno=`expr $recno % 2`
+    many_records="${many_records}Id: $recno
+Tag: t$tagno
+Tag: t$tagno
+
+"
+    recno=`expr $recno + 1`
+done
+test_declare_input_file many-records "$many_records"
+
 #
 # Declare tests
 #
@@ -1175,6 +1243,52 @@ test_tool recsel-quick-not-found ok \
           multiple-records \
 ''
 
+test_tool recsel-quick-partial ok \
+          recsel \
+          "-q lue3" \
+          multiple-records \
+'field1: value31
+field2: value32
+field3: value33
+'
+
+test_tool recsel-quick-case-insensitive ok \
+          recsel \
+          "-i -q VaLuE22" \
+          multiple-records \
+'field1: value21
+field2: value22
+field3: value23
+'
+
+test_tool recsel-quick-case-sensitive ok \
+          recsel \
+          "-q VALUE22" \
+          multiple-records \
+''
+
+test_tool recsel-quick-split-values ok \
+          recsel \
+          "-q foo -P Id" \
+          split-values \
+'1
+
+2
+
+3
+'
+
+test_tool recsel-sex-literal-split-values ok \
+          recsel \
+          "-e \"Name = 'foo'\" -P Id" \
+          split-values \
+'1
+
+2
+
+3
+'
+
 test_tool recsel-quick-and-sex xfail \
           recsel \
           "-q foo -e 'Bar = 10'" \
@@ -1242,6 +1356,32 @@ test_tool recsel-confidential-num ok \
 Password: secret
 '
 
+test_tool recsel-confidential-several ok \
+          recsel \
+          '-s secret' \
+          confidential-several \
+'User: foo
+Password: secret
+Pin: 1234
+Answer: bar
+Note: not secret
+
+User: baz
+Password: 4321
+Pin: 1234
+Pin: 4321
+Note: encrypted-li+/8+6GaFlsMtUH+sb+wYUg/Xo=
+'
+
+test_tool recsel-confidential-several-jobs ok \
+          recsel \
+          '-s secret --jobs=2 -e "User = '\''baz'\''" -p Pin,Note' \
+          confidential-several \
+'Pin: 1234
+Pin: 4321
+Note: encrypted-li+/8+6GaFlsMtUH+sb+wYUg/Xo=
+'
+
 fi # crypt_support
 
 test_tool recsel-sort ok \
@@ -1395,6 +1535,46 @@ field3: value33
 field1: foo
 '
 
+test_tool recsel-jobs ok \
+          recsel \
+          '--jobs=2 -e "field1 != 314"' \
+          integer-fields \
+'field1: 10
+
+field1: -10
+
+field1: 0
+'
+
+test_tool recsel-jobs-invalid xfail \
+          recsel \
+          '--jobs=foo' \
+          integer-fields
+
+# The following tests check that using several threads produces the
+# same results, in the same order, than using just one.
+
+test_tool recsel-jobs-many ok \
+          recsel \
+          '--jobs=2 -e "Id % 3 = 0" -p Id' \
+          many-records \
+"`recsel$EXEEXT --jobs=1 -e 'Id % 3 = 0' -p Id < recsel-many-records.in`
+"
+
+test_tool recsel-jobs-many-index ok \
+          recsel \
+          '--jobs=2 -n 5,127-129,255-257,299' \
+          many-records \
+"`recsel$EXEEXT --jobs=1 -n 5,127-129,255-257,299 < recsel-many-records.in`
+"
+
+test_tool recsel-jobs-many-uniq ok \
+          recsel \
+          '--jobs=3 -U' \
+          many-records \
+"`recsel$EXEEXT --jobs=1 -U < recsel-many-records.in`
+"
+
 test_tool recsel-random-all ok \
           recsel \
           '-m 0' \
@@ -1421,6 +1601,27 @@ field2: value2
 field3: value3
 '
 
+test_tool recsel-random-count ok \
+          recsel \
+          '-m 150 -c' \
+          many-records \
+'150
+'
+
+test_tool recsel-random-count-jobs ok \
+          recsel \
+          '--jobs=2 -m 150 -c' \
+          many-records \
+'150
+'
+
+test_tool recsel-random-more ok \
+          recsel \
+          '-m 1000 -p Id' \
+          many-records \
+"`recsel$EXEEXT -p Id < recsel-many-records.in`
+"
+
 test_tool recsel-group-records ok \
           recsel \
           '-G id' \
@@ -1437,6 +1638,19 @@ pos: 1
 pos: 5
 '
 
+test_tool recsel-group-uniq ok \
+          recsel \
+          '-G key -U' \
+          group-duplicated \
+'key: a
+tag: x
+tag: y
+tag: z
+
+key: b
+tag: x
+'
+
 test_tool recsel-group-records-sort ok \
           recsel \
           '-G pos' \
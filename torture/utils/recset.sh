@@ -98,6 +98,84 @@ field2: value32
 field3: value33
 '
 
+test_declare_input_file invalid-record \
+'%rec: Invalid
+%key: Id
+%type: Id int
+
+Id: foo
+
+Id: 2
+'
+
+test_declare_input_file batch-operations \
+'Operation: set
+Index: 0
+Fields: field2
+Action: set
+Value: XXX
+
+Operation: delete
+Expression: field1 = "value21"
+
+Operation: insert
+Record: field1: value41
++ field2: value42
+'
+
+test_declare_input_file auto-records \
+'%rec: Item
+%key: Id
+%type: Id int
+%auto: Id
+
+Id: 1
+Name: foo
+
+Id: 2
+Name: bar
+'
+
+test_declare_input_file batch-auto-operations \
+'Operation: insert
+Type: Item
+Record: Name: baz
+
+Operation: set
+Type: Item
+Expression: Id = 3
+Fields: Id
+Action: set
+Value: 4
+
+Operation: insert
+Type: Item
+Record: Name: qux
+
+Operation: set
+Type: Item
+Expression: Id = 5
+Fields: Id
+Action: set
+Value: 10
+
+Operation: insert
+Type: Item
+Record: Name: quux
+'
+
+test_declare_input_file journal \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+'
+
+test_tmpfiles="$test_tmpfiles recset-journal.in.journal"
+
 #
 # Declare tests.
 #
@@ -480,7 +558,86 @@ test_tool recset-random-one ok \
 field2: XXX
 field3: value3
 '
+
+test_tool recset-check-modified-only ok \
+          recset \
+          '-t Invalid -n 1 -f Name -a bar' \
+          invalid-record \
+'%rec: Invalid
+%key: Id
+%type: Id int
+
+Id: foo
+
+Id: 2
+Name: bar
+'
+
+test_tool recset-check-modified-duplicated-key xfail \
+          recset \
+          '-t Invalid -n 1 -f Id -s foo' \
+          invalid-record
+
+test_tool recset-batch ok \
+          recset \
+          '--batch=recset-batch-operations.in' \
+          multiple-records \
+'field1: value11
+field2: XXX
+field3: value13
+
+field1: value31
+field2: value32
+field3: value33
+
+field1: value41
+field2: value42
+'
  
+test_tool recset-batch-auto ok \
+          recset \
+          '--batch=recset-batch-auto-operations.in' \
+          auto-records \
+'%rec: Item
+%key: Id
+%type: Id int
+%auto: Id
+
+Id: 1
+Name: foo
+
+Id: 2
+Name: bar
+
+Id: 4
+Name: baz
+
+Id: 10
+Name: qux
+
+Id: 11
+Name: quux
+'
+
+test_tool recset-journal ok \
+          recset \
+          '--journal -t Item -e "Id = 1" -f Name -s z recset-journal.in && recset$EXEEXT --journal -t Item -n 1 -f Extra -a x recset-journal.in && (cat recset-journal.in; recsel$EXEEXT recset-journal.in)' \
+          journal \
+'%rec: Item
+
+Id: 1
+Name: a
+
+Id: 2
+Name: b
+Id: 1
+Name: z
+
+Id: 2
+Name: b
+Extra: x
+'
+
 #
 # Cleanup.
 #
@@ -28,6 +28,7 @@
 #include <getopt.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <xalloc.h>
 #include <gettext.h>
 #define _(str) gettext (str)
@@ -37,21 +38,28 @@
 #include <recutl.h>
 
 /* Forward declarations.  */
+struct csv2rec_ctx;
 static void parse_args (int argc, char **argv);
-static rec_db_t process_csv (void);
+static bool process_csv (void);
 static int is_space (unsigned char c);
 static int is_term (unsigned char c);
 static void field_cb (void *s, size_t len, void *data);
 static void record_cb (int c, void *data);
+static void infer_value (struct csv2rec_ctx *ctx, const char *str);
+static rec_record_t build_descriptor (struct csv2rec_ctx *ctx);
 
 /*
  * Types
  */
 
+/* Size of the chunks in which the csv data is read.  */
+
+#define CSV2REC_BUF_SIZE 65536
+
 struct csv2rec_ctx
 {
-  rec_db_t db;
-  rec_rset_t rset;
+  rec_writer_t writer;
+  size_t num_records;
   rec_record_t record;
 
   size_t num_fields;
@@ -61,8 +69,29 @@ struct csv2rec_ctx
   bool header_p;
   size_t num_field_names;
   char **field_names;
+
+  /* Type inference.  If infer_p is set the values are only used to
+     narrow the types that the values of each column may have, which
+     are kept as masks of bits indexing csv2rec_types.  The first
+     column can be a key if its values are strictly increasing
+     integers.  */
+
+  bool infer_p;
+  unsigned int *column_types;
+  size_t *column_values;
+  bool key_p;
+  long long key_last;
 };
 
+/* Candidate types for the columns, in order of preference.  */
+
+static const char *csv2rec_type_names[] =
+  { "int", "real", "bool", "date", "uuid", "email" };
+
+#define NUM_TYPES (sizeof (csv2rec_type_names) / sizeof (char *))
+
+static rec_type_t csv2rec_types[NUM_TYPES];
+
 /*
  * Global variables
  */
@@ -71,6 +100,7 @@ char *csv2rec_record_type = NULL;
 char *csv2rec_csv_file = NULL;
 bool csv2rec_strict = false;
 bool csv2rec_omit_empty = false;
+bool csv2rec_infer_types = false;
 
 /*
  * Command line options management
@@ -81,7 +111,8 @@ enum
     COMMON_ARGS,
     RECORD_TYPE_ARG,
     STRICT_ARG,
-    OMIT_EMPTY_ARG
+    OMIT_EMPTY_ARG,
+    INFER_TYPES_ARG
   };
 
 static const struct option GNU_longOptions[] =
@@ -90,6 +121,7 @@ static const struct option GNU_longOptions[] =
     {"type", required_argument, NULL, RECORD_TYPE_ARG},
     {"strict", no_argument, NULL, STRICT_ARG},
     {"omit-empty", no_argument, NULL, OMIT_EMPTY_ARG},
+    {"infer-types", no_argument, NULL, INFER_TYPES_ARG},
     {NULL, 0, NULL, 0}
   };
 
@@ -117,7 +149,10 @@ Convert csv data into rec data.\n"), stdout);
   -t, --type=TYPE                     type name for the converted records; if this\n\
                                         parameter is ommited then no type is used.\n\
   -s, --strict                        be strict parsing the csv file.\n\
-  -e, --omit-empty                    omit empty fields.\n"), stdout);
+  -e, --omit-empty                    omit empty fields.\n\
+      --infer-types                   determine the types of the fields from their\n\
+                                        values and declare them in the record\n\
+                                        descriptor.  Requires --type.\n"), stdout);
 
   recutl_print_help_common ();
   puts ("");
@@ -159,6 +194,11 @@ parse_args (int argc,
             csv2rec_omit_empty = true;
             break;
           }
+        case INFER_TYPES_ARG:
+          {
+            csv2rec_infer_types = true;
+            break;
+          }
         default:
           {
             exit (EXIT_FAILURE);
@@ -177,6 +217,13 @@ parse_args (int argc,
 
       csv2rec_csv_file = argv[optind++];
     }
+
+  /* Types are declared in a record descriptor, which needs a
+     type name.  */
+  if (csv2rec_infer_types && !csv2rec_record_type)
+    {
+      recutl_fatal (_("--infer-types requires --type\n"));
+    }
 }
 
 static int
@@ -246,7 +293,7 @@ field_cb (void *s, size_t len, void *data)
       
       if (!csv2rec_omit_empty || (strlen(str) > 0))
         {
-          if (ctx->num_fields > ctx->num_field_names)
+          if (ctx->num_fields >= ctx->num_field_names)
             {
               char *source = csv2rec_csv_file;
 
@@ -258,14 +305,23 @@ field_cb (void *s, size_t len, void *data)
               fprintf (stderr,
                        _("%s: %lu: this line contains %lu fields, but %lu header fields were read\n"),
                        source,
-                       ctx->lineno, ctx->num_field_names, ctx->num_fields);
+                       ctx->lineno, ctx->num_fields + 1, ctx->num_field_names);
               exit (EXIT_FAILURE);
             }
-          field = rec_field_new (ctx->field_names[ctx->num_fields], str);
-          rec_mset_append (rec_record_mset (ctx->record), MSET_FIELD, (void *) field, MSET_ANY);
+
+          if (ctx->infer_p)
+            {
+              infer_value (ctx, str);
+            }
+          else
+            {
+              field = rec_field_new (ctx->field_names[ctx->num_fields], str);
+              rec_mset_append (rec_record_mset (ctx->record), MSET_FIELD, (void *) field, MSET_ANY);
+            }
         }
 
       ctx->num_fields++;
+      free (str);
     }
 }
 
@@ -280,60 +336,265 @@ record_cb (int c, void *data)
   if (ctx->header_p)
     {
       ctx->header_p = false;
+
+      if (ctx->infer_p)
+        {
+          /* Any type is possible until some value is seen.  */
+          size_t i, j;
+
+          ctx->column_types = xmalloc (sizeof (unsigned int) * ctx->num_field_names);
+          ctx->column_values = xmalloc (sizeof (size_t) * ctx->num_field_names);
+          for (i = 0; i < ctx->num_field_names; i++)
+            {
+              ctx->column_types[i] = 0;
+              for (j = 0; j < NUM_TYPES; j++)
+                {
+                  if (csv2rec_types[j])
+                    {
+                      ctx->column_types[i] |= (1 << j);
+                    }
+                }
+              ctx->column_values[i] = 0;
+            }
+        }
+    }
+  else if (ctx->infer_p)
+    {
+      /* Just count the rows.  */
+      rec_record_destroy (ctx->record);
+      ctx->record = NULL;
+      ctx->num_records++;
+      ctx->num_fields = 0;
     }
   else
     {
-      if (!ctx->rset)
-        {
-          /* Create a new record set.  */
-          ctx->rset = rec_rset_new ();
-          if (!ctx->rset)
-            recutl_out_of_memory ();
+      /* Write the current record right away, so the memory used does
+         not depend on the size of the input.  The output is the same
+         as writing a record set containing all the records.  */
 
-          /* Add a type, if needed.  */
+      if (ctx->num_records == 0)
+        {
           if (csv2rec_record_type)
             {
-              rec_rset_set_type (ctx->rset, csv2rec_record_type);
-            }
-          
-          /* Add it to the database.  */
-          if (!ctx->db)
-            {
-              ctx->db = rec_db_new ();
-              if (!ctx->db)
-                recutl_out_of_memory ();
+              /* Write a record descriptor with the type.  */
+              rec_record_t descriptor = build_descriptor (ctx);
+
+              rec_write_record (ctx->writer, descriptor);
+              rec_write_string (ctx->writer, "\n\n");
+              rec_record_destroy (descriptor);
             }
-          rec_db_insert_rset (ctx->db, ctx->rset, rec_db_size (ctx->db));
         }
-      
-      /* Add the current record to the record set.  */
-      rec_mset_append (rec_rset_mset (ctx->rset), MSET_RECORD, (void *) ctx->record, MSET_ANY);
-      ctx->record = NULL;
+      else
+        {
+          rec_write_string (ctx->writer, "\n");
+        }
+
+      if (ctx->record)
+        {
+          rec_write_record (ctx->writer, ctx->record);
+          rec_record_destroy (ctx->record);
+          ctx->record = NULL;
+        }
+      rec_write_string (ctx->writer, "\n");
+      ctx->num_records++;
       
       /* Reset the field counter.  */
       ctx->num_fields = 0;
     }
 }
 
-static rec_db_t
-process_csv (void)
+static void
+infer_value (struct csv2rec_ctx *ctx,
+             const char *str)
+{
+  size_t column = ctx->num_fields;
+  size_t i;
+
+  ctx->column_values[column]++;
+
+  /* Discard the types the value does not conform to.  Empty values
+     are not typed.  */
+  if (*str == '\0')
+    {
+      ctx->column_types[column] = 0;
+    }
+
+  for (i = 0; i < NUM_TYPES; i++)
+    {
+      if ((ctx->column_types[column] & (1 << i))
+          && !rec_type_check (csv2rec_types[i], str, NULL))
+        {
+          ctx->column_types[column] &= ~(1 << i);
+        }
+    }
+
+  if ((column == 0) && ctx->key_p)
+    {
+      char *end;
+      long long value;
+
+      errno = 0;
+      value = strtoll (str, &end, 10);
+      if ((*str == '\0') || (*end != '\0') || (errno != 0)
+          || ((ctx->column_values[column] > 1) && (value <= ctx->key_last)))
+        {
+          ctx->key_p = false;
+        }
+
+      ctx->key_last = value;
+    }
+}
+
+static void
+add_descriptor_field (rec_record_t descriptor,
+                      enum rec_std_field_e std_field,
+                      const char *value)
+{
+  rec_field_t field;
+
+  field = rec_field_new (rec_std_field_name (std_field), value);
+  if (!field
+      || !rec_mset_append (rec_record_mset (descriptor), MSET_FIELD, (void *) field, MSET_ANY))
+    {
+      recutl_out_of_memory ();
+    }
+}
+
+static rec_record_t
+build_descriptor (struct csv2rec_ctx *ctx)
+{
+  rec_record_t descriptor;
+  size_t i, j;
+
+  descriptor = rec_record_new ();
+  if (!descriptor)
+    {
+      recutl_out_of_memory ();
+    }
+
+  add_descriptor_field (descriptor, REC_FIELD_REC, csv2rec_record_type);
+
+  if (!ctx->column_types)
+    {
+      return descriptor;
+    }
+
+  if (ctx->key_p)
+    {
+      add_descriptor_field (descriptor, REC_FIELD_KEY, ctx->field_names[0]);
+    }
+
+  for (i = 0; i < ctx->num_field_names; i++)
+    {
+      unsigned int types = ctx->column_types[i];
+      size_t num_values = ctx->column_values[i];
+      bool seen_p = false;
+      char *type_str;
+
+      /* Columns with the same name are the same field.  */
+      for (j = 0; j < ctx->num_field_names; j++)
+        {
+          if (rec_field_name_equal_p (ctx->field_names[i], ctx->field_names[j]))
+            {
+              seen_p = seen_p || (j < i);
+              types &= ctx->column_types[j];
+              num_values += ctx->column_values[j];
+            }
+        }
+
+      if (seen_p || (num_values == 0))
+        {
+          continue;
+        }
+
+      for (j = 0; j < NUM_TYPES; j++)
+        {
+          if (types & (1 << j))
+            {
+              type_str = xmalloc (strlen (ctx->field_names[i])
+                                  + strlen (csv2rec_type_names[j]) + 2);
+              sprintf (type_str, "%s %s",
+                       ctx->field_names[i], csv2rec_type_names[j]);
+              add_descriptor_field (descriptor, REC_FIELD_TYPE, type_str);
+              free (type_str);
+              break;
+            }
+        }
+    }
+
+  return descriptor;
+}
+
+static void
+parse_csv (struct csv2rec_ctx *ctx,
+           FILE *in,
+           FILE *copy)
 {
-  struct csv2rec_ctx ctx;
-  FILE *in;
   struct csv_parser p;
   unsigned char options = 0;
-  char buf[1024];
+  char *buf;
   size_t bytes_read = 0;
 
+  /* Initialize the csv library.  */
+  if (csv_init (&p, options) != 0)
+    {
+      recutl_fatal (_("failed to initialize csv parser\n"));
+    }
+
+  /* Set some properties of the parser.  */
+  if (csv2rec_strict)
+    {
+      options |= CSV_STRICT;
+      csv_set_opts (&p, options);
+    }
+
+  csv_set_space_func (&p, is_space);
+  csv_set_term_func  (&p, is_term);
+
+  /* Parse the input file in chunks of data, saving them in COPY if
+     requested.  */
+  buf = xmalloc (CSV2REC_BUF_SIZE);
+  while ((bytes_read = fread (buf, 1, CSV2REC_BUF_SIZE, in)) > 0)
+    {
+      if (csv_parse (&p, buf, bytes_read, field_cb, record_cb, ctx) != bytes_read)
+        {
+          recutl_fatal (_("error while parsing CSV file: %s\n"),
+                        csv_strerror (csv_error (&p)));
+        }
+
+      if (copy && (fwrite (buf, 1, bytes_read, copy) != bytes_read))
+        {
+          recutl_fatal (_("cannot write to a temporary file\n"));
+        }
+    }
+  free (buf);
+  csv_free (&p);
+}
+
+static bool
+process_csv (void)
+{
+  struct csv2rec_ctx ctx;
+  FILE *in;
+  FILE *copy;
+  size_t i;
+
   /* Initialize the data in the context.  */
-  ctx.db = NULL;
-  ctx.rset = NULL;
+  ctx.writer = rec_writer_new (stdout);
+  if (!ctx.writer)
+    recutl_out_of_memory ();
+  ctx.num_records = 0;
   ctx.record = NULL;
   ctx.header_p = true;
   ctx.field_names = NULL;
   ctx.num_field_names = 0;
   ctx.num_fields = 0;
   ctx.lineno = 0;
+  ctx.infer_p = false;
+  ctx.column_types = NULL;
+  ctx.column_values = NULL;
+  ctx.key_p = true;
+  ctx.key_last = 0;
 
   /* Set the files to read/write from/to.
 
@@ -352,63 +613,84 @@ process_csv (void)
       in = stdin;
     }
 
-  /* Initialize the csv library.  */
-  if (csv_init (&p, options) != 0)
+  if (csv2rec_infer_types)
     {
-      recutl_fatal (_("failed to initialize csv parser\n"));
-    }
+      /* The types must be known before writing the record
+         descriptor, so the input is read twice: first to infer the
+         types, and then to convert it.  Input that cannot be read
+         again, like a pipe, is saved in a temporary file.  */
 
-  /* Set some properties of the parser.  */
-  if (csv2rec_strict)
-    {
-      options |= CSV_STRICT;
-      csv_set_opts (&p, options);
-    }
+      for (i = 0; i < NUM_TYPES; i++)
+        {
+          csv2rec_types[i] = rec_type_new (csv2rec_type_names[i]);
+        }
 
-  csv_set_space_func (&p, is_space);
-  csv_set_term_func  (&p, is_term);
+      copy = NULL;
+      if (fseek (in, 0, SEEK_CUR) != 0)
+        {
+          copy = tmpfile ();
+          if (!copy)
+            {
+              recutl_fatal (_("cannot create a temporary file\n"));
+            }
+        }
 
-  /* Parse the input file in chunks of data.  */
-  while ((bytes_read = fread (buf, 1, 1024, in)) > 0)
-    {
-      if (csv_parse (&p, buf, bytes_read, field_cb, record_cb, &ctx) != bytes_read)
+      ctx.infer_p = true;
+      parse_csv (&ctx, in, copy);
+      ctx.infer_p = false;
+
+      if (copy)
         {
-          recutl_fatal (_("error while parsing CSV file: %s\n"),
-                        csv_strerror (csv_error (&p)));
+          if (in != stdin)
+            {
+              fclose (in);
+            }
+          in = copy;
         }
+      rewind (in);
 
+      /* A key must be present in every record.  */
+      ctx.key_p = ctx.key_p
+        && (ctx.num_field_names > 0)
+        && (ctx.column_values[0] == ctx.num_records);
+      for (i = 1; ctx.key_p && (i < ctx.num_field_names); i++)
+        {
+          ctx.key_p = !rec_field_name_equal_p (ctx.field_names[0],
+                                               ctx.field_names[i]);
+        }
+
+      /* The header is read again.  */
+      for (i = 0; i < ctx.num_field_names; i++)
+        {
+          free (ctx.field_names[i]);
+        }
+      ctx.num_field_names = 0;
+      ctx.header_p = true;
+      ctx.num_records = 0;
+      ctx.num_fields = 0;
+      ctx.lineno = 0;
     }
+
+  parse_csv (&ctx, in, NULL);
+
+  rec_writer_destroy (ctx.writer);
+  rec_record_destroy (ctx.record);
   
-  return ctx.db;
+  return (ctx.num_records > 0);
 }
 
 int
 main (int argc, char *argv[])
 {
-  int ret;
-  rec_db_t db;
-  rec_writer_t writer;
-
   recutl_init ("csv2rec");
 
   parse_args (argc, argv);
-  db = process_csv ();
-  ret = EXIT_SUCCESS;
-
-  if (db)
-    {
-      writer = rec_writer_new (stdout);
-      rec_write_db (writer, db);
-
-      rec_writer_destroy (writer);
-      rec_db_destroy (db);
-    }
-  else
+  if (!process_csv ())
     {
-      ret = EXIT_FAILURE;
+      return EXIT_FAILURE;
     }
 
-  return ret;
+  return EXIT_SUCCESS;
 }
 
 /* End of csv2rec.c */
@@ -28,7 +28,11 @@
 #include <getopt.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <xalloc.h>
+#include <gl_linkedhash_list.h>
+#include <gl_list.h>
+#include <hash-pjw.h>
 #include <gettext.h>
 #define _(str) gettext (str)
 
@@ -39,8 +43,7 @@
 /* Forward declarations.  */
 static void rec2csv_parse_args (int argc, char **argv);
 static bool rec2csv_process_data (rec_db_t db);
-static rec_fex_t rec2csv_determine_fields (rec_rset_t rset);
-static void rec2csv_generate_csv (rec_rset_t rset, rec_fex_t fex);
+static void rec2csv_generate_csv (rec_rset_t rset);
 
 /*
  * Types
@@ -53,6 +56,8 @@ static void rec2csv_generate_csv (rec_rset_t rset, rec_fex_t fex);
 char             *rec2csv_record_type    = NULL;
 rec_fex_t         rec2csv_sort_by_fields = NULL;
 char              rec2csv_delim          = ',';
+rec_fex_t         rec2csv_print_fields   = NULL;
+bool              rec2csv_descriptor_fields = false;
 
 /*
  * Command line options management
@@ -61,15 +66,21 @@ char              rec2csv_delim          = ',';
 enum
   {
     COMMON_ARGS,
+    LOCKING_ARGS,
     RECORD_TYPE_ARG,
-    SORT_ARG
+    SORT_ARG,
+    PRINT_ARG,
+    DESCRIPTOR_FIELDS_ARG
   };
 
 static const struct option GNU_longOptions[] =
   {
     COMMON_LONG_ARGS,
+    LOCKING_LONG_ARGS,
     {"type", required_argument, NULL, RECORD_TYPE_ARG},
     {"sort", required_argument, NULL, SORT_ARG},
+    {"print", required_argument, NULL, PRINT_ARG},
+    {"descriptor-fields", no_argument, NULL, DESCRIPTOR_FIELDS_ARG},
     {NULL, 0, NULL, 0}
   };
 
@@ -98,10 +109,15 @@ Convert rec data into csv data.\n"), stdout);
   -d, --delim=char                    sets the deliminator (default ',')\n\
   -t, --type=TYPE                     record set to convert to csv; if this parameter\n\
                                         is omitted then the default record set is used\n\
-  -S, --sort=FIELDS                   sort the output by the specified fields.\n"),
+  -S, --sort=FIELDS                   sort the output by the specified fields.\n\
+  -p, --print=FIELDS                  comma-separated list of fields to convert\n\
+                                        to columns, in that order.\n\
+      --descriptor-fields             convert the fields declared in the record\n\
+                                        descriptor to columns.\n"),
          stdout);
 
   recutl_print_help_common ();
+  recutl_print_help_locking ();
   puts ("");
   recutl_print_help_footer ();
 }
@@ -115,7 +131,7 @@ rec2csv_parse_args (int argc,
 
   while ((ret = getopt_long (argc,
                              argv,
-                             "t:S:d:",
+                             "t:S:d:p:",
                              GNU_longOptions,
                              NULL)) != -1)
     {
@@ -123,6 +139,7 @@ rec2csv_parse_args (int argc,
       switch (c)
         {
           COMMON_ARGS_CASES
+          LOCKING_ARGS_CASES
         case RECORD_TYPE_ARG:
         case 'd':
           {
@@ -157,6 +174,28 @@ rec2csv_parse_args (int argc,
 
             break;
           }
+        case PRINT_ARG:
+        case 'p':
+          {
+            if (!rec_fex_check (optarg, REC_FEX_SUBSCRIPTS))
+              {
+                recutl_fatal (_("invalid field name list in -p.\n"));
+              }
+
+            rec_fex_destroy (rec2csv_print_fields);
+            rec2csv_print_fields = rec_fex_new (optarg, REC_FEX_SUBSCRIPTS);
+            if (!rec2csv_print_fields)
+              {
+                recutl_fatal (_("internal error creating fex.\n"));
+              }
+
+            break;
+          }
+        case DESCRIPTOR_FIELDS_ARG:
+          {
+            rec2csv_descriptor_fields = true;
+            break;
+          }
         default:
           {
             exit (EXIT_FAILURE);
@@ -165,19 +204,224 @@ rec2csv_parse_args (int argc,
     }
 }
 
+/* Layout of the CSV rows generated for a record set.  The columns are
+   stored in a fex, where every element denotes a given occurrence of
+   a field name in the records.  The columns of every field name are
+   also indexed in a hash table, so the row of a record can be built
+   in a single pass over its fields.  */
+
+struct rec2csv_name_s
+{
+  char *name;
+  size_t *columns;     /* Column of every occurrence of the field,
+                          or SIZE_MAX if it is not in the CSV.  */
+  size_t num_columns;
+  size_t count;        /* Occurrences of the field in the current
+                          record.  */
+  size_t stamp;        /* Record where COUNT was computed.  */
+};
+
+struct rec2csv_layout_s
+{
+  rec_fex_t fex;
+  gl_list_t names;
+  size_t stamp;
+  const char **values;
+  size_t values_size;
+};
+
+typedef struct rec2csv_layout_s *rec2csv_layout_t;
+
+static bool
+rec2csv_name_equals_fn (const void *elt1,
+                        const void *elt2)
+{
+  const struct rec2csv_name_s *name1 = elt1;
+  const struct rec2csv_name_s *name2 = elt2;
+
+  return rec_field_name_equal_p (name1->name, name2->name);
+}
+
+static size_t
+rec2csv_name_hash_fn (const void *elt)
+{
+  const struct rec2csv_name_s *name = elt;
+
+  return hash_pjw (name->name, SIZE_MAX);
+}
+
+static void
+rec2csv_name_dispose_fn (const void *elt)
+{
+  struct rec2csv_name_s *name = (struct rec2csv_name_s *) elt;
+
+  free (name->name);
+  free (name->columns);
+  free (name);
+}
+
+static rec2csv_layout_t
+rec2csv_layout_new (void)
+{
+  rec2csv_layout_t layout;
+
+  layout = xzalloc (sizeof (struct rec2csv_layout_s));
+  layout->fex = rec_fex_new (NULL, REC_FEX_SIMPLE);
+  layout->names = gl_list_nx_create_empty (GL_LINKEDHASH_LIST,
+                                           rec2csv_name_equals_fn,
+                                           rec2csv_name_hash_fn,
+                                           rec2csv_name_dispose_fn,
+                                           false);
+  if (!layout->fex || !layout->names)
+    recutl_out_of_memory ();
+
+  return layout;
+}
+
+static void
+rec2csv_layout_destroy (rec2csv_layout_t layout)
+{
+  if (layout)
+    {
+      rec_fex_destroy (layout->fex);
+      gl_list_free (layout->names);
+      free (layout->values);
+      free (layout);
+    }
+}
+
+static struct rec2csv_name_s *
+rec2csv_layout_name (rec2csv_layout_t layout,
+                     const char *field_name,
+                     bool create_p)
+{
+  struct rec2csv_name_s key;
+  struct rec2csv_name_s *name;
+  gl_list_node_t node;
+
+  key.name = (char *) field_name;
+  node = gl_list_search (layout->names, &key);
+  if (node)
+    return (struct rec2csv_name_s *) gl_list_node_value (layout->names, node);
+
+  if (!create_p)
+    return NULL;
+
+  name = xzalloc (sizeof (struct rec2csv_name_s));
+  name->name = xstrdup (field_name);
+  if (!gl_list_nx_add_last (layout->names, name))
+    recutl_out_of_memory ();
+
+  return name;
+}
+
+/* Return the number of times the field NAME has been found in the
+   current record of LAYOUT before, and count this new occurrence.  */
+
+static size_t
+rec2csv_layout_occurrence (rec2csv_layout_t layout,
+                           struct rec2csv_name_s *name)
+{
+  if (name->stamp != layout->stamp)
+    {
+      name->stamp = layout->stamp;
+      name->count = 0;
+    }
+
+  return name->count++;
+}
+
+/* Add a column for the occurrence N of the field FIELD_NAME, unless
+   there is one already.  */
+
+static void
+rec2csv_layout_add (rec2csv_layout_t layout,
+                    const char *field_name,
+                    size_t n)
+{
+  struct rec2csv_name_s *name;
+
+  name = rec2csv_layout_name (layout, field_name, true);
+  if (n >= name->num_columns)
+    {
+      name->columns = xnrealloc (name->columns, n + 1, sizeof (size_t));
+      while (name->num_columns <= n)
+        name->columns[name->num_columns++] = SIZE_MAX;
+    }
+
+  if (name->columns[n] == SIZE_MAX)
+    {
+      name->columns[n] = rec_fex_size (layout->fex);
+      if (!rec_fex_append (layout->fex, field_name, n, n))
+        recutl_out_of_memory ();
+    }
+}
+
+/* Create a layout with the columns specified in FEX.  Subscripts
+   select the occurrences of the fields, and names without subscripts
+   stand for their first occurrence.  */
+
+static rec2csv_layout_t
+rec2csv_layout_from_fex (rec_fex_t fex)
+{
+  rec2csv_layout_t layout;
+  rec_fex_elem_t elem;
+  int min, max, n;
+  size_t i;
+
+  layout = rec2csv_layout_new ();
+  for (i = 0; i < rec_fex_size (fex); i++)
+    {
+      elem = rec_fex_get (fex, i);
+      min = rec_fex_elem_min (elem);
+      max = rec_fex_elem_max (elem);
+      if (min == -1)
+        min = 0;
+      if (max == -1)
+        max = min;
+
+      for (n = min; n <= max; n++)
+        rec2csv_layout_add (layout, rec_fex_elem_field_name (elem), n);
+    }
+
+  return layout;
+}
+
+/* Add the columns for the fields in RECORD which are not in LAYOUT
+   yet.  */
+
 static void
-rec2csv_generate_csv (rec_rset_t rset,
-                      rec_fex_t fex)
+rec2csv_layout_discover (rec2csv_layout_t layout,
+                         rec_record_t record)
 {
   rec_mset_iterator_t iter;
-  rec_fex_elem_t fex_elem;
-  rec_record_t record;
   rec_field_t field;
+  struct rec2csv_name_s *name;
+  size_t n;
+
+  layout->stamp++;
+
+  iter = rec_mset_iterator (rec_record_mset (record));
+  while (rec_mset_iterator_next (&iter, MSET_FIELD, (const void **) &field, NULL))
+    {
+      name = rec2csv_layout_name (layout, rec_field_name (field), true);
+      n = rec2csv_layout_occurrence (layout, name);
+      if ((n >= name->num_columns) || (name->columns[n] == SIZE_MAX))
+        rec2csv_layout_add (layout, rec_field_name (field), n);
+    }
+
+  rec_mset_iterator_free (&iter);
+}
+
+static void
+rec2csv_write_header (rec2csv_layout_t layout)
+{
+  rec_fex_t fex = layout->fex;
+  rec_fex_elem_t fex_elem;
   char *field_name;
   char *tmp;
   size_t i;
 
-  /* Generate the row with headers.  */
   for (i = 0; i < rec_fex_size (fex); i++)
     {
       if (i != 0)
@@ -216,80 +460,146 @@ rec2csv_generate_csv (rec_rset_t rset,
     }
 
   putc ('\n', stdout);
+}
 
-  /* Generate the data rows.  */
+static void
+rec2csv_write_row (rec2csv_layout_t layout,
+                   rec_record_t record)
+{
+  rec_mset_iterator_t iter;
+  rec_field_t field;
+  struct rec2csv_name_s *name;
+  size_t num_columns;
+  size_t i, n;
 
-  iter = rec_mset_iterator (rec_rset_mset (rset));
-  while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void**) &record, NULL))
+  num_columns = rec_fex_size (layout->fex);
+  if (layout->values_size < num_columns)
+    {
+      layout->values = xnrealloc (layout->values, num_columns,
+                                  sizeof (const char *));
+      layout->values_size = num_columns;
+    }
+  for (i = 0; i < num_columns; i++)
+    layout->values[i] = NULL;
+
+  /* Place the value of every field in its column.  */
+
+  layout->stamp++;
+
+  iter = rec_mset_iterator (rec_record_mset (record));
+  while (rec_mset_iterator_next (&iter, MSET_FIELD, (const void **) &field, NULL))
+    {
+      name = rec2csv_layout_name (layout, rec_field_name (field), false);
+      if (!name)
+        continue;
+
+      n = rec2csv_layout_occurrence (layout, name);
+      if ((n < name->num_columns) && (name->columns[n] != SIZE_MAX))
+        layout->values[name->columns[n]] = rec_field_value (field);
+    }
+
+  rec_mset_iterator_free (&iter);
+
+  /* Generate the data row.  */
+
+  for (i = 0; i < num_columns; i++)
     {
-      for (i = 0; i < rec_fex_size (fex); i++)
+      if (i != 0)
         {
-          if (i != 0)
-            {
-              putc (rec2csv_delim, stdout);
-            }
+          putc (rec2csv_delim, stdout);
+        }
 
-          fex_elem = rec_fex_get (fex, i);
-          field = rec_record_get_field_by_name (record,
-                                                rec_fex_elem_field_name (fex_elem),
-                                                rec_fex_elem_min (fex_elem));
-          if (field)
-            {
-              csv_fwrite (stdout,
-                          rec_field_value (field),
-                          strlen (rec_field_value (field)));
-            }
+      if (layout->values[i])
+        {
+          csv_fwrite (stdout,
+                      layout->values[i],
+                      strlen (layout->values[i]));
         }
+    }
 
-      putc ('\n', stdout);
+  putc ('\n', stdout);
+}
+
+/* Return the layout used for the rows of RSET if it can be determined
+   before reading its records, or NULL otherwise.  */
+
+static rec2csv_layout_t
+rec2csv_fixed_layout (rec_rset_t rset)
+{
+  rec2csv_layout_t layout = NULL;
+  rec_fex_t fex;
+
+  if (rec2csv_print_fields)
+    {
+      layout = rec2csv_layout_from_fex (rec2csv_print_fields);
     }
+  else if (rec2csv_descriptor_fields)
+    {
+      fex = rec_rset_declared_fields (rset);
+      if (!fex)
+        recutl_out_of_memory ();
 
-  rec_mset_iterator_free (&iter);
+      if (rec_fex_size (fex) > 0)
+        layout = rec2csv_layout_from_fex (fex);
+
+      rec_fex_destroy (fex);
+    }
+
+  return layout;
 }
 
-static rec_fex_t
-rec2csv_determine_fields (rec_rset_t rset)
+static void
+rec2csv_generate_csv (rec_rset_t rset)
 {
-  rec_fex_t fields;
-  rec_mset_iterator_t iter_rset;
-  rec_mset_iterator_t iter_record;
+  rec2csv_layout_t layout;
+  rec_mset_iterator_t iter;
   rec_record_t record;
-  rec_field_t field;
-  int field_index;
-  
-  fields = rec_fex_new (NULL, REC_FEX_SIMPLE);
 
-  iter_rset = rec_mset_iterator (rec_rset_mset (rset));
-  while (rec_mset_iterator_next (&iter_rset, MSET_RECORD, (const void **) &record, NULL))
+  /* Build the fields that will appear in the row. */
+
+  layout = rec2csv_fixed_layout (rset);
+  if (!layout)
     {
-      iter_record = rec_mset_iterator (rec_record_mset (record));
-      while (rec_mset_iterator_next (&iter_record, MSET_FIELD, (const void **) &field, NULL))
-        {
-          field_index = rec_record_get_field_index_by_name (record, field);
-          
-          if (!rec_fex_member_p (fields,
-                                 rec_field_name (field),
-                                 field_index, field_index))
-            {
-              rec_fex_append (fields,
-                              rec_field_name (field),
-                              field_index, field_index);
-            }
-        }
+      layout = rec2csv_layout_new ();
 
-      rec_mset_iterator_free (&iter_record);
+      iter = rec_mset_iterator (rec_rset_mset (rset));
+      while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+        rec2csv_layout_discover (layout, record);
+      rec_mset_iterator_free (&iter);
     }
 
-  rec_mset_iterator_free (&iter_rset);
+  /* Generate the csv data.  */
+
+  rec2csv_write_header (layout);
+
+  iter = rec_mset_iterator (rec_rset_mset (rset));
+  while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+    rec2csv_write_row (layout, record);
+  rec_mset_iterator_free (&iter);
+
+  rec2csv_layout_destroy (layout);
+}
+
+/* Determine whether the record set RSET is converted to csv.
+   SINGLE_P tells whether RSET is the only record set in the
+   database.  */
 
-  return fields;
+static bool
+rec2csv_rset_p (rec_rset_t rset,
+                bool single_p)
+{
+  if (rec2csv_record_type)
+    return (rec_rset_type (rset)
+            && (strcmp (rec_rset_type (rset),
+                        rec2csv_record_type) == 0));
+
+  return (!rec_rset_type (rset) || single_p);
 }
 
 static bool
 rec2csv_process_data (rec_db_t db)
 {
   bool ret;
-  rec_fex_t row_fields;
   size_t i;
   rec_rset_t rset;
 
@@ -298,38 +608,156 @@ rec2csv_process_data (rec_db_t db)
   for (i = 0; i < rec_db_size (db); i++)
     {
       rset = rec_db_get_rset (db, i);
-      if (((rec2csv_record_type)
-           && rec_rset_type (rset)
-           && (strcmp (rec_rset_type (rset),
-                       rec2csv_record_type) == 0))
-          || (!rec2csv_record_type
-              && (!rec_rset_type (rset) ||
-                  (rec_db_size (db) == 1))))
+      if (rec2csv_rset_p (rset, rec_db_size (db) == 1))
         {
           /* Process this record set.  */
 
           if (!rec_rset_sort (rset, rec2csv_sort_by_fields))
             recutl_out_of_memory ();
 
-          /* Build the fields that will appear in the row. */
-          row_fields = rec2csv_determine_fields (rset);
-  
-          /* Generate the csv data.  */
-          rec2csv_generate_csv (rset, row_fields);
-
-          /* Cleanup.  */
-          rec_fex_destroy (row_fields);
+          rec2csv_generate_csv (rset);
         }
     }
 
   return ret;
 }
 
+/* State of the conversion of a stream of record sets, which are
+   converted as they are parsed.  */
+
+struct rec2csv_stream_s
+{
+  size_t num_rsets;          /* Record sets parsed so far.  */
+  rec_rset_t rset;           /* Record set being parsed.  */
+  bool rset_p;               /* Whether RSET is converted.  */
+  bool single_p;             /* Whether RSET is converted if it is the
+                                only record set in the input.  */
+  rec2csv_layout_t layout;   /* Layout of RSET, or NULL if the rows
+                                can't be generated before reading
+                                all its records.  */
+};
+
+static bool
+rec2csv_stream_record (rec_record_t record,
+                       rec_rset_t rset,
+                       void *data)
+{
+  struct rec2csv_stream_s *stream = data;
+
+  if (rset != stream->rset)
+    {
+      /* First record of a new record set.  */
+
+      stream->rset = rset;
+      stream->rset_p = rec2csv_rset_p (rset, false);
+      stream->single_p = (!rec2csv_record_type
+                          && rec_rset_type (rset)
+                          && (stream->num_rsets == 0));
+
+      if (stream->rset_p)
+        {
+          stream->layout = rec2csv_fixed_layout (rset);
+          if (stream->layout)
+            rec2csv_write_header (stream->layout);
+        }
+    }
+
+  if (stream->rset_p && stream->layout)
+    {
+      rec2csv_write_row (stream->layout, record);
+      rec_record_destroy (record);
+      return true;
+    }
+
+  if (stream->rset_p || stream->single_p)
+    /* Keep the record in the record set.  */
+    return false;
+
+  /* Skip the record.  */
+  rec_record_destroy (record);
+  return true;
+}
+
+static bool
+rec2csv_process_stream (FILE *in,
+                        char *file_name)
+{
+  bool res = true;
+  struct rec2csv_stream_s stream;
+  rec_parser_t parser;
+  rec_rset_t rset;
+  rec_rset_t single = NULL;
+
+  stream.num_rsets = 0;
+  stream.rset = NULL;
+  stream.rset_p = false;
+  stream.single_p = false;
+  stream.layout = NULL;
+
+  parser = rec_parser_new (in, file_name);
+  if (!parser)
+    recutl_out_of_memory ();
+  rec_parser_set_record_callback (parser, rec2csv_stream_record, &stream);
+
+  while (rec_parse_rset (parser, &rset))
+    {
+      if (rset == stream.rset)
+        {
+          /* The records of the record set went through the callback,
+             and those not converted yet were kept in the record
+             set.  */
+
+          if (stream.rset_p && !stream.layout)
+            rec2csv_generate_csv (rset);
+        }
+      else if (rec2csv_rset_p (rset, false))
+        {
+          /* The record set doesn't contain records.  */
+          rec2csv_generate_csv (rset);
+        }
+
+      rec2csv_layout_destroy (stream.layout);
+      stream.layout = NULL;
+      stream.rset = NULL;
+
+      /* A typed record set is converted by default if it is the only
+         one in the input.  */
+
+      rec_rset_destroy (single);
+      single = NULL;
+      if ((stream.num_rsets == 0)
+          && !rec2csv_record_type
+          && rec_rset_type (rset))
+        single = rset;
+      else
+        rec_rset_destroy (rset);
+
+      stream.num_rsets++;
+    }
+
+  if (rec_parser_error (parser))
+    {
+      /* Report parsing errors.  */
+      rec_parser_perror (parser, "%s", file_name);
+      res = false;
+    }
+  else if (single && (stream.num_rsets == 1))
+    rec2csv_generate_csv (single);
+
+  rec2csv_layout_destroy (stream.layout);
+  rec_rset_destroy (single);
+  rec_parser_destroy (parser);
+
+  return res;
+}
+
 int
 main (int argc, char *argv[])
 {
   int res;
   rec_db_t db;
+  char *file_name;
+  FILE *in;
 
   res = 0;
 
@@ -338,6 +766,42 @@ main (int argc, char *argv[])
   /* Parse arguments.  */
   rec2csv_parse_args (argc, argv);
 
+  /* If the columns of the csv data are known in advance then the
+     records are converted as they are parsed, provided they don't
+     have to be sorted first.  This is only possible when reading a
+     single input without a journal.  */
+
+  if ((rec2csv_print_fields || rec2csv_descriptor_fields)
+      && !rec2csv_sort_by_fields
+      && (argc - optind <= 1))
+    {
+      file_name = NULL;
+      in = stdin;
+      if (optind < argc)
+        {
+          file_name = argv[optind];
+          if (!recutl_journal_p (file_name))
+            {
+              recutl_lock_file (file_name, false);
+              if (!(in = fopen (file_name, "r")))
+                recutl_fatal (_("cannot read file %s\n"), file_name);
+            }
+          else
+            in = NULL;
+        }
+
+      if (in)
+        {
+          if (!rec2csv_process_stream (in, file_name ? file_name : "stdin"))
+            res = 1;
+
+          if (file_name)
+            fclose (in);
+
+          return res;
+        }
+    }
+
   /* Get the input data.  */
   db = recutl_build_db (argc, argv);
   if (!db)
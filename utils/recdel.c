@@ -52,6 +52,8 @@ bool recutl_insensitive = false;
 bool recdel_force = false;
 bool recdel_verbose = false;
 bool recdel_external = true;
+bool recdel_in_place = false;
+bool recdel_journal = false;
 size_t recutl_random = 0;
 char *recdel_file = NULL;  /* File from where to delete the
                               records.  */
@@ -63,21 +65,27 @@ char *recdel_file = NULL;  /* File from where to delete the
 enum
 {
   COMMON_ARGS,
+  LOCKING_ARGS,
   RECORD_SELECTION_ARGS,
   COMMENT_ARG,
   FORCE_ARG,
   VERBOSE_ARG,
-  NO_EXTERNAL_ARG
+  NO_EXTERNAL_ARG,
+  IN_PLACE_ARG,
+  JOURNAL_ARG
 };
 
 static const struct option GNU_longOptions[] =
   {
     COMMON_LONG_ARGS,
+    LOCKING_LONG_ARGS,
     RECORD_SELECTION_LONG_ARGS,
     {"comment", no_argument, NULL, COMMENT_ARG},
     {"force", no_argument, NULL, FORCE_ARG},
     {"verbose", no_argument, NULL, VERBOSE_ARG},
     {"no-external", no_argument, NULL, NO_EXTERNAL_ARG},
+    {"in-place", no_argument, NULL, IN_PLACE_ARG},
+    {"journal", no_argument, NULL, JOURNAL_ARG},
     {NULL, 0, NULL, 0}
   };
 
@@ -104,11 +112,16 @@ Remove (or comment out) records from a rec file.\n"),
       --force                         delete even in potentially dangerous situations,\n\
                                         and if the deletion is violating record restrictions.\n\
       --no-external                   don't use external descriptors.\n\
+      --in-place                      only rewrite FILE from the first modified record\n\
+                                        onwards.\n\
+      --journal                       append the change to the journal of FILE instead\n\
+                                        of rewriting it.\n\
       --verbose                       give a detailed report if the integrity check\n\
                                         fails.\n"),
          stdout);
 
   recutl_print_help_common ();
+  recutl_print_help_locking ();
   
   puts ("");
   recutl_print_help_record_selection ();
@@ -189,6 +202,7 @@ recdel_parse_args (int argc,
       switch (c)
         {
           COMMON_ARGS_CASES
+          LOCKING_ARGS_CASES
           RECORD_SELECTION_ARGS_CASES
         case FORCE_ARG:
           {
@@ -205,6 +219,16 @@ recdel_parse_args (int argc,
             recdel_external = false;
             break;
           }
+        case IN_PLACE_ARG:
+          {
+            recdel_in_place = true;
+            break;
+          }
+        case JOURNAL_ARG:
+          {
+            recdel_journal = true;
+            break;
+          }
         case COMMENT_ARG:
         case 'c':
           {
@@ -255,6 +279,7 @@ int
 main (int argc, char *argv[])
 {
   rec_db_t db;
+  bool delete_p;
 
   recutl_init ("recdel");
 
@@ -266,7 +291,8 @@ main (int argc, char *argv[])
       recutl_fatal (_("cannot read file %s\n"), recdel_file);
     }
 
-  if (((recutl_num_indexes() != 0) || recutl_sex || recutl_quick_str) || recdel_force || (recutl_random > 0))
+  delete_p = (((recutl_num_indexes() != 0) || recutl_sex || recutl_quick_str) || recdel_force || (recutl_random > 0));
+  if (delete_p)
     {
       recdel_delete_records (db);
     }
@@ -276,7 +302,25 @@ main (int argc, char *argv[])
       recutl_error (_("file %s is not writable.\n"), recdel_file);
       return EXIT_FAILURE;
     }
-  recutl_write_db_to_file (db, recdel_file);
+
+  if (recdel_journal
+      && delete_p
+      && (recutl_random == 0)
+      && recutl_journal_delete (recdel_file,
+                                recutl_type,
+                                recutl_index (),
+                                recutl_sex_str,
+                                recutl_quick_str,
+                                recutl_insensitive,
+                                recdel_comment))
+    {
+      /* The file is left untouched.  */
+      rec_db_destroy (db);
+    }
+  else if (recdel_in_place)
+    recutl_update_db_file (db, recdel_file);
+  else
+    recutl_write_db_to_file (db, recdel_file);
 
   return EXIT_SUCCESS;
 }
@@ -44,6 +44,7 @@ static int recfix_do_sort (void);
 static int recfix_do_crypt (void);
 #endif
 static int recfix_do_auto (void);
+static int recfix_do_compact (void);
 
 /*
  * Data types.
@@ -61,7 +62,8 @@ enum recfix_op
   RECFIX_OP_DECRYPT,
 #endif
   RECFIX_OP_SORT,
-  RECFIX_OP_AUTO
+  RECFIX_OP_AUTO,
+  RECFIX_OP_COMPACT
 };
 
 /*
@@ -73,6 +75,7 @@ char *recfix_file     = NULL;
 int   recfix_op       = RECFIX_OP_INVALID;
 char *recfix_password = NULL;
 bool  recfix_force    = false;
+size_t recfix_jobs    = 1;
 
 /*
  * Command line options management.
@@ -81,6 +84,7 @@ bool  recfix_force    = false;
 enum
 {
   COMMON_ARGS,
+  LOCKING_ARGS,
   NO_EXTERNAL_ARG,
   FORCE_ARG,
   OP_SORT_ARG,
@@ -88,14 +92,17 @@ enum
   PASSWORD_ARG,
   OP_ENCRYPT_ARG,
   OP_DECRYPT_ARG,
+  JOBS_ARG,
 #endif
   OP_CHECK_ARG,
-  OP_AUTO_ARG
+  OP_AUTO_ARG,
+  OP_COMPACT_ARG
 };
 
 static const struct option GNU_longOptions[] =
   {
     COMMON_LONG_ARGS,
+    LOCKING_LONG_ARGS,
     {"no-external", no_argument, NULL, NO_EXTERNAL_ARG},
     {"force", no_argument, NULL, FORCE_ARG},
     {"check", no_argument, NULL, OP_CHECK_ARG},
@@ -104,8 +111,10 @@ static const struct option GNU_longOptions[] =
     {"password", required_argument, NULL, PASSWORD_ARG},
     {"encrypt", no_argument, NULL, OP_ENCRYPT_ARG},
     {"decrypt", no_argument, NULL, OP_DECRYPT_ARG},
+    {"jobs", required_argument, NULL, JOBS_ARG},
 #endif
     {"auto", no_argument, NULL, OP_AUTO_ARG},
+    {"compact", no_argument, NULL, OP_COMPACT_ARG},
     {NULL, 0, NULL, 0}
   };
 
@@ -132,6 +141,7 @@ Check and fix rec files.\n"),
          stdout);
 
   recutl_print_help_common ();
+  recutl_print_help_locking ();
 
   puts("");
   /* TRANSLATORS: --help output, recfix operations.
@@ -140,7 +150,8 @@ Check and fix rec files.\n"),
 Operations:\n\
       --check                         check integrity of the specified file.  Default.\n\
       --sort                          sort the records in the specified file.\n\
-      --auto                          insert auto-generated fields in records missing them.\n"),
+      --auto                          insert auto-generated fields in records missing them.\n\
+      --compact                       apply the changes in the journal of the specified file.\n"),
          stdout);
 
 #if defined REC_CRYPT_SUPPORT
@@ -157,7 +168,8 @@ Operations:\n\
      no-wrap */
   fputs (_("\
 De/Encryption options:\n\
-  -s, --password=PASSWORD             encrypt/decrypt with this password.\n"),
+  -s, --password=PASSWORD             encrypt/decrypt with this password.\n\
+      --jobs=NUM                      use NUM threads to encrypt/decrypt the records.\n"),
          stdout);
 #endif /* REC_CRYPT_SUPPORT */
 
@@ -189,6 +201,7 @@ recfix_parse_args (int argc,
       switch (c)
         {
           COMMON_ARGS_CASES
+          LOCKING_ARGS_CASES
         case NO_EXTERNAL_ARG:
           {
             recfix_external = false;
@@ -222,6 +235,18 @@ recfix_parse_args (int argc,
             recfix_password = xstrdup (optarg);
             break;
           }
+        case JOBS_ARG:
+          {
+            char *end;
+            long int li = strtol (optarg, &end, 10);
+            if ((*optarg == '\0') || (*end != '\0') || (li < 0))
+              {
+                recutl_fatal (_("invalid number in --jobs\n"));
+              }
+
+            recfix_jobs = li;
+            break;
+          }
 #endif /* REC_CRYPT_SUPPORT */
         case OP_CHECK_ARG:
           {
@@ -253,6 +278,16 @@ recfix_parse_args (int argc,
             recfix_op = RECFIX_OP_AUTO;
             break;
           }
+        case OP_COMPACT_ARG:
+          {
+            if (recfix_op != RECFIX_OP_INVALID)
+              {
+                recutl_fatal (_("please specify just one operation.\n"));
+              }
+
+            recfix_op = RECFIX_OP_COMPACT;
+            break;
+          }
 #if defined REC_CRYPT_SUPPORT
         case OP_ENCRYPT_ARG:
           {
@@ -419,6 +454,7 @@ recfix_do_crypt ()
 {
   rec_db_t db;
   size_t n_rset;
+  rec_crypt_ctx_t crypt_ctx;
 
   /* Read the database from the specified file. */
 
@@ -428,52 +464,41 @@ recfix_do_crypt ()
       return EXIT_FAILURE;
     }
 
+  /* Make sure the cipher can be initialized with the given password
+     before processing any record.  */
+
+  crypt_ctx = rec_crypt_ctx_new (recfix_password);
+  if (!crypt_ctx)
+    {
+      recutl_fatal (_("cannot initialize the cipher.\n"));
+    }
+  rec_crypt_ctx_destroy (crypt_ctx);
+
   /* Encrypt/decrypt any unencrypted/encrypted field marked as
-     "confidential" using the given password.  */
+     "confidential" using the given password.  The records of every
+     record set are processed by up to recfix_jobs threads.  */
 
   for (n_rset = 0; n_rset < rec_db_size (db); n_rset++)
     {
-      rec_mset_iterator_t iter;
-      rec_fex_t confidential_fields;
-      rec_record_t record;
       rec_rset_t rset =
         rec_db_get_rset (db, n_rset);
 
-      /* Skip record sets not having any confidential fields.  */
-
-      confidential_fields = rec_rset_confidential (rset);
-      if (confidential_fields == NULL)
-        {
-          continue;
-        }
-
-      /* Process every record of the record set.  */
-
-      iter = rec_mset_iterator (rec_rset_mset (rset));
-      while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &record, NULL))
+      if (recfix_op == RECFIX_OP_ENCRYPT)
         {
-          if (recfix_op == RECFIX_OP_ENCRYPT)
+          if (!rec_encrypt_rset (rset, recfix_password, recfix_jobs)
+              && !recfix_force)
             {
-              /* Encrypt any unencrypted confidential field in this
-                 record.  */
-
-              if (!rec_encrypt_record (rset, record, recfix_password)
-                  && !recfix_force)
-                {
-                  recutl_error (_("the database contains already encrypted fields\n"));
-                  recutl_fatal (_("please use --force or --decrypt\n"));
-                }
+              recutl_error (_("the database contains already encrypted fields\n"));
+              recutl_fatal (_("please use --force or --decrypt\n"));
             }
-          else
+        }
+      else
+        {
+          if (!rec_decrypt_rset (rset, recfix_password, recfix_jobs))
             {
-              /* Decrypt any encrypted confidential field in this
-                 record.  */
-
-              rec_decrypt_record (rset, record, recfix_password);
+              recutl_fatal (_("error decrypting the confidential fields.\n"));
             }
         }
-
-      rec_mset_iterator_free (&iter);
     }
 
   /* Write the modified database back to the file.  */
@@ -527,6 +552,46 @@ recfix_do_auto ()
   return EXIT_SUCCESS;
 }
 
+static int
+recfix_do_compact ()
+{
+  rec_db_t db;
+
+  /* Read the database from the specified file, which replays its
+     journal, and write it back.  This removes the journal.  */
+
+  if (!recfix_file)
+    {
+      recutl_fatal (_("please specify a file to compact.\n"));
+    }
+
+  if (!recutl_journal_p (recfix_file))
+    {
+      /* Nothing to do.  */
+      return EXIT_SUCCESS;
+    }
+
+  db = recutl_read_db_from_file (recfix_file);
+  if (!db)
+    {
+      return EXIT_FAILURE;
+    }
+
+  if (!recfix_check_database (db))
+    {
+      return EXIT_FAILURE;
+    }
+
+  if (!recutl_file_is_writable (recfix_file))
+    {
+      recutl_error (_("file %s is not writable.\n"), recfix_file);
+      return EXIT_FAILURE;
+    }
+
+  recutl_write_db_to_file (db, recfix_file);
+  return EXIT_SUCCESS;
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -558,6 +623,11 @@ main (int argc, char *argv[])
         res = recfix_do_auto ();
         break;
       }
+    case RECFIX_OP_COMPACT:
+      {
+        res = recfix_do_compact ();
+        break;
+      }
 #if defined REC_CRYPT_SUPPORT
     case RECFIX_OP_ENCRYPT:
     case RECFIX_OP_DECRYPT:
@@ -42,6 +42,7 @@
 /* Forward declarations.  */
 bool recins_insert_record (rec_db_t db, char *type, rec_record_t record);
 void recins_parse_args (int argc, char **argv);
+rec_rset_t recins_append_rset (rec_db_t db);
 
 /*
  * Global variables
@@ -58,6 +59,7 @@ bool          recins_force     = false;
 bool          recins_verbose   = false;
 bool          recins_external  = true;
 bool          recins_auto      = true;
+bool          recins_journal   = false;
 char         *recins_password  = NULL;
 size_t        recutl_random    = 0;
 
@@ -68,6 +70,7 @@ size_t        recutl_random    = 0;
 enum
 {
   COMMON_ARGS,
+  LOCKING_ARGS,
   RECORD_SELECTION_ARGS,
   NAME_ARG,
   VALUE_ARG,
@@ -78,12 +81,14 @@ enum
 #if defined REC_CRYPT_SUPPORT
   PASSWORD_ARG,
 #endif
-  NO_AUTO_ARG
+  NO_AUTO_ARG,
+  JOURNAL_ARG
 };
 
 static const struct option GNU_longOptions[] =
   {
     COMMON_LONG_ARGS,
+    LOCKING_LONG_ARGS,
     RECORD_SELECTION_LONG_ARGS,
     {"type", required_argument, NULL, TYPE_ARG},
     {"name", required_argument, NULL, NAME_ARG},
@@ -93,6 +98,7 @@ static const struct option GNU_longOptions[] =
     {"no-external", no_argument, NULL, NO_EXTERNAL_ARG},
     {"record", required_argument, NULL, RECORD_ARG},
     {"no-auto", no_argument, NULL, NO_AUTO_ARG},
+    {"journal", no_argument, NULL, JOURNAL_ARG},
 #if defined REC_CRYPT_SUPPORT
     {"password", required_argument, NULL, PASSWORD_ARG},
 #endif
@@ -127,6 +133,8 @@ Insert new records in a rec database.\n"), stdout);
                                         record restrictions.\n\
       --no-external                   don't use external descriptors.\n\
       --no-auto                       don't insert auto generated fields.\n\
+      --journal                       append the new record to the journal of FILE\n\
+                                        instead of rewriting it.\n\
       --verbose                       give a detailed report if the integrity check\n\
                                         fails.\n"), stdout);
 
@@ -139,6 +147,7 @@ Insert new records in a rec database.\n"), stdout);
 #endif
 
   recutl_print_help_common ();
+  recutl_print_help_locking ();
 
   puts ("");
   recutl_print_help_record_selection ();
@@ -176,6 +185,7 @@ void recins_parse_args (int argc,
       switch (c)
         {
           COMMON_ARGS_CASES
+          LOCKING_ARGS_CASES
           RECORD_SELECTION_ARGS_CASES
         case FORCE_ARG:
           {
@@ -235,6 +245,11 @@ void recins_parse_args (int argc,
             recins_auto = false;
             break;
           }
+        case JOURNAL_ARG:
+          {
+            recins_journal = true;
+            break;
+          }
 #if defined REC_CRYPT_SUPPORT
         case PASSWORD_ARG:
         case 's':
@@ -380,18 +395,64 @@ recins_add_new_record (rec_db_t db)
                       flags))
     recutl_out_of_memory ();
 
-  /* Check for the integrity of the resulting database.  */
+}
+
+rec_rset_t
+recins_append_rset (rec_db_t db)
+{
+  rec_rset_t rset;
+  rec_mset_iterator_t iter;
+  rec_mset_elem_t elem;
+  rec_mset_type_t last_type;
+
+  /* The new record can be appended to the file without rewriting it
+     only if it is not replacing other records, it goes to an already
+     existing record set, that record set is the last one in the file
+     and nothing but records follows its last record.  Return that
+     record set, or NULL if the whole database must be written.  */
+
+  if (!recins_file
+      || !recins_record
+      || (rec_record_num_fields (recins_record) == 0)
+      || recutl_index ()
+      || recutl_sex
+      || recutl_quick_str
+      || (recutl_random > 0)
+      || (rec_db_size (db) == 0)
+      || recutl_journal_p (recins_file))
+    {
+      return NULL;
+    }
+
+  rset = rec_db_get_rset_by_type (db, recutl_type);
+  if (!rset || (rset != rec_db_get_rset (db, rec_db_size (db) - 1)))
+    {
+      return NULL;
+    }
+
+  last_type = MSET_RECORD;
+  iter = rec_mset_iterator (rec_rset_mset (rset));
+  while (rec_mset_iterator_next (&iter, MSET_ANY, NULL, &elem))
+    {
+      last_type = rec_mset_elem_type (elem);
+    }
+  rec_mset_iterator_free (&iter);
 
-  if (!recins_force && db)
+  if ((last_type != MSET_RECORD)
+      || (rec_rset_num_elems (rset) > 0
+          && rec_rset_descriptor_pos (rset) >= rec_rset_num_elems (rset)))
     {
-      recutl_check_integrity (db, recins_verbose, recins_external);
+      return NULL;
     }
+
+  return rset;
 }
 
 int
 main (int argc, char *argv[])
 {
   rec_db_t db;
+  rec_rset_t append_rset;
 
   recutl_init ("recins");
 
@@ -403,14 +464,56 @@ main (int argc, char *argv[])
       /* Create an empty database.  */
       db = rec_db_new ();
     }
+
+  append_rset = recins_append_rset (db);
   recins_add_new_record (db);
 
+  /* Check for the integrity of the resulting database.  Only the
+     records inserted or replaced are checked, and if the new record
+     was just appended to the last record set the other records in it
+     are not even visited.  */
+
+  if (!recins_force)
+    {
+      if (append_rset)
+        recutl_check_integrity_append (db, append_rset, recins_record,
+                                       recins_verbose, recins_external);
+      else
+        recutl_check_integrity_incremental (db, recins_verbose,
+                                            recins_external);
+    }
+
   if (!recutl_file_is_writable (recins_file))
     {
       recutl_error (_("file %s is not writable.\n"), recins_file);
       return EXIT_FAILURE;
     }
-  recutl_write_db_to_file (db, recins_file);
+
+  if (recins_journal
+      && recins_record
+      && (rec_record_num_fields (recins_record) > 0)
+      && (recutl_random == 0)
+      && recutl_journal_insert (recins_file,
+                                recutl_type,
+                                recutl_index (),
+                                recutl_sex_str,
+                                recutl_quick_str,
+                                recutl_insensitive,
+                                recins_record))
+    {
+      /* The file is left untouched.  */
+      rec_db_destroy (db);
+    }
+  else if (append_rset)
+    {
+      /* Write just the new record at the end of the file.  */
+      recutl_append_record_to_file (recins_record, recins_file);
+      rec_db_destroy (db);
+    }
+  else
+    {
+      recutl_write_db_to_file (db, recins_file);
+    }
 
   return EXIT_SUCCESS;
 }
@@ -60,6 +60,7 @@ char      *recsel_password     = NULL;
 bool       recsel_uniq         = false;
 size_t     recutl_random       = 0;
 char      *recsel_join         = NULL;
+size_t     recsel_jobs         = 1;
 
 /*
  * Command line options management.
@@ -68,6 +69,7 @@ char      *recsel_join         = NULL;
 enum
 {
   COMMON_ARGS,
+  LOCKING_ARGS,
   RECORD_SELECTION_ARGS,
   PRINT_ARG,
   PRINT_VALUES_ARG,
@@ -82,12 +84,14 @@ enum
 #endif
   UNIQ_ARG,
   GROUP_BY_ARG,
-  JOIN_ARG
+  JOIN_ARG,
+  JOBS_ARG
 };
 
 static const struct option GNU_longOptions[] =
   {
     COMMON_LONG_ARGS,
+    LOCKING_LONG_ARGS,
     RECORD_SELECTION_LONG_ARGS,
     {"print", required_argument, NULL, PRINT_ARG},
     {"print-values", required_argument, NULL, PRINT_VALUES_ARG},
@@ -103,6 +107,7 @@ static const struct option GNU_longOptions[] =
     {"uniq", no_argument, NULL, UNIQ_ARG},
     {"group-by", required_argument, NULL, GROUP_BY_ARG},
     {"join", required_argument, NULL, JOIN_ARG},
+    {"jobs", required_argument, NULL, JOBS_ARG},
     {NULL, 0, NULL, 0}
   };
 
@@ -132,7 +137,9 @@ Select and print rec data.\n"), stdout);
   -C, --collapse                      do not section the result in records with newlines.\n\
   -S, --sort=FIELD,...                sort the output by the specified fields.\n\
   -G, --group-by=FIELD,...            group records by the specified fields.\n\
-  -U, --uniq                          remove duplicated fields in the output records.\n"),
+  -U, --uniq                          remove duplicated fields in the output records.\n\
+      --jobs=NUM                      use NUM threads to select and format the records.\n\
+                                        0 means as many threads as processors.\n"),
          stdout);
 
 #if defined REC_CRYPT_SUPPORT
@@ -144,6 +151,7 @@ Select and print rec data.\n"), stdout);
 #endif
   
   recutl_print_help_common ();
+  recutl_print_help_locking ();
 
   puts ("");
   recutl_print_help_record_selection ();
@@ -196,6 +204,7 @@ recsel_parse_args (int argc,
       switch (c)
         {
         COMMON_ARGS_CASES
+        LOCKING_ARGS_CASES
         RECORD_SELECTION_ARGS_CASES
         case DESCRIPTOR_ARG:
         case 'd':
@@ -342,6 +351,18 @@ recsel_parse_args (int argc,
                 }
             }
 
+            break;
+          }
+        case JOBS_ARG:
+          {
+            char *end;
+            long int li = strtol (optarg, &end, 10);
+            if ((*optarg == '\0') || (*end != '\0') || (li < 0))
+              {
+                recutl_fatal (_("invalid number in --jobs\n"));
+              }
+
+            recsel_jobs = li;
             break;
           }
         case COLLAPSE_ARG:
@@ -461,6 +482,12 @@ recsel_process_data (rec_db_t db)
         flags = flags | REC_F_UNIQ;
       }
 
+    if (recsel_jobs != 1)
+      {
+        rec_db_set_jobs (db, recsel_jobs);
+        flags = flags | REC_F_PARALLEL;
+      }
+
     rset = rec_db_query (db,
                          recutl_type,
                          recsel_join,
@@ -491,6 +518,7 @@ recsel_process_data (rec_db_t db)
       rec_writer_set_collapse (writer, recsel_collapse);
       rec_writer_set_skip_comments (writer, true);
       rec_writer_set_mode (writer, recsel_write_mode);
+      rec_writer_set_jobs (writer, recsel_jobs);
       rec_write_rset (writer, rset);
       rec_writer_destroy (writer);
     }
@@ -513,6 +541,30 @@ main (int argc, char *argv[])
   /* Parse arguments.  */
   recsel_parse_args (argc, argv);
 
+  /* Records that do not contain the fast string, or the string
+     literal required by the selection expression, cannot be selected
+     and thus are not built while parsing.  This is not possible if
+     the selection depends on the position of the records, if records
+     are grouped before being selected, if joins are performed, or if
+     the whole record set is used to compute aggregates.  */
+
+  if ((recutl_num_indexes () == 0)
+      && (recutl_random == 0)
+      && !recsel_join
+      && !recsel_group_by_fields
+      && !(recsel_fex && rec_fex_all_calls_p (recsel_fex)))
+    {
+      if (recutl_quick_str)
+        {
+          recutl_set_prefilter (recutl_quick_str, recutl_insensitive);
+        }
+      else if (recutl_sex)
+        {
+          recutl_set_prefilter (rec_sex_literal (recutl_sex),
+                                recutl_insensitive);
+        }
+    }
+
   /* Get the input data.  */
   db = recutl_build_db (argc, argv);
   if (!db)
@@ -60,6 +60,9 @@ char      *recset_file        = NULL;
 bool       recset_force       = false;
 bool       recset_verbose     = false;
 bool       recset_external    = true;
+bool       recset_in_place    = false;
+bool       recset_journal     = false;
+char      *recset_batch       = NULL;
 bool       recset_descriptor_renamed = false;
 size_t     recutl_random      = 0;
 
@@ -70,6 +73,7 @@ size_t     recutl_random      = 0;
 enum
   {
     COMMON_ARGS,
+    LOCKING_ARGS,
     RECORD_SELECTION_ARGS,
     FIELD_EXPR_ARG,
     ADD_ACTION_ARG,
@@ -80,12 +84,16 @@ enum
     SET_ADD_ACTION_ARG,
     FORCE_ARG,
     VERBOSE_ARG,
-    NO_EXTERNAL_ARG
+    NO_EXTERNAL_ARG,
+    IN_PLACE_ARG,
+    JOURNAL_ARG,
+    BATCH_ARG
   };
 
 static const struct option GNU_longOptions[] =
   {
     COMMON_LONG_ARGS,
+    LOCKING_LONG_ARGS,
     RECORD_SELECTION_LONG_ARGS,
     {"fields", required_argument, NULL, FIELD_EXPR_ARG},
     {"add", required_argument, NULL, ADD_ACTION_ARG},
@@ -97,6 +105,9 @@ static const struct option GNU_longOptions[] =
     {"force", no_argument, NULL, FORCE_ARG},
     {"verbose", no_argument, NULL, VERBOSE_ARG},
     {"no-external", no_argument, NULL, NO_EXTERNAL_ARG},
+    {"in-place", no_argument, NULL, IN_PLACE_ARG},
+    {"journal", no_argument, NULL, JOURNAL_ARG},
+    {"batch", required_argument, NULL, BATCH_ARG},
     {NULL, 0, NULL, 0}
   };
 
@@ -123,10 +134,15 @@ Alter or delete fields in records.\n"), stdout);
      no-wrap */
   fputs (_("\
       --no-external                   don't use external descriptors.\n\
+      --in-place                      only rewrite FILE from the first modified record\n\
+                                        onwards.\n\
+      --journal                       append the change to the journal of FILE instead\n\
+                                        of rewriting it.\n\
       --force                         alter the records even if violating record\n\
                                         restrictions.\n"), stdout);
 
   recutl_print_help_common ();
+  recutl_print_help_locking ();
 
   puts ("");
   recutl_print_help_record_selection ();
@@ -154,6 +170,15 @@ Actions:\n\
   -d, --delete                        delete the selected fields.\n\
   -c, --comment                       comment out the selected fields.\n"), stdout);
 
+  puts ("");
+  /* TRANSLATORS: --help output, recset batch mode.
+     no-wrap */
+  fputs (_("\
+Batch mode:\n\
+      --batch=FILE                    apply the insertions, modifications and deletions\n\
+                                        described in FILE, or in the standard input if\n\
+                                        FILE is -.\n"), stdout);
+
   puts ("");
   recutl_print_help_footer ();
 }
@@ -193,6 +218,7 @@ recset_parse_args (int argc,
       switch (c)
         {
           COMMON_ARGS_CASES
+          LOCKING_ARGS_CASES
           RECORD_SELECTION_ARGS_CASES
         case FORCE_ARG:
           {
@@ -290,6 +316,21 @@ recset_parse_args (int argc,
             recset_external = false;
             break;
           }
+        case IN_PLACE_ARG:
+          {
+            recset_in_place = true;
+            break;
+          }
+        case JOURNAL_ARG:
+          {
+            recset_journal = true;
+            break;
+          }
+        case BATCH_ARG:
+          {
+            recset_batch = xstrdup (optarg);
+            break;
+          }
         default:
           {
             exit (EXIT_FAILURE);
@@ -310,6 +351,32 @@ recset_parse_args (int argc,
       recset_file = argv[optind++];
     }
 
+  /* The operations in a batch carry their own selections and
+     actions.  */
+
+  if (recset_batch)
+    {
+      if ((recset_action != REC_SET_ACT_NONE) || recutl_fex)
+        {
+          recutl_fatal (_("cannot specify --batch and also an action.\n"));
+        }
+
+      if (recutl_type || recutl_sex || recutl_quick_str
+          || (recutl_num_indexes () != 0) || (recutl_random > 0))
+        {
+          recutl_fatal (_("cannot specify --batch and also select records.\n"));
+        }
+
+      if (recset_journal)
+        {
+          recutl_fatal (_("cannot specify --batch and also --journal.\n"));
+        }
+
+      if (!recset_file && (strcmp (recset_batch, "-") == 0))
+        {
+          recutl_fatal (_("cannot read both the batch and the data from the standard input.\n"));
+        }
+    }
 }
 
 static void
@@ -322,23 +389,31 @@ recset_process_actions (rec_db_t db)
       flags = flags | REC_F_ICASE;
     }
 
-  if (!rec_db_set (db,
-                   recutl_type,
-                   recutl_index (),
-                   recutl_sex,
-                   recutl_quick_str,
-                   recutl_random,
-                   recutl_fex,
-                   recset_action,
-                   recset_value,
-                   flags))
+  if (recset_batch)
+    {
+      /* Apply all the operations in the batch before checking the
+         integrity of the database, just once.  */
+
+      recutl_apply_batch (db, recset_batch);
+    }
+  else if (!rec_db_set (db,
+                        recutl_type,
+                        recutl_index (),
+                        recutl_sex,
+                        recutl_quick_str,
+                        recutl_random,
+                        recutl_fex,
+                        recset_action,
+                        recset_value,
+                        flags))
     recutl_out_of_memory ();
   
-  /* Check the integrity of the resulting database.  */
+  /* Check the integrity of the resulting database.  Only the
+     modified records are checked again.  */
 
   if (!recset_force && db)
     {
-      recutl_check_integrity (db, recset_verbose, recset_external);
+      recutl_check_integrity_incremental (db, recset_verbose, recset_external);
     }
 }
 
@@ -365,7 +440,27 @@ main (int argc, char *argv[])
       recutl_error (_("file %s is not writable.\n"), recset_file);
       return EXIT_FAILURE;
     }
-  recutl_write_db_to_file (db, recset_file);
+
+  if (recset_journal
+      && (recset_action != REC_SET_ACT_NONE)
+      && (recutl_random == 0)
+      && recutl_journal_set (recset_file,
+                             recutl_type,
+                             recutl_index (),
+                             recutl_sex_str,
+                             recutl_quick_str,
+                             recutl_insensitive,
+                             recutl_fex_str,
+                             recset_action,
+                             recset_value))
+    {
+      /* The file is left untouched.  */
+      rec_db_destroy (db);
+    }
+  else if (recset_in_place)
+    recutl_update_db_file (db, recset_file);
+  else
+    recutl_write_db_to_file (db, recset_file);
 
   return EXIT_SUCCESS;
 }
@@ -41,6 +41,10 @@
 #endif
 #include <progname.h>
 #include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <readline.h>
 #include <regex.h>
 #include <stdint.h>
@@ -62,9 +66,29 @@ static char   *recutl_order_by_field = NULL;
 static bool    recutl_interactive_p  = false;
 static size_t *recutl_indexes        = NULL;
 static size_t  recutl_indexes_size   = 0;
+static const char *recutl_prefilter   = NULL;
+static bool    recutl_prefilter_case_insensitive = false;
+static int     recutl_lock_timeout   = -1;
+
+/* List of the files locked by recutl_lock_file.  The locks are held
+   until the program exits.  */
+
+struct recutl_lock_s
+{
+  char *file_name;
+  int des;
+  struct recutl_lock_s *next;
+};
+
+static struct recutl_lock_s *recutl_locks = NULL;
 
 void recutl_print_help (void); /* Forward prototype.  */
 
+static rec_rset_t recutl_journal_read (const char *file_name);
+static void recutl_journal_replay (rec_db_t db, const char *file_name,
+                                   rec_rset_t journal);
+static void recutl_journal_remove (const char *file_name);
+
 void
 recutl_init (char *util_name)
 {
@@ -140,6 +164,17 @@ recutl_print_help_common (void)
          stdout);
 }
 
+void
+recutl_print_help_locking (void)
+{
+  /* TRANSLATORS: --help output, locking arguments.
+     no-wrap */
+  fputs (_("\
+      --lock-timeout=SECS             give up if the files are still in use by other\n\
+                                        programs after SECS seconds.\n"),
+         stdout);
+}
+
 void
 recutl_print_help_record_selection (void)
 {
@@ -237,6 +272,12 @@ recutl_parse_db_from_file (FILE *in,
   res = true;
 
   parser = rec_parser_new (in, file_name);
+  if (!parser
+      || !rec_parser_set_prefilter (parser,
+                                    recutl_prefilter,
+                                    recutl_prefilter_case_insensitive))
+    recutl_out_of_memory ();
+
   while (rec_parse_rset (parser, &rset))
     {
       char *rset_type;
@@ -292,6 +333,153 @@ recutl_parse_db_from_file (FILE *in,
   return res;
 }
 
+void
+recutl_set_prefilter (const char *str, bool case_insensitive)
+{
+  recutl_prefilter = str;
+  recutl_prefilter_case_insensitive = case_insensitive;
+}
+
+void
+recutl_set_lock_timeout (int seconds)
+{
+  recutl_lock_timeout = seconds;
+}
+
+static bool
+recutl_lock_des (int des,
+                 bool exclusive)
+{
+  int operation = exclusive ? LOCK_EX : LOCK_SH;
+  struct timespec delay;
+  long long int attempts;
+
+  if (recutl_lock_timeout < 0)
+    {
+      /* Wait for as long as needed.  */
+      while (flock (des, operation) == -1)
+        {
+          if (errno != EINTR)
+            {
+              return false;
+            }
+        }
+
+      return true;
+    }
+
+  /* Poll the lock every 50 milliseconds until the timeout
+     expires.  */
+
+  delay.tv_sec = 0;
+  delay.tv_nsec = 50000000;
+  attempts = (long long int) recutl_lock_timeout * 20;
+  while (flock (des, operation | LOCK_NB) == -1)
+    {
+      if (((errno != EWOULDBLOCK) && (errno != EINTR))
+          || (attempts-- <= 0))
+        {
+          return false;
+        }
+
+      nanosleep (&delay, NULL);
+    }
+
+  return true;
+}
+
+void
+recutl_lock_file (char *file_name,
+                  bool exclusive)
+{
+  struct recutl_lock_s *lock;
+  struct stat st1;
+  struct stat st2;
+  int des;
+
+  /* flock is used rather than fcntl locks because the latter are
+     released as soon as the process closes any descriptor for the
+     file, as the parser does.  */
+
+  for (lock = recutl_locks; lock; lock = lock->next)
+    {
+      if (strcmp (lock->file_name, file_name) == 0)
+        {
+          /* Already locked.  */
+          return;
+        }
+    }
+
+  while (true)
+    {
+      des = open (file_name, O_RDONLY);
+      if (des == -1)
+        {
+          /* There is nothing to lock.  */
+          return;
+        }
+
+      if (!recutl_lock_des (des, exclusive))
+        {
+          recutl_fatal (_("cannot lock file %s\n"), file_name);
+        }
+
+      /* Writers replace the file with a new one, so the lock may have
+         been granted on a file which is no longer there.  */
+
+      if ((fstat (des, &st1) == 0)
+          && (stat (file_name, &st2) == 0)
+          && (st1.st_dev == st2.st_dev)
+          && (st1.st_ino == st2.st_ino))
+        {
+          break;
+        }
+
+      close (des);
+    }
+
+  lock = xmalloc (sizeof (struct recutl_lock_s));
+  lock->file_name = xstrdup (file_name);
+  lock->des = des;
+  lock->next = recutl_locks;
+  recutl_locks = lock;
+}
+
+static bool
+recutl_parse_db_and_journal (FILE *in,
+                             char *file_name,
+                             rec_db_t db)
+{
+  rec_rset_t journal;
+  const char *prefilter;
+  bool res;
+
+  /* The entries of the journal may select records by position, so no
+     record can be skipped while parsing the file if there is a
+     journal to replay.  */
+
+  journal = recutl_journal_read (file_name);
+  prefilter = recutl_prefilter;
+  if (journal)
+    {
+      recutl_prefilter = NULL;
+    }
+
+  res = recutl_parse_db_from_file (in, file_name, db);
+  recutl_prefilter = prefilter;
+
+  if (journal)
+    {
+      if (res)
+        {
+          recutl_journal_replay (db, file_name, journal);
+        }
+      rec_rset_destroy (journal);
+    }
+
+  return res;
+}
+
 rec_db_t
 recutl_build_db (int argc, char **argv)
 {
@@ -317,13 +505,14 @@ recutl_build_db (int argc, char **argv)
       while (optind < argc)
         {
           file_name = argv[optind++];
+          recutl_lock_file (file_name, false);
           if (!(in = fopen (file_name, "r")))
             {
               recutl_fatal (_("cannot read file %s\n"), file_name);
             }
           else
             {
-              if (!recutl_parse_db_from_file (in, file_name, db))
+              if (!recutl_parse_db_and_journal (in, file_name, db))
                 {
                   free (db);
                   db = NULL;
@@ -351,25 +540,31 @@ recutl_read_db_from_file (char *file_name)
   rec_db_t db;
   FILE *in;
 
+  bool res;
+
   db = rec_db_new ();
   if (file_name)
     {
+      /* The database is read in order to modify it and write it back,
+         so no other program must access it meanwhile.  */
+
+      recutl_lock_file (file_name, true);
       in = fopen (file_name, "r");
       if (in == NULL)
         {
            return NULL;
         }
+
+      res = recutl_parse_db_and_journal (in, file_name, db);
+      fclose (in);
     }
   else
     {
       /* Process the standard input.  */
-      file_name = "stdin";
-      in = stdin;
+      res = recutl_parse_db_from_file (stdin, "stdin", db);
     }
 
-  if (!recutl_parse_db_from_file (in,
-                                  file_name,
-                                  db))
+  if (!res)
     {
       rec_db_destroy (db);
       db = NULL;
@@ -394,6 +589,9 @@ recutl_write_db_to_file (rec_db_t db,
   int des;
   struct stat st1;
   int stat_result;
+  struct stat src_st;
+  int src_des = -1;
+  char *src_text = MAP_FAILED;
 
   if (!file_name)
     {
@@ -404,6 +602,17 @@ recutl_write_db_to_file (rec_db_t db,
       /* Record the original file attributes. */
       stat_result = stat (file_name, &st1);
 
+      /* Map the original file, so the records that were not modified
+         can be copied from it.  */
+      src_des = open (file_name, O_RDONLY);
+      if ((src_des != -1)
+          && (fstat (src_des, &src_st) == 0)
+          && (src_st.st_size > 0))
+        {
+          src_text = mmap (NULL, src_st.st_size, PROT_READ, MAP_SHARED,
+                           src_des, 0);
+        }
+
       /* Create a temporary file with the results. */
       des = mkstemp (tmp_file_name);
       if (des == -1)
@@ -414,6 +623,10 @@ recutl_write_db_to_file (rec_db_t db,
     }
 
   writer = rec_writer_new (out);
+  if (src_text != MAP_FAILED)
+    {
+      rec_writer_set_source (writer, file_name, src_text, src_st.st_size);
+    }
   rec_write_db (writer, db);
 
   if (file_name)
@@ -421,6 +634,15 @@ recutl_write_db_to_file (rec_db_t db,
       fclose (out);
     }
 
+  if (src_text != MAP_FAILED)
+    {
+      munmap (src_text, src_st.st_size);
+    }
+  if (src_des != -1)
+    {
+      close (src_des);
+    }
+
   rec_db_destroy (db);
 
   if (file_name)
@@ -437,6 +659,246 @@ recutl_write_db_to_file (rec_db_t db,
         {
           chmod (file_name, st1.st_mode);
         }
+
+      /* The changes in the journal, if any, are now in the file.  */
+      recutl_journal_remove (file_name);
+    }
+}
+
+static bool
+recutl_start_record_p (rec_record_t record,
+                       bool first_p,
+                       size_t char_location,
+                       rec_record_t *start)
+{
+  size_t record_location = rec_record_char_location (record);
+
+  /* Records not read from the file have location 0, like the record
+     starting at the very beginning of the file.  Either way, such a
+     record can only be the start record if nothing is written before
+     it.  */
+
+  if (((record_location == 0) && !first_p)
+      || (record_location > char_location))
+    {
+      return false;
+    }
+
+  *start = record;
+  return true;
+}
+
+static rec_record_t
+recutl_start_record (rec_db_t db,
+                     size_t char_location)
+{
+  rec_record_t start = NULL;
+  bool first_p = true;
+  size_t i;
+
+  /* Find the last record or record descriptor in the database,
+     following the order in which they are written, that was read from
+     the file at or before CHAR_LOCATION.  Everything written before
+     it is known to be unchanged.  */
+
+  for (i = 0; i < rec_db_size (db); i++)
+    {
+      rec_rset_t rset = rec_db_get_rset (db, i);
+      rec_record_t descriptor = rec_rset_descriptor (rset);
+      size_t descriptor_pos = rec_rset_descriptor_pos (rset);
+      size_t position = 0;
+      rec_mset_iterator_t iter;
+      rec_mset_elem_t elem;
+      rec_record_t record;
+      bool done = false;
+
+      iter = rec_mset_iterator (rec_rset_mset (rset));
+      while (!done
+             && rec_mset_iterator_next (&iter, MSET_ANY, (const void **) &record, &elem))
+        {
+          if (descriptor && (position == descriptor_pos))
+            {
+              done = !recutl_start_record_p (descriptor, first_p,
+                                             char_location, &start);
+              first_p = false;
+            }
+
+          if (!done && (rec_mset_elem_type (elem) == MSET_RECORD))
+            {
+              done = !recutl_start_record_p (record, first_p,
+                                             char_location, &start);
+            }
+
+          first_p = false;
+          position++;
+        }
+      rec_mset_iterator_free (&iter);
+
+      if (!done && descriptor && (descriptor_pos >= position))
+        {
+          done = !recutl_start_record_p (descriptor, first_p,
+                                         char_location, &start);
+          first_p = false;
+        }
+
+      if (done)
+        {
+          break;
+        }
+    }
+
+  return start;
+}
+
+void
+recutl_update_db_file (rec_db_t db,
+                       char *file_name)
+{
+  size_t char_location;
+  rec_record_t start;
+  rec_writer_t writer;
+  FILE *out;
+  int des;
+  off_t offset;
+
+  if (!file_name)
+    {
+      recutl_write_db_to_file (db, file_name);
+      return;
+    }
+
+  if (!rec_db_modified_p (db, &char_location))
+    {
+      /* The file is already up to date.  */
+      rec_db_destroy (db);
+      return;
+    }
+
+  /* Changes replayed from a journal must be folded into the file
+     atomically, see recutl_journal_read.  */
+
+  start = NULL;
+  if (!recutl_journal_p (file_name))
+    {
+      start = recutl_start_record (db, char_location);
+    }
+
+  if (!start)
+    {
+      recutl_write_db_to_file (db, file_name);
+      return;
+    }
+
+  /* Character locations are 1-based, except for the very first
+     character in the file.  */
+
+  offset = rec_record_char_location (start);
+  if (offset > 0)
+    {
+      offset--;
+    }
+
+  des = open (file_name, O_WRONLY);
+  if ((des == -1)
+      || (lseek (des, offset, SEEK_SET) == -1)
+      || !(out = fdopen (des, "w")))
+    {
+      recutl_fatal (_("cannot write to file %s\n"), file_name);
+    }
+
+  writer = rec_writer_new (out);
+  if (!writer)
+    {
+      recutl_out_of_memory ();
+    }
+  rec_writer_set_start_record (writer, start);
+  rec_write_db (writer, db);
+  rec_writer_destroy (writer);
+
+  if ((fflush (out) == EOF)
+      || (ftruncate (des, ftello (out)) == -1)
+      || (fclose (out) == EOF))
+    {
+      recutl_fatal (_("cannot write to file %s\n"), file_name);
+    }
+
+  rec_db_destroy (db);
+}
+
+void
+recutl_append_record_to_file (rec_record_t record,
+                              char *file_name)
+{
+  int des;
+  struct stat st;
+  char tail[2];
+  char *str;
+  size_t str_size;
+  size_t written;
+  ssize_t res;
+  rec_writer_t writer;
+
+  des = open (file_name, O_RDWR | O_APPEND);
+  if ((des == -1) || (fstat (des, &st) == -1))
+    {
+      recutl_fatal (_("cannot open file %s\n"), file_name);
+    }
+
+  /* Write the record in a buffer, preceded by as many newlines as
+     needed to separate it from the last record in the file with an
+     empty line.  The buffer is then appended with a single write so
+     the file is never left with a partial separator.  */
+
+  writer = rec_writer_new_str (&str, &str_size);
+  if (!writer)
+    {
+      recutl_out_of_memory ();
+    }
+
+  if (st.st_size > 0)
+    {
+      if (pread (des, tail, 1, st.st_size - 1) != 1)
+        {
+          recutl_fatal (_("cannot read file %s\n"), file_name);
+        }
+
+      if (tail[0] != '\n')
+        {
+          rec_write_string (writer, "\n\n");
+        }
+      else if ((st.st_size == 1)
+               || (pread (des, tail, 2, st.st_size - 2) != 2)
+               || (tail[0] != '\n'))
+        {
+          rec_write_string (writer, "\n");
+        }
+    }
+
+  if (!rec_write_record (writer, record)
+      || !rec_write_string (writer, "\n"))
+    {
+      recutl_out_of_memory ();
+    }
+  rec_writer_destroy (writer);
+
+  written = 0;
+  while (written < str_size)
+    {
+      res = write (des, str + written, str_size - written);
+      if (res == -1)
+        {
+          if (errno == EINTR)
+            continue;
+
+          recutl_fatal (_("cannot write to file %s\n"), file_name);
+        }
+      written += res;
+    }
+
+  free (str);
+  if (close (des) == -1)
+    {
+      recutl_fatal (_("cannot write to file %s\n"), file_name);
     }
 }
 
@@ -458,19 +920,15 @@ recutl_read_file (char *file_name)
   return result;
 }
 
-void
-recutl_check_integrity (rec_db_t db,
-                        bool verbose_p,
-                        bool external_p)
+static void
+recutl_report_integrity (int num_errors,
+                         rec_buf_t errors_buf,
+                         char **errors_str,
+                         bool verbose_p)
 {
-  rec_buf_t errors_buf;
-  char *errors_str;
-  size_t errors_str_size;
-
-  errors_buf = rec_buf_new (&errors_str, &errors_str_size);
-  if (rec_int_check_db (db, true, external_p, errors_buf) > 0)
+  rec_buf_close (errors_buf);
+  if (num_errors > 0)
     {
-      rec_buf_close (errors_buf);
       if (!verbose_p)
         {
           recutl_error (_("operation aborted due to integrity failures.\n"));
@@ -478,11 +936,60 @@ recutl_check_integrity (rec_db_t db,
         }
       else
         {
-          fprintf (stderr, "%s", errors_str);
+          fprintf (stderr, "%s", *errors_str);
         }
 
       recutl_fatal (_("use --force to skip the integrity check.\n"));
     }
+
+  free (*errors_str);
+}
+
+void
+recutl_check_integrity (rec_db_t db,
+                        bool verbose_p,
+                        bool external_p)
+{
+  rec_buf_t errors_buf;
+  char *errors_str;
+  size_t errors_str_size;
+
+  errors_buf = rec_buf_new (&errors_str, &errors_str_size);
+  recutl_report_integrity (rec_int_check_db (db, true, external_p, errors_buf),
+                           errors_buf, &errors_str, verbose_p);
+}
+
+void
+recutl_check_integrity_incremental (rec_db_t db,
+                                    bool verbose_p,
+                                    bool external_p)
+{
+  rec_buf_t errors_buf;
+  char *errors_str;
+  size_t errors_str_size;
+
+  errors_buf = rec_buf_new (&errors_str, &errors_str_size);
+  recutl_report_integrity (rec_int_check_db_incremental (db, true, external_p,
+                                                         errors_buf),
+                           errors_buf, &errors_str, verbose_p);
+}
+
+void
+recutl_check_integrity_append (rec_db_t db,
+                               rec_rset_t rset,
+                               rec_record_t record,
+                               bool verbose_p,
+                               bool external_p)
+{
+  rec_buf_t errors_buf;
+  char *errors_str;
+  size_t errors_str_size;
+
+  errors_buf = rec_buf_new (&errors_str, &errors_str_size);
+  recutl_report_integrity (rec_int_check_rset_append (db, rset, record,
+                                                      true, external_p,
+                                                      errors_buf),
+                           errors_buf, &errors_str, verbose_p);
 }
 
 bool
@@ -645,4 +1152,679 @@ recutl_getpass (bool asktwice)
   return ret;
 }
 
+/*
+ * Journals.
+ *
+ * A journal is a rec file, named after the journaled file with a
+ * ".journal" suffix, containing a header record followed by one
+ * record per journaled operation.  The header holds a stamp with the
+ * device, inode, size and modification time of the journaled file.
+ * A journal whose stamp doesn't match the file is stale and ignored:
+ * this happens when the file is rewritten by recutl_write_db_to_file,
+ * whose rename always changes the inode, and then the program is
+ * interrupted before removing the journal.
+ */
+
+#define RECUTL_JOURNAL_SUFFIX ".journal"
+
+static char *
+recutl_journal_file_name (const char *file_name)
+{
+  char *journal_file_name;
+
+  journal_file_name = xmalloc (strlen (file_name)
+                               + strlen (RECUTL_JOURNAL_SUFFIX) + 1);
+  strcpy (journal_file_name, file_name);
+  strcat (journal_file_name, RECUTL_JOURNAL_SUFFIX);
+
+  return journal_file_name;
+}
+
+static char *
+recutl_journal_stamp (const char *file_name)
+{
+  struct stat st;
+  char *stamp;
+
+  if (stat (file_name, &st) == -1)
+    {
+      return NULL;
+    }
+
+  if (asprintf (&stamp, "%ju:%ju:%jd:%jd",
+                (uintmax_t) st.st_dev,
+                (uintmax_t) st.st_ino,
+                (intmax_t) st.st_size,
+                (intmax_t) st.st_mtime) == -1)
+    {
+      recutl_out_of_memory ();
+    }
+
+  return stamp;
+}
+
+static const char *
+recutl_journal_value (rec_record_t entry,
+                      const char *field_name)
+{
+  rec_field_t field = rec_record_get_field_by_name (entry, field_name, 0);
+  return field ? rec_field_value (field) : NULL;
+}
+
+static void
+recutl_journal_add_value (rec_record_t entry,
+                          const char *field_name,
+                          const char *value)
+{
+  rec_field_t field;
+
+  if (value)
+    {
+      field = rec_field_new (field_name, value);
+      if (!field
+          || !rec_mset_append (rec_record_mset (entry), MSET_FIELD,
+                               (void *) field, MSET_ANY))
+        {
+          recutl_out_of_memory ();
+        }
+    }
+}
+
+static rec_rset_t
+recutl_journal_read (const char *file_name)
+{
+  rec_rset_t journal = NULL;
+  rec_parser_t parser;
+  rec_record_t header;
+  char *journal_file_name;
+  const char *journal_stamp;
+  char *stamp;
+  FILE *in;
+
+  /* Return the records stored in the journal of FILE_NAME, the first
+     one being the header, or NULL if there is no journal or it is
+     stale.  */
+
+  journal_file_name = recutl_journal_file_name (file_name);
+  in = fopen (journal_file_name, "r");
+  if (in)
+    {
+      parser = rec_parser_new (in, journal_file_name);
+      if (!parser)
+        {
+          recutl_out_of_memory ();
+        }
+
+      if (!rec_parse_rset (parser, &journal)
+          || rec_parser_error (parser))
+        {
+          rec_parser_perror (parser, "%s", journal_file_name);
+          recutl_fatal (_("invalid journal %s\n"), journal_file_name);
+        }
+      rec_parser_destroy (parser);
+      fclose (in);
+
+      header = rec_mset_get_at (rec_rset_mset (journal), MSET_RECORD, 0);
+      journal_stamp = header ? recutl_journal_value (header, "Stamp") : NULL;
+      stamp = recutl_journal_stamp (file_name);
+      if (!journal_stamp || !stamp || (strcmp (journal_stamp, stamp) != 0))
+        {
+          rec_rset_destroy (journal);
+          journal = NULL;
+        }
+      free (stamp);
+    }
+
+  free (journal_file_name);
+  return journal;
+}
+
+static size_t *
+recutl_journal_parse_index (const char *str)
+{
+  size_t *index;
+  size_t num_entries;
+  size_t i;
+  const char *p;
+  char *end;
+
+  /* Parse a list of indexes written by recutl_journal_index_str.  The
+     result is terminated like the lists parsed by
+     recutl_index_list_parse.  */
+
+  num_entries = 1;
+  for (p = str; *p; p++)
+    {
+      if (*p == ',')
+        {
+          num_entries++;
+        }
+    }
+
+  index = xmalloc (sizeof (size_t) * (num_entries * 2 + 2));
+  for (i = 0; i < (num_entries * 2 + 2); i++)
+    {
+      index[i] = REC_Q_NOINDEX;
+    }
+
+  p = str;
+  for (i = 0; i < num_entries; i++)
+    {
+      index[i * 2] = strtoul (p, &end, 10);
+      if (end == p)
+        {
+          free (index);
+          return NULL;
+        }
+      p = end;
+
+      if (*p == '-')
+        {
+          p++;
+          index[i * 2 + 1] = strtoul (p, &end, 10);
+          if (end == p)
+            {
+              free (index);
+              return NULL;
+            }
+          p = end;
+        }
+
+      if (*p == ',')
+        {
+          p++;
+        }
+      else if (*p != '\0')
+        {
+          free (index);
+          return NULL;
+        }
+    }
+
+  return index;
+}
+
+static char *
+recutl_journal_index_str (size_t *index)
+{
+  char *str;
+  size_t str_size;
+  char entry[64];
+  rec_buf_t buf;
+  size_t i;
+
+  buf = rec_buf_new (&str, &str_size);
+  if (!buf)
+    {
+      recutl_out_of_memory ();
+    }
+
+  for (i = 0; index[i] != REC_Q_NOINDEX; i = i + 2)
+    {
+      if (index[i + 1] == REC_Q_NOINDEX)
+        {
+          sprintf (entry, "%s%zu", i == 0 ? "" : ",", index[i]);
+        }
+      else
+        {
+          sprintf (entry, "%s%zu-%zu", i == 0 ? "" : ",",
+                   index[i], index[i + 1]);
+        }
+      rec_buf_puts (entry, buf);
+    }
+
+  rec_buf_close (buf);
+  return str;
+}
+
+static const char *recutl_journal_actions[] =
+  {
+    NULL,             /* REC_SET_ACT_NONE */
+    "rename",         /* REC_SET_ACT_RENAME */
+    "set",            /* REC_SET_ACT_SET */
+    "add",            /* REC_SET_ACT_ADD */
+    "set-add",        /* REC_SET_ACT_SETADD */
+    "delete",         /* REC_SET_ACT_DELETE */
+    "comment"         /* REC_SET_ACT_COMMENT */
+  };
+
+static bool
+recutl_apply_operation (rec_db_t db,
+                        rec_record_t entry,
+                        bool auto_p)
+{
+  const char *operation = recutl_journal_value (entry, "Operation");
+  const char *type = recutl_journal_value (entry, "Type");
+  const char *index_str = recutl_journal_value (entry, "Index");
+  const char *sex_str = recutl_journal_value (entry, "Expression");
+  const char *quick_str = recutl_journal_value (entry, "Quick");
+  const char *insensitive = recutl_journal_value (entry, "CaseInsensitive");
+  size_t *index = NULL;
+  rec_sex_t sex = NULL;
+  int flags = 0;
+  bool res = false;
+
+  if (!operation)
+    {
+      return false;
+    }
+
+  if (insensitive && (strcmp (insensitive, "yes") == 0))
+    {
+      flags = flags | REC_F_ICASE;
+    }
+
+  if (index_str && !(index = recutl_journal_parse_index (index_str)))
+    {
+      return false;
+    }
+
+  if (sex_str)
+    {
+      sex = rec_sex_new (flags & REC_F_ICASE);
+      if (!sex)
+        {
+          recutl_out_of_memory ();
+        }
+
+      if (!rec_sex_compile (sex, sex_str))
+        {
+          rec_sex_destroy (sex);
+          free (index);
+          return false;
+        }
+    }
+
+  if (strcmp (operation, "insert") == 0)
+    {
+      const char *record_str = recutl_journal_value (entry, "Record");
+      rec_record_t record = record_str ? rec_parse_record_str (record_str) : NULL;
+
+      res = record
+        && rec_db_insert (db, type, index, sex, quick_str, 0, NULL,
+                          record, auto_p ? flags : (flags | REC_F_NOAUTO));
+
+      if (record && (index || sex || quick_str))
+        {
+          /* The selected records were replaced by copies of
+             RECORD.  */
+          rec_record_destroy (record);
+        }
+    }
+  else if (strcmp (operation, "set") == 0)
+    {
+      const char *fex_str = recutl_journal_value (entry, "Fields");
+      const char *action_str = recutl_journal_value (entry, "Action");
+      rec_fex_t fex = NULL;
+      int action;
+
+      for (action = REC_SET_ACT_RENAME; action <= REC_SET_ACT_COMMENT; action++)
+        {
+          if (action_str
+              && (strcmp (action_str, recutl_journal_actions[action]) == 0))
+            {
+              break;
+            }
+        }
+
+      if (fex_str
+          && (action <= REC_SET_ACT_COMMENT)
+          && rec_fex_check (fex_str, REC_FEX_SUBSCRIPTS)
+          && (fex = rec_fex_new (fex_str, REC_FEX_SUBSCRIPTS)))
+        {
+          rec_fex_sort (fex);
+          res = rec_db_set (db, type, index, sex, quick_str, 0, fex,
+                            action, recutl_journal_value (entry, "Value"),
+                            flags);
+          rec_fex_destroy (fex);
+        }
+    }
+  else if (strcmp (operation, "delete") == 0)
+    {
+      const char *comment = recutl_journal_value (entry, "Comment");
+
+      if (comment && (strcmp (comment, "yes") == 0))
+        {
+          flags = flags | REC_F_COMMENT_OUT;
+        }
+
+      res = rec_db_delete (db, type, index, sex, quick_str, 0, flags);
+    }
+
+  if (sex)
+    {
+      rec_sex_destroy (sex);
+    }
+  free (index);
+
+  return res;
+}
+
+static void
+recutl_journal_replay (rec_db_t db,
+                       const char *file_name,
+                       rec_rset_t journal)
+{
+  rec_mset_iterator_t iter;
+  rec_record_t entry;
+  bool header_p = true;
+
+  iter = rec_mset_iterator (rec_rset_mset (journal));
+  while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &entry, NULL))
+    {
+      if (header_p)
+        {
+          header_p = false;
+          continue;
+        }
+
+      /* Auto-generated fields were added, and confidential fields
+         encrypted, before journaling the inserted records.  */
+
+      if (!recutl_apply_operation (db, entry, false))
+        {
+          recutl_fatal (_("%s:%s: invalid journal entry\n"),
+                        rec_record_source (entry),
+                        rec_record_location_str (entry));
+        }
+    }
+  rec_mset_iterator_free (&iter);
+}
+
+static void
+recutl_journal_remove (const char *file_name)
+{
+  char *journal_file_name = recutl_journal_file_name (file_name);
+
+  if ((unlink (journal_file_name) == -1) && (errno != ENOENT))
+    {
+      recutl_warning (_("cannot remove journal %s\n"), journal_file_name);
+    }
+  free (journal_file_name);
+}
+
+static rec_record_t
+recutl_journal_entry_new (const char *operation,
+                          const char *type,
+                          size_t *index,
+                          const char *sex_str,
+                          const char *quick_str,
+                          bool insensitive)
+{
+  rec_record_t entry;
+
+  entry = rec_record_new ();
+  if (!entry)
+    {
+      recutl_out_of_memory ();
+    }
+
+  recutl_journal_add_value (entry, "Operation", operation);
+  recutl_journal_add_value (entry, "Type", type);
+  if (index)
+    {
+      char *index_str = recutl_journal_index_str (index);
+      recutl_journal_add_value (entry, "Index", index_str);
+      free (index_str);
+    }
+  recutl_journal_add_value (entry, "Expression", sex_str);
+  recutl_journal_add_value (entry, "Quick", quick_str);
+  if (insensitive)
+    {
+      recutl_journal_add_value (entry, "CaseInsensitive", "yes");
+    }
+
+  return entry;
+}
+
+static bool
+recutl_journal_append (const char *file_name,
+                       rec_record_t entry)
+{
+  rec_rset_t journal;
+  rec_record_t header;
+  rec_writer_t writer;
+  char *journal_file_name;
+  char *stamp;
+  char *str;
+  size_t str_size;
+  size_t written;
+  ssize_t res;
+  struct stat st;
+  int des;
+
+  if (!file_name || (stat (file_name, &st) == -1))
+    {
+      /* There is no file to journal.  */
+      rec_record_destroy (entry);
+      return false;
+    }
+
+  writer = rec_writer_new_str (&str, &str_size);
+  if (!writer)
+    {
+      recutl_out_of_memory ();
+    }
+
+  journal_file_name = recutl_journal_file_name (file_name);
+  journal = recutl_journal_read (file_name);
+  if (journal)
+    {
+      rec_rset_destroy (journal);
+      des = open (journal_file_name, O_WRONLY | O_APPEND);
+      rec_write_string (writer, "\n");
+    }
+  else
+    {
+      /* Start a new journal, replacing any stale one.  */
+
+      des = open (journal_file_name, O_WRONLY | O_CREAT | O_TRUNC,
+                  st.st_mode & 0777);
+
+      stamp = recutl_journal_stamp (file_name);
+      header = rec_record_new ();
+      if (!stamp || !header)
+        {
+          recutl_out_of_memory ();
+        }
+      recutl_journal_add_value (header, "Journal", file_name);
+      recutl_journal_add_value (header, "Stamp", stamp);
+      rec_write_record (writer, header);
+      rec_write_string (writer, "\n\n");
+      rec_record_destroy (header);
+      free (stamp);
+    }
+
+  if (des == -1)
+    {
+      recutl_fatal (_("cannot write to file %s\n"), journal_file_name);
+    }
+
+  if (!rec_write_record (writer, entry)
+      || !rec_write_string (writer, "\n"))
+    {
+      recutl_out_of_memory ();
+    }
+  rec_writer_destroy (writer);
+  rec_record_destroy (entry);
+
+  /* The entry is written with a single write, and synced to disk
+     before returning.  */
+
+  written = 0;
+  while (written < str_size)
+    {
+      res = write (des, str + written, str_size - written);
+      if (res == -1)
+        {
+          if (errno == EINTR)
+            continue;
+
+          recutl_fatal (_("cannot write to file %s\n"), journal_file_name);
+        }
+      written += res;
+    }
+
+  if ((fsync (des) == -1) || (close (des) == -1))
+    {
+      recutl_fatal (_("cannot write to file %s\n"), journal_file_name);
+    }
+
+  free (str);
+  free (journal_file_name);
+  return true;
+}
+
+void
+recutl_apply_batch (rec_db_t db,
+                    char *file_name)
+{
+  rec_parser_t parser;
+  rec_rset_t batch = NULL;
+  rec_mset_iterator_t iter;
+  rec_record_t operation;
+  FILE *in;
+
+  if (strcmp (file_name, "-") == 0)
+    {
+      in = stdin;
+      file_name = "stdin";
+    }
+  else if (!(in = fopen (file_name, "r")))
+    {
+      recutl_fatal (_("cannot read file %s\n"), file_name);
+    }
+
+  parser = rec_parser_new (in, file_name);
+  if (!parser)
+    {
+      recutl_out_of_memory ();
+    }
+
+  if (!rec_parse_rset (parser, &batch)
+      && rec_parser_error (parser))
+    {
+      rec_parser_perror (parser, "%s", file_name);
+      recutl_fatal (_("invalid batch file %s\n"), file_name);
+    }
+  rec_parser_destroy (parser);
+
+  if (in != stdin)
+    {
+      fclose (in);
+    }
+
+  if (!batch)
+    {
+      /* There are no operations.  */
+      return;
+    }
+
+  iter = rec_mset_iterator (rec_rset_mset (batch));
+  while (rec_mset_iterator_next (&iter, MSET_RECORD, (const void **) &operation, NULL))
+    {
+      if (!recutl_apply_operation (db, operation, true))
+        {
+          recutl_fatal (_("%s:%s: invalid operation\n"),
+                        rec_record_source (operation),
+                        rec_record_location_str (operation));
+        }
+    }
+  rec_mset_iterator_free (&iter);
+
+  rec_rset_destroy (batch);
+}
+
+bool
+recutl_journal_p (char *file_name)
+{
+  rec_rset_t journal;
+
+  if (!file_name)
+    {
+      return false;
+    }
+
+  journal = recutl_journal_read (file_name);
+  if (journal)
+    {
+      rec_rset_destroy (journal);
+      return true;
+    }
+
+  return false;
+}
+
+bool
+recutl_journal_insert (char *file_name,
+                       const char *type,
+                       size_t *index,
+                       const char *sex_str,
+                       const char *quick_str,
+                       bool insensitive,
+                       rec_record_t record)
+{
+  rec_record_t entry;
+  char *record_str;
+  size_t record_str_size;
+  rec_writer_t writer;
+
+  entry = recutl_journal_entry_new ("insert", type, index,
+                                    sex_str, quick_str, insensitive);
+
+  writer = rec_writer_new_str (&record_str, &record_str_size);
+  if (!writer || !rec_write_record (writer, record))
+    {
+      recutl_out_of_memory ();
+    }
+  rec_writer_destroy (writer);
+  recutl_journal_add_value (entry, "Record", record_str);
+  free (record_str);
+
+  return recutl_journal_append (file_name, entry);
+}
+
+bool
+recutl_journal_set (char *file_name,
+                    const char *type,
+                    size_t *index,
+                    const char *sex_str,
+                    const char *quick_str,
+                    bool insensitive,
+                    const char *fex_str,
+                    int action,
+                    const char *action_arg)
+{
+  rec_record_t entry;
+
+  entry = recutl_journal_entry_new ("set", type, index,
+                                    sex_str, quick_str, insensitive);
+  recutl_journal_add_value (entry, "Fields", fex_str);
+  recutl_journal_add_value (entry, "Action", recutl_journal_actions[action]);
+  recutl_journal_add_value (entry, "Value", action_arg);
+
+  return recutl_journal_append (file_name, entry);
+}
+
+bool
+recutl_journal_delete (char *file_name,
+                       const char *type,
+                       size_t *index,
+                       const char *sex_str,
+                       const char *quick_str,
+                       bool insensitive,
+                       bool comment_p)
+{
+  rec_record_t entry;
+
+  entry = recutl_journal_entry_new ("delete", type, index,
+                                    sex_str, quick_str, insensitive);
+  if (comment_p)
+    {
+      recutl_journal_add_value (entry, "Comment", "yes");
+    }
+
+  return recutl_journal_append (file_name, entry);
+}
+
 /* End of recutl.c */
@@ -26,6 +26,7 @@
 #ifndef RECUTL_H
 #define RECUTL_H
 
+#include <limits.h>
 #include <progname.h>
 
 /*
@@ -200,6 +201,31 @@
           break;                                               \
       }
 
+/*
+ * Locking arguments.
+ */
+
+#define LOCKING_ARGS                            \
+  LOCK_TIMEOUT_ARG
+
+#define LOCKING_LONG_ARGS                                       \
+  {"lock-timeout", required_argument, NULL, LOCK_TIMEOUT_ARG}
+
+#define LOCKING_ARGS_CASES                                     \
+    case LOCK_TIMEOUT_ARG:                                     \
+      {                                                        \
+        char *end;                                             \
+        long int li = strtol (optarg, &end, 10);               \
+        if ((*optarg == '\0') || (*end != '\0')                \
+            || (li < 0) || (li > INT_MAX))                     \
+          {                                                    \
+            recutl_fatal (_("invalid number in --lock-timeout\n")); \
+          }                                                    \
+                                                               \
+        recutl_set_lock_timeout (li);                          \
+        break;                                                 \
+      }
+
 #if defined REC_CRYPT_SUPPORT
 #  define ENCRYPTION_SHORT_ARGS "s:"
 #else
@@ -215,6 +241,7 @@ void recutl_print_version (void);
 void recutl_print_help_common (void);
 void recutl_print_help_footer (void);
 void recutl_print_help_record_selection (void);
+void recutl_print_help_locking (void);
 
 
 void recutl_error (const char *fmt, ...);
@@ -225,9 +252,40 @@ void recutl_out_of_memory (void);
 bool recutl_parse_db_from_file (FILE *in, char *file_name, rec_db_t db);
 rec_db_t recutl_build_db (int argc, char **argv);
 
+/* Set the string that the records read by recutl_parse_db_from_file
+   and recutl_build_db must contain.  Records not containing it may be
+   skipped while parsing.  See rec_parser_set_prefilter.  */
+
+void recutl_set_prefilter (const char *str, bool case_insensitive);
+
+/* Lock FILE_NAME for reading, or for writing if EXCLUSIVE is true,
+   until the program exits.  Wait for other programs holding
+   conflicting locks to release them, for at most the number of
+   seconds set with recutl_set_lock_timeout, or for as long as needed
+   if it is negative.  recutl_build_db locks the files it reads for
+   reading, and recutl_read_db_from_file locks its file for writing.  */
+
+void recutl_lock_file (char *file_name, bool exclusive);
+void recutl_set_lock_timeout (int seconds);
+
 rec_db_t recutl_read_db_from_file (char *file_name);
 void recutl_write_db_to_file (rec_db_t db, char *file_name);
 
+/* Like recutl_write_db_to_file, but if the database was read from
+   FILE_NAME and then modified using rec_db_insert, rec_db_delete or
+   rec_db_set, only write from the first record affected by the
+   modifications onwards, truncating the rest of the file.  The file
+   is updated in place, so it is left inconsistent if the operation
+   is interrupted.  */
+
+void recutl_update_db_file (rec_db_t db, char *file_name);
+
+/* Append the written representation of RECORD to the end of the
+   given file, separated from its current contents by a blank line.
+   The rest of the file is not rewritten.  */
+
+void recutl_append_record_to_file (rec_record_t record, char *file_name);
+
 bool recutl_file_is_writable (char *file_name);
 
 char *recutl_read_file (char *file_name);
@@ -236,6 +294,62 @@ void recutl_check_integrity (rec_db_t db,
                              bool verbose_p,
                              bool external_p);
 
+/* Like recutl_check_integrity, but only check the parts of the
+   database that were modified since it was read.  See
+   rec_int_check_db_incremental.  */
+
+void recutl_check_integrity_incremental (rec_db_t db,
+                                         bool verbose_p,
+                                         bool external_p);
+
+/* Like recutl_check_integrity, but assume that the only change in
+   the database since it was read is the addition of RECORD at the end
+   of RSET.  See rec_int_check_rset_append.  */
+
+void recutl_check_integrity_append (rec_db_t db,
+                                    rec_rset_t rset,
+                                    rec_record_t record,
+                                    bool verbose_p,
+                                    bool external_p);
+
+/* Journals.  Instead of rewriting a rec file, the insertions,
+   modifications and deletions performed on it can be appended to its
+   journal, a file named after it with a ".journal" suffix.  The
+   journal of a file is replayed whenever the file is read by
+   recutl_build_db or recutl_read_db_from_file, and it is removed
+   whenever the file is written by recutl_write_db_to_file.
+
+   recutl_journal_p determines whether FILE_NAME has an up to date
+   journal.  The other functions append an entry to the journal of
+   FILE_NAME with the arguments passed to rec_db_insert, rec_db_set
+   or rec_db_delete, which must not select random records.  RECORD
+   must already contain its auto-generated fields, since they are not
+   generated again when replaying the journal.  These functions
+   return false if FILE_NAME doesn't exist, in which case the database
+   should be written instead.  */
+
+bool recutl_journal_p (char *file_name);
+bool recutl_journal_insert (char *file_name, const char *type,
+                            size_t *index, const char *sex_str,
+                            const char *quick_str, bool insensitive,
+                            rec_record_t record);
+bool recutl_journal_set (char *file_name, const char *type,
+                         size_t *index, const char *sex_str,
+                         const char *quick_str, bool insensitive,
+                         const char *fex_str, int action,
+                         const char *action_arg);
+bool recutl_journal_delete (char *file_name, const char *type,
+                            size_t *index, const char *sex_str,
+                            const char *quick_str, bool insensitive,
+                            bool comment_p);
+
+/* Apply to DB the operations read from FILE_NAME, or from the
+   standard input if it is "-".  The operations are records in the
+   format used by the entries of journals, described in the
+   documentation of recset --batch.  */
+
+void recutl_apply_batch (rec_db_t db, char *file_name);
+
 bool recutl_yesno (char *prompt);
 
 bool recutl_interactive (void);